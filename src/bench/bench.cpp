@@ -0,0 +1,268 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "bench.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <malloc.h>
+
+using namespace vio;
+
+// Every allocation of the program goes through here, so the benchmarks can count them and measure the heap.
+// The resident memory is not used: its peak cannot be reset on Windows, so it would not be the one of a workload.
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> liveBytes(0);
+static std::atomic<uint64_t> liveBytesPeak(0);
+
+static size_t blockSize(void * p){
+#ifdef WIN32
+	return _msize(p);
+#else
+	return malloc_usable_size(p);
+#endif
+}
+
+void * operator new(size_t size){
+	allocationCount.fetch_add(1,std::memory_order_relaxed);
+	void * p = malloc(size == 0 ? 1 : size);
+	if(p == 0) throw std::bad_alloc();
+	const uint64_t s = blockSize(p);
+	const uint64_t live = liveBytes.fetch_add(s,std::memory_order_relaxed) + s;
+	uint64_t peak = liveBytesPeak.load(std::memory_order_relaxed);
+	while(live > peak && !liveBytesPeak.compare_exchange_weak(peak,live,std::memory_order_relaxed)){}
+	return p;
+}
+void operator delete(void * p) noexcept{
+	if(p == 0) return;
+	liveBytes.fetch_sub(blockSize(p),std::memory_order_relaxed);
+	free(p);
+}
+void operator delete(void * p,size_t size) noexcept{
+	operator delete(p);
+}
+
+namespace vio {
+
+	double BenchResult::gflops() const{
+		return nanoseconds > 0 ? flops / nanoseconds : 0;
+	}
+	double BenchResult::gbs() const{
+		return nanoseconds > 0 ? bytes / nanoseconds : 0;
+	}
+
+	bool BenchOptions::selected(const std::string& name) const{
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	uint64_t heapAllocations(){
+		return allocationCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t heapBytes(){
+		return liveBytes.load(std::memory_order_relaxed);
+	}
+	uint64_t peakHeapBytes(){
+		return liveBytesPeak.load(std::memory_order_relaxed);
+	}
+	void resetPeakHeapBytes(){
+		liveBytesPeak.store(liveBytes.load(std::memory_order_relaxed),std::memory_order_relaxed);
+	}
+
+	BenchResult measure(const BenchOptions& options,const std::string& name,const std::string& shape,
+		double flops,double bytes,const std::function<void()>& fn){
+		typedef std::chrono::steady_clock clock;
+		// calibrate a batch size so that a batch is long enough to be measured precisely (~1/20 of the time).
+		const uint64_t allocationsBefore = heapAllocations();
+		uint64_t calls = 0;
+		u32 batch = 1;
+		while(true){
+			auto start = clock::now();
+			for(u32 i = 0;i < batch;i++) fn();
+			calls += batch;
+			double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+			if(elapsed >= options.minTime / 20 || batch >= (1u << 30)) break;
+			batch *= 2;
+		}
+
+		double best = 1e300;
+		auto begin = clock::now();
+		do{
+			auto start = clock::now();
+			for(u32 i = 0;i < batch;i++) fn();
+			calls += batch;
+			double ns = std::chrono::duration<double,std::nano>(clock::now() - start).count() / batch;
+			if(ns < best) best = ns;
+		}while(std::chrono::duration<double>(clock::now() - begin).count() < options.minTime);
+
+		BenchResult r;
+		r.name = name;
+		r.shape = shape;
+		r.nanoseconds = best;
+		r.flops = flops;
+		r.bytes = bytes;
+		r.allocations = (double)(heapAllocations() - allocationsBefore) / calls;
+		return r;
+	}
+
+	std::string benchToJson(const std::vector<BenchResult>& results){
+		std::string r = "{\"results\":[\n";
+		char line[512];
+		for(u32 i = 0;i < results.size();i++){
+			const BenchResult& b = results[i];
+			snprintf(line,sizeof(line),"{\"suite\":\"%s\",\"name\":\"%s\",\"shape\":\"%s\",\"ns\":%.6g,\"flops\":%.6g,\"bytes\":%.6g,"
+				"\"gflops\":%.6g,\"gbs\":%.6g,\"allocations\":%.6g,\"peakHeap\":%.6g}%s\n",
+				b.suite.c_str(),b.name.c_str(),b.shape.c_str(),b.nanoseconds,b.flops,b.bytes,b.gflops(),b.gbs(),b.allocations,b.peakHeap,
+				i + 1 < results.size() ? "," : "");
+			r += line;
+		}
+		r += "]}\n";
+		return r;
+	}
+
+	// Reads the objects of benchToJson. The values never contain quotes, commas or braces.
+	bool benchFromJson(const std::string& json,std::vector<BenchResult>& results){
+		size_t pos = json.find("\"results\"");
+		if(pos == std::string::npos) return false;
+		while((pos = json.find('{',pos)) != std::string::npos){
+			size_t end = json.find('}',pos);
+			if(end == std::string::npos) return false;
+			BenchResult b;
+			std::string object = json.substr(pos + 1,end - pos - 1);
+			std::stringstream fields(object);
+			std::string field;
+			while(std::getline(fields,field,',')){
+				size_t colon = field.find(':');
+				if(colon == std::string::npos) return false;
+				std::string key = field.substr(0,colon);
+				std::string value = field.substr(colon + 1);
+				auto unquote = [](const std::string& s){
+					size_t a = s.find('"'),b = s.rfind('"');
+					return a == std::string::npos || a == b ? s : s.substr(a + 1,b - a - 1);
+				};
+				key = unquote(key);
+				if(key == "suite") b.suite = unquote(value);
+				else if(key == "name") b.name = unquote(value);
+				else if(key == "shape") b.shape = unquote(value);
+				else if(key == "ns") b.nanoseconds = atof(value.c_str());
+				else if(key == "flops") b.flops = atof(value.c_str());
+				else if(key == "bytes") b.bytes = atof(value.c_str());
+				else if(key == "allocations") b.allocations = atof(value.c_str());
+				else if(key == "peakHeap") b.peakHeap = atof(value.c_str());
+			}
+			results.push_back(b);
+			pos = end + 1;
+		}
+		return true;
+	}
+
+	u32 benchCompare(const std::vector<BenchResult>& baseline,const std::vector<BenchResult>& results,double tolerance){
+		u32 regressions = 0;
+		u32 compared = 0;
+		for(const BenchResult& r : results){
+			for(const BenchResult& b : baseline){
+				if(b.suite != r.suite || b.name != r.name || b.shape != r.shape) continue;
+				compared++;
+				const double change = b.nanoseconds > 0 ? r.nanoseconds / b.nanoseconds - 1 : 0;
+				if(change > tolerance){
+					printf("REGRESSION %-10s %-24s %-16s %12.1f ns -> %12.1f ns (%+.1f%%)\n",
+						r.suite.c_str(),r.name.c_str(),r.shape.c_str(),b.nanoseconds,r.nanoseconds,change * 100);
+					regressions++;
+				}
+				break;
+			}
+		}
+		printf("%u benchmarks compared with the baseline, %u regressions (tolerance %.0f%%)\n",compared,regressions,tolerance * 100);
+		return regressions;
+	}
+
+} /* namespace vio */
+
+static void usage(){
+	printf("usage: bench [--suite name] [--filter text] [--time seconds] [--threads n] [--json out.json] [--compare baseline.json] [--tolerance 0.1]\n");
+	printf("suites: kernels, training, bigint\n");
+}
+
+int main(int argc,char ** argv){
+	struct{ const char * name; BenchSuite run; } suites[] = {
+		{"kernels",benchKernels},
+		{"training",benchTraining},
+		{"bigint",benchBigint}
+	};
+
+	BenchOptions options;
+	std::string suiteName,jsonPath,comparePath;
+	double tolerance = 0.1;
+	for(int i = 1;i < argc;i++){
+		std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if(arg == "--suite" && hasValue) suiteName = argv[++i];
+		else if(arg == "--filter" && hasValue) options.filter = argv[++i];
+		else if(arg == "--time" && hasValue) options.minTime = atof(argv[++i]);
+		else if(arg == "--threads" && hasValue) options.threads = atoi(argv[++i]);
+		else if(arg == "--json" && hasValue) jsonPath = argv[++i];
+		else if(arg == "--compare" && hasValue) comparePath = argv[++i];
+		else if(arg == "--tolerance" && hasValue) tolerance = atof(argv[++i]);
+		else{
+			usage();
+			return 2;
+		}
+	}
+
+	// The baseline is read before anything is written, so --json and --compare can name the same file.
+	std::vector<BenchResult> baseline;
+	if(!comparePath.empty()){
+		std::ifstream in(comparePath,std::ios::binary);
+		std::stringstream content;
+		content << in.rdbuf();
+		if(!in || !benchFromJson(content.str(),baseline)){
+			fprintf(stderr,"Unable to read the baseline %s\n",comparePath.c_str());
+			return 2;
+		}
+	}
+
+	std::vector<BenchResult> results;
+	bool found = false;
+	if(options.threads == 0) options.threads = std::thread::hardware_concurrency();
+	if(options.threads == 0) options.threads = 1;
+	printf("%-10s %-24s %-16s %14s %12s %10s %10s %10s %10s\n","suite","name","shape","ns","calls/s","GFLOP/s","GB/s","allocs","heap MB");
+	for(auto& suite : suites){
+		if(!suiteName.empty() && suiteName != suite.name) continue;
+		found = true;
+		const u32 first = results.size();
+		suite.run(options,results);
+		for(u32 i = first;i < results.size();i++){
+			BenchResult& r = results[i];
+			r.suite = suite.name;
+			printf("%-10s %-24s %-16s %14.1f %12.1f %10.3f %10.3f %10.1f %10.1f\n",r.suite.c_str(),r.name.c_str(),r.shape.c_str(),
+				r.nanoseconds,1e9 / r.nanoseconds,r.gflops(),r.gbs(),r.allocations,r.peakHeap / (1024 * 1024));
+			fflush(stdout);
+		}
+	}
+	if(!found){
+		usage();
+		return 2;
+	}
+
+	if(!jsonPath.empty()){
+		std::ofstream out(jsonPath,std::ios::binary);
+		out << benchToJson(results);
+		if(!out){
+			fprintf(stderr,"Unable to write %s\n",jsonPath.c_str());
+			return 2;
+		}
+	}
+	if(!comparePath.empty() && benchCompare(baseline,results,tolerance) > 0) return 1;
+	return 0;
+}
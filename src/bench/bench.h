@@ -0,0 +1,75 @@
+/*
+ * bench.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "utils/utils.h"
+
+namespace vio {
+
+	/**
+	Benchmarks of vlearn. Unlike the tests, they check nothing, they measure.
+
+	Every suite sweeps a set of shapes for a set of operations and reports the best time of one call,
+	the achieved GFLOP/s and GB/s. The results can be saved as JSON and compared with a baseline
+	to catch regressions:
+	@code
+	bench --json baseline.json              # on the reference commit
+	bench --compare baseline.json           # after the change, exits with 1 if something got slower
+	bench --json last.json --compare last.json # compares with the previous run, then replaces it
+	bench --suite kernels --filter Matrix --time 1
+	@endcode
+	 */
+
+	struct BenchResult{
+		std::string suite;
+		std::string name; // the operation, like "Matrix::mul"
+		std::string shape; // like "256x256"
+		double nanoseconds = 0; // best time of one call
+		double flops = 0; // floating point operations of one call
+		double bytes = 0; // memory read and written by one call, every element counted once
+		double allocations = 0; // heap allocations (operator new) per call
+		double peakHeap = 0; // bytes, peak growth of the heap (operator new) during the workload, for the suites that report it
+
+		double gflops() const;
+		double gbs() const;
+	};
+
+	struct BenchOptions{
+		double minTime = 0.2; // seconds spent measuring every benchmark
+		std::string filter; // only the benchmarks whose name contains this
+		u32 threads = 0; // the suites that use threads go from 1 to this number of threads, 0 = the number of cores
+
+		bool selected(const std::string& name) const;
+	};
+
+	// Runs fn repeatedly for options.minTime seconds and keeps the best time per call, so that the result is not
+	// disturbed by the other processes of the machine.
+	BenchResult measure(const BenchOptions& options,const std::string& name,const std::string& shape,
+		double flops,double bytes,const std::function<void()>& fn);
+
+	// A suite appends its results (the suite field is set by the caller).
+	typedef void (*BenchSuite)(const BenchOptions& options,std::vector<BenchResult>& results);
+
+	void benchKernels(const BenchOptions& options,std::vector<BenchResult>& results); // kernels.cpp
+	void benchTraining(const BenchOptions& options,std::vector<BenchResult>& results); // training.cpp
+	void benchBigint(const BenchOptions& options,std::vector<BenchResult>& results); // bigint.cpp
+
+	uint64_t heapAllocations(); // number of calls to operator new since the start of the program
+	uint64_t heapBytes(); // bytes currently allocated with operator new (as reported by the allocator)
+	uint64_t peakHeapBytes(); // highest heapBytes since the last resetPeakHeapBytes
+	void resetPeakHeapBytes();
+
+	std::string benchToJson(const std::vector<BenchResult>& results);
+	bool benchFromJson(const std::string& json,std::vector<BenchResult>& results); // false if the json was not written by benchToJson
+	// Prints the results that are slower than in baseline by more than tolerance (0.1 = 10%), returns how many.
+	u32 benchCompare(const std::vector<BenchResult>& baseline,const std::vector<BenchResult>& results,double tolerance);
+
+} /* namespace vio */
@@ -0,0 +1,143 @@
+/*
+ * bigint.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "bench.h"
+
+#include <string>
+#include "utils/ThreadPool.h"
+#include "math/BigInt.h"
+
+namespace vio {
+
+	// A number of about this many decimal digits.
+	static Bigint bigintOfDigits(u32 digits,u32 seed){
+		std::string s;
+		u32 x = seed * 2654435761u + 1;
+		for(u32 i = 0;i < digits;i++){
+			x = x * 1664525 + 1013904223;
+			s += (char)('0' + (i == 0 ? 1 + (x >> 16) % 9 : (x >> 16) % 10));
+		}
+		return Bigint(s);
+	}
+
+	void benchBigint(const BenchOptions& options,std::vector<BenchResult>& results){
+		for(u32 digits : {20,200,2000,20000}){
+			const std::string shape = std::to_string(digits) + " digits";
+			Bigint a = bigintOfDigits(digits,1),b = bigintOfDigits(digits,2);
+			if(options.selected("Bigint::operator+=")){
+				Bigint c = a;
+				results.push_back(measure(options,"Bigint::operator+=",shape,0,0,[&](){
+					c += b;
+				}));
+			}
+			if(options.selected("Bigint::operator*") && digits <= 2000){
+				results.push_back(measure(options,"Bigint::operator*",shape,0,0,[&](){
+					Bigint c = a * b;
+				}));
+			}
+			if(options.selected("Bigint::operator*=(int)")){
+				Bigint c = a;
+				results.push_back(measure(options,"Bigint::operator*=(int)",shape,0,0,[&](){
+					c *= 999999937;
+					c = a;
+				}));
+			}
+			if(options.selected("to_string(Bigint)") && digits <= 2000){
+				results.push_back(measure(options,"to_string(Bigint)",shape,0,0,[&](){
+					std::string s = to_string(a);
+				}));
+			}
+		}
+		// The crossovers of the multiplications, to tune Bigint::karatsubaThreshold, toomThreshold and nttThreshold:
+		// each algorithm is forced at the top level, the recursive products use the current thresholds.
+		const size_t karatsuba = Bigint::karatsubaThreshold,toom = Bigint::toomThreshold,ntt = Bigint::nttThreshold;
+		for(u32 limbs : {8,16,24,32,48,64,96,128,192,256,384,512,1024,2048,4096,8192,16384}){
+			const std::string shape = std::to_string(limbs) + " limbs";
+			Bigint a = bigintOfDigits(limbs * 19,3),b = bigintOfDigits(limbs * 19,4);
+			const size_t n = std::min(a.limbCount(),b.limbCount()); // a bit less than limbs
+			Bigint::nttThreshold = n + 1;
+			if(options.selected("schoolbook") && limbs <= 1024){
+				Bigint::karatsubaThreshold = Bigint::toomThreshold = n + 1;
+				results.push_back(measure(options,"schoolbook",shape,0,0,[&](){
+					Bigint c = a * b;
+				}));
+			}
+			if(options.selected("karatsuba") && limbs <= 1024){
+				Bigint::karatsubaThreshold = std::min(karatsuba,n);
+				Bigint::toomThreshold = n + 1;
+				results.push_back(measure(options,"karatsuba",shape,0,0,[&](){
+					Bigint c = a * b;
+				}));
+			}
+			if(options.selected("toom3") && limbs >= 24){
+				Bigint::karatsubaThreshold = std::min(karatsuba,n);
+				Bigint::toomThreshold = std::min(toom,n);
+				results.push_back(measure(options,"toom3",shape,0,0,[&](){
+					Bigint c = a * b;
+				}));
+			}
+			if(options.selected("ntt") && limbs >= 256){
+				Bigint::karatsubaThreshold = karatsuba;
+				Bigint::toomThreshold = toom;
+				Bigint::nttThreshold = n;
+				results.push_back(measure(options,"ntt",shape,0,0,[&](){
+					Bigint c = a * b;
+				}));
+				if(options.threads > 1){
+					ThreadPool pool(options.threads);
+					Bigint::pool = &pool;
+					results.push_back(measure(options,"ntt",shape + " threads=" + std::to_string(options.threads),0,0,[&](){
+						Bigint c = a * b;
+					}));
+					Bigint::pool = 0;
+				}
+			}
+			Bigint::karatsubaThreshold = karatsuba;
+			Bigint::toomThreshold = toom;
+			Bigint::nttThreshold = ntt;
+		}
+		if(options.selected("factorial")){
+			for(int n : {100,1000,5000,20000,100000}){
+				results.push_back(measure(options,"factorial",std::to_string(n),0,0,[&](){
+					Bigint f = factorial(n);
+				}));
+			}
+		}
+		if(options.selected("Bigint::digits") || options.selected("Bigint::trailing_zeros")){
+			for(int n : {1000,20000,100000}){
+				const Bigint f = factorial(n);
+				volatile int sink = 0;
+				if(options.selected("Bigint::digits")){
+					results.push_back(measure(options,"Bigint::digits",std::to_string(n) + "!",0,0,[&](){
+						sink = f.digits();
+					}));
+				}
+				if(options.selected("Bigint::trailing_zeros")){
+					results.push_back(measure(options,"Bigint::trailing_zeros",std::to_string(n) + "!",0,0,[&](){
+						sink = f.trailing_zeros();
+					}));
+				}
+			}
+		}
+		if(options.selected("binomial")){
+			for(int n : {1000,10000,100000}){
+				results.push_back(measure(options,"binomial",std::to_string(n) + " " + std::to_string(n / 3),0,0,[&](){
+					Bigint c = binomial(n,n / 3);
+				}));
+			}
+		}
+		if(options.selected("Bigint::pow")){
+			for(int n : {1000,10000,100000}){
+				results.push_back(measure(options,"Bigint::pow","3^" + std::to_string(n),0,0,[&](){
+					Bigint p = 3;
+					p.pow(n);
+				}));
+			}
+		}
+	}
+
+} /* namespace vio */
@@ -0,0 +1,149 @@
+/*
+ * kernels.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "bench.h"
+
+#include <string>
+#include "utils/ThreadPool.h"
+#include "math/Matrix.h"
+#include "math/Vector.h"
+#include "math/RandomStream.h"
+#include "math/math.h"
+
+namespace vio {
+
+	static std::string shape(u32 a,u32 b){
+		return std::to_string(a) + "x" + std::to_string(b);
+	}
+
+	// Sizes of the matrices, from "fits in L1" to "does not fit in the cache".
+	static const u32 matrixSizes[][2] = {{64,64},{256,256},{784,128},{1024,1024},{4096,4096}};
+	static const u32 vectorSizes[] = {16,1024,65536,1 << 20};
+
+	void benchKernels(const BenchOptions& options,std::vector<BenchResult>& results){
+		if(options.selected("Matrix::mul")){
+			for(u32 n : {32,64,128,256}){
+				Matrix a(n,n),b(n,n);
+				a.fillRandom();
+				b.fillRandom();
+				results.push_back(measure(options,"Matrix::mul",shape(n,n),2.0 * n * n * n,3.0 * n * n * sizeof(float),[&](){
+					Matrix c = Matrix::mul(a,b);
+				}));
+			}
+		}
+		for(auto& s : matrixSizes){
+			const u32 w = s[0],h = s[1];
+			const double flops = 2.0 * w * h;
+			const double bytes = ((double)w * h + w + h) * sizeof(float);
+			Matrix m(w,h);
+			m.fillRandom();
+			const Matrix& cm = m;
+			Vector x(w),y(h);
+			x.fillRandom();
+			y.fillRandom();
+			if(options.selected("Matrix::apply")){
+				Vector r(h);
+				results.push_back(measure(options,"Matrix::apply",shape(w,h),flops,bytes,[&](){
+					m.apply(x,r);
+				}));
+			}
+			if(options.selected("Matrix::applyTranspose")){
+				results.push_back(measure(options,"Matrix::applyTranspose",shape(w,h),flops,bytes,[&](){
+					Vector r = m.applyTranspose(y);
+				}));
+			}
+			if(options.selected("Matrix::transpose")){
+				results.push_back(measure(options,"Matrix::transpose",shape(w,h),0,2.0 * w * h * sizeof(float),[&](){
+					Matrix t = cm.transpose();
+				}));
+			}
+			if(w == h && options.selected("Matrix::transposeInPlace")){
+				results.push_back(measure(options,"Matrix::transposeInPlace",shape(w,h),0,2.0 * w * h * sizeof(float),[&](){
+					m.transpose();
+				}));
+			}
+			if(options.selected("Vector::crossNorm")){
+				// y xᵀ has the shape of m
+				results.push_back(measure(options,"Vector::crossNorm",shape(w,h),(double)w * h,bytes,[&](){
+					Matrix c = Vector::crossNorm(y,x);
+				}));
+				results.push_back(measure(options,"Vector::crossNorm (into)",shape(w,h),(double)w * h,bytes,[&](){
+					Vector::crossNorm(y,x,m);
+				}));
+			}
+		}
+		for(u32 n : vectorSizes){
+			Vector a(n),b(n);
+			a.fillRandom();
+			b.fillRandom();
+			if(options.selected("Vector::dot")){
+				volatile float sink = 0;
+				results.push_back(measure(options,"Vector::dot",std::to_string(n),2.0 * n,2.0 * n * sizeof(float),[&](){
+					sink = Vector::dot(a,b);
+				}));
+			}
+			// the global generator one call per number against the counter based bulk fills.
+			if(options.selected("randomFloat")){
+				float * d = a.raw();
+				results.push_back(measure(options,"randomFloat",std::to_string(n),0,(double)n * sizeof(float),[&](){
+					for(u32 i = 0;i < n;i++) d[i] = randomFloat();
+				}));
+				results.push_back(measure(options,"randomFloats",std::to_string(n),0,(double)n * sizeof(float),[&](){
+					randomFloats(d,n);
+				}));
+			}
+			if(options.selected("Vector::fillRandom")){
+				results.push_back(measure(options,"Vector::fillRandom",std::to_string(n),0,(double)n * sizeof(float),[&](){
+					a.fillRandom();
+				}));
+			}
+			if(options.selected("RandomStream::fill")){
+				RandomStream rng(1);
+				results.push_back(measure(options,"RandomStream::fillUniform",std::to_string(n),0,(double)n * sizeof(float),[&](){
+					a.fillRandom(rng);
+				}));
+				results.push_back(measure(options,"RandomStream::fillGaussian",std::to_string(n),0,(double)n * sizeof(float),[&](){
+					a.fillGaussian(rng);
+				}));
+			}
+			if(options.selected("Vector::softmax")){
+				// exp, sum and division per element
+				results.push_back(measure(options,"Vector::softmax",std::to_string(n),3.0 * n,2.0 * n * sizeof(float),[&](){
+					a.softmax(b);
+				}));
+			}
+		}
+		// fields of 2 octaves, one point at a time against the grid
+		const u32 fields[][3] = {{256,256,1},{64,64,64}};
+		ThreadPool pool(options.threads);
+		for(auto& d : fields){
+			const u32 n = d[0] * d[1] * d[2];
+			const std::string s = shape(d[0],d[1]) + "x" + std::to_string(d[2]);
+			const double origin[3] = {0.3,0.7,0.5};
+			const double step[3] = {0.05,0.05,0.05};
+			std::vector<float> field(n);
+			if(options.selected("perlin")){
+				results.push_back(measure(options,"perlin",s,0,(double)n * sizeof(float),[&](){
+					u32 index = 0;
+					for(u32 k = 0;k < d[2];k++) for(u32 j = 0;j < d[1];j++) for(u32 i = 0;i < d[0];i++){
+						const double x = origin[0] + i * step[0],y = origin[1] + j * step[1],z = origin[2] + k * step[2];
+						field[index++] = perlin(x,y,z) + perlin(2 * x,2 * y,2 * z) / 2;
+					}
+				}));
+			}
+			if(options.selected("perlinGrid")){
+				results.push_back(measure(options,"perlinGrid",s,0,(double)n * sizeof(float),[&](){
+					perlinGrid(origin,step,d,2,field.data());
+				}));
+				results.push_back(measure(options,"perlinGrid",s + " threads=" + std::to_string(options.threads),0,(double)n * sizeof(float),[&](){
+					perlinGrid(origin,step,d,2,field.data(),&pool);
+				}));
+			}
+		}
+	}
+
+} /* namespace vio */
@@ -0,0 +1,246 @@
+/*
+ * training.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "bench.h"
+
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include "utils/ThreadPool.h"
+#include "ml/NeuralNetwork.h"
+#include "ml/DenseLayer.h"
+#include "ml/ConvLayer.h"
+#include "ml/SoftMaxLayer.h"
+#include "ml/SyntheticData.h"
+#include "ml/GradientCompressor.h"
+#include "math/math.h"
+
+namespace vio {
+
+	// A network and a synthetic dataset with the shapes of a real workload.
+	struct Workload{
+		std::string name;
+		std::vector<std::unique_ptr<Layer>> layers;
+		bool classifier = false; // softmax + cross entropy, one hot outputs
+	};
+
+	// The topology of test_mnist: 28x28 images, 2 convolutions, 2 dense layers and a softmax.
+	static void mnist(Workload& w){
+		const u32 side = 28;
+		ConvLayer * c1 = new ConvLayer(side * side,2,8,8);
+		ConvLayer * c2 = new ConvLayer(side * side / 4,2,8,8);
+		DenseLayer * d1 = new DenseLayer(side * side / 16,30);
+		DenseLayer * d2 = new DenseLayer(30,10);
+		c1->randomInit(0.1); c2->randomInit(0.1); d1->randomInit(0.1); d2->randomInit(0.1);
+		w.name = "mnist";
+		w.layers.emplace_back(c1);
+		w.layers.emplace_back(c2);
+		w.layers.emplace_back(d1);
+		w.layers.emplace_back(d2);
+		w.layers.emplace_back(new SoftMaxLayer(10));
+		w.classifier = true;
+	}
+
+	// depth hidden layers of width neurons, 10 outputs.
+	static void mlp(Workload& w,u32 depth,u32 width){
+		w.name = "mlp " + std::to_string(depth) + "x" + std::to_string(width);
+		for(u32 i = 0;i < depth;i++){
+			DenseLayer * l = new DenseLayer(width,width);
+			l->randomInit(1.0 / std::sqrt(width));
+			w.layers.emplace_back(l);
+		}
+		DenseLayer * out = new DenseLayer(width,10);
+		out->randomInit(1.0 / std::sqrt(width));
+		w.layers.emplace_back(out);
+	}
+
+	static void runWorkload(const BenchOptions& options,Workload& w,std::vector<BenchResult>& results){
+		const bool train = options.selected("train " + w.name);
+		const bool loss = options.selected("loss " + w.name);
+		const bool apply = options.selected("apply " + w.name);
+		const bool batch = options.selected("batch " + w.name);
+		const bool batchFast = options.selected("batch nondet " + w.name);
+		if(!train && !loss && !apply && !batch && !batchFast) return;
+
+		double forwardFlops = 0,trainFlops = 0;
+		for(auto& l : w.layers){
+			forwardFlops += l->applyFlops();
+			trainFlops += l->applyFlops() + l->gradientFlops() + l->updateFlops();
+		}
+		// about 30 ms per epoch at 1 GFLOP/s
+		const u32 samples = (u32)max(8.0,min(1024.0,3e7 / trainFlops));
+
+		const u32 inS = w.layers.front()->inputSize();
+		const u32 outS = w.layers.back()->outputSize();
+		std::vector<Vector> in,out;
+		for(u32 i = 0;i < samples;i++){
+			Vector x(inS);
+			for(u32 j = 0;j < inS;j++) x.at(j) = randomFloat();
+			Vector y(outS);
+			if(w.classifier){
+				y.fill(0);
+				y.at(randomU32(outS - 1)) = 1;
+			}else{
+				y.fillRandom(0.5);
+			}
+			in.push_back(std::move(x));
+			out.push_back(std::move(y));
+		}
+
+		NeuralNetwork nn;
+		for(auto& l : w.layers) nn.layers.push_back(l.get());
+		if(w.classifier){
+			nn.errorFunction = crossEntropyErrorFn;
+			nn.errorFunctionGradient = crossEntropyErrorDerivative;
+		}
+
+		std::vector<u32> threadCounts;
+		for(u32 t = 1;t < options.threads;t *= 2) threadCounts.push_back(t);
+		threadCounts.push_back(options.threads);
+
+		for(u32 t : threadCounts){
+			// The samples of train are sequential, the threads are used inside the dense layers.
+			// loss uses them across samples.
+			ThreadPool pool(t);
+			for(Layer * l : nn.layers){
+				DenseLayer * d = dynamic_cast<DenseLayer*>(l);
+				if(d != 0) d->shard(t > 1 ? &pool : 0,DenseLayer::SHARD_ROWS);
+			}
+			nn.computationCoreCount = t;
+			nn.prepare();
+			resetPeakHeapBytes();
+			const uint64_t heapBefore = heapBytes();
+
+			const std::string shape = "threads=" + std::to_string(t);
+			const u32 first = results.size();
+			if(train){
+				results.push_back(measure(options,"train " + w.name,shape,trainFlops * samples,0,[&](){
+					nn.train(in,out,0.0001);
+				}));
+			}
+			if(loss){
+				results.push_back(measure(options,"loss " + w.name,shape,forwardFlops * samples,0,[&](){
+					nn.loss(in,out);
+				}));
+			}
+			// trainParallel with batches of 32, with and without the thread count independent reduction.
+			if(batch){
+				nn.deterministic = true;
+				results.push_back(measure(options,"batch " + w.name,shape,trainFlops * samples,0,[&](){
+					nn.trainParallel(in,out,0.0001,32);
+				}));
+			}
+			if(batchFast){
+				nn.deterministic = false;
+				results.push_back(measure(options,"batch nondet " + w.name,shape,trainFlops * samples,0,[&](){
+					nn.trainParallel(in,out,0.0001,32);
+				}));
+				nn.deterministic = true;
+			}
+			if(apply){
+				results.push_back(measure(options,"apply " + w.name,shape,forwardFlops * samples,0,[&](){
+					for(u32 i = 0;i < samples;i++) nn.apply(in[i]);
+				}));
+			}
+			// per sample, so that calls/s is samples/s
+			const uint64_t peakHeap = peakHeapBytes();
+			const uint64_t peak = peakHeap > heapBefore ? peakHeap - heapBefore : 0;
+			for(u32 i = first;i < results.size();i++){
+				BenchResult& r = results[i];
+				r.nanoseconds /= samples;
+				r.flops /= samples;
+				r.allocations /= samples;
+				r.peakHeap = peak;
+			}
+
+			for(Layer * l : nn.layers){
+				DenseLayer * d = dynamic_cast<DenseLayer*>(l);
+				if(d != 0) d->shard(0,DenseLayer::SHARD_NONE);
+			}
+			nn.ready(); // the pool of the network is rebuilt for the next thread count
+		}
+	}
+
+	// Throughput of the synthetic data streams, per sample, with every thread generating.
+	static void benchSynthetic(const BenchOptions& options,std::vector<BenchResult>& results){
+		ShapeTask shapes(28);
+		NoiseTextureTask textures(28);
+		PolynomialTask polynomial(64,10,3);
+		struct{ const char * name; SyntheticTask * task; } tasks[] = {
+			{"synthetic shapes 28",&shapes},{"synthetic noise 28",&textures},{"synthetic poly 64",&polynomial}
+		};
+		const u32 batchSize = 64;
+		for(auto& t : tasks){
+			if(!options.selected(t.name)) continue;
+			SyntheticStream stream(*t.task,batchSize,1,options.threads);
+			BenchResult r = measure(options,t.name,"threads=" + std::to_string(options.threads),0,
+				(double)batchSize * (t.task->inputSize() + t.task->outputSize()) * sizeof(float),[&](){
+				stream.next();
+			});
+			r.nanoseconds /= batchSize;
+			r.bytes /= batchSize;
+			r.allocations /= batchSize;
+			results.push_back(r);
+		}
+	}
+
+	// Gradient compression of one bucket, with error feedback like in DistributedTrainer.
+	// It pays when the time of compress and decompress is below the time the network needs for the bytes saved.
+	static void benchCompression(const BenchOptions& options,std::vector<BenchResult>& results){
+		TopKCompressor topk(0.01);
+		Int8Compressor int8;
+		SignCompressor sign;
+		struct{ const char * name; GradientCompressor * compressor; } compressors[] = {
+			{"top 1%",&topk},{"int8",&int8},{"sign",&sign}
+		};
+		for(u32 count : {1 << 16,1 << 20}){
+			std::vector<float> gradient(count),data(count),sum(count);
+			randomFloats(gradient.data(),count);
+			for(auto& c : compressors){
+				const std::string compress = std::string("compress ") + c.name;
+				const std::string decompress = std::string("decompress ") + c.name;
+				if(!options.selected(compress) && !options.selected(decompress)) continue;
+				const double bytes = (double)count * sizeof(float) + c.compressor->compressedSize(count);
+				std::vector<char> packed;
+				packed.reserve(c.compressor->compressedSize(count));
+				if(options.selected(compress)){
+					// the gradient is copied every time, the error of the previous call is added to it.
+					results.push_back(measure(options,compress,std::to_string(count),0,bytes,[&](){
+						std::copy(gradient.begin(),gradient.end(),data.begin());
+						packed.clear();
+						c.compressor->compress(0,data.data(),count,packed);
+					}));
+				}
+				if(options.selected(decompress)){
+					packed.clear();
+					data = gradient;
+					c.compressor->compress(0,data.data(),count,packed);
+					results.push_back(measure(options,decompress,std::to_string(count),0,bytes,[&](){
+						c.compressor->decompressAdd(packed.data(),count,sum.data());
+					}));
+				}
+			}
+		}
+	}
+
+	void benchTraining(const BenchOptions& options,std::vector<BenchResult>& results){
+		benchSynthetic(options,results);
+		benchCompression(options,results);
+		{
+			Workload w;
+			mnist(w);
+			runWorkload(options,w,results);
+		}
+		const u32 shapes[][2] = {{2,64},{2,256},{4,256},{8,256},{2,1024},{4,1024}};
+		for(auto& s : shapes){
+			Workload w;
+			mlp(w,s[0],s[1]);
+			runWorkload(options,w,results);
+		}
+	}
+
+} /* namespace vio */
@@ -0,0 +1,75 @@
+/*
+This is a queue used to pass messages between threads, like BufferedDataStream,
+but pop() waits until an element is available instead of returning garbage.
+
+Elements are moved in and out of the queue, so any type can be used (not only simple structs).
+The queue has no maximum size, push() never waits.
+
+@code
+BlockingQueue<u32> q;
+std::thread t([&q](){
+	u32 v;
+	while(q.pop(v)){ // returns false once the queue is closed and empty.
+		debug("%i",v);
+	}
+});
+q.push(1);
+q.push(2);
+q.close();
+t.join();
+@endcode
+*/
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace vio{
+
+template<typename T>
+class BlockingQueue {
+	std::deque<T> elements;
+	std::mutex lock;
+	std::condition_variable available;
+	bool closed = false;
+public:
+	void push(T element){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			elements.push_back(std::move(element));
+		}
+		available.notify_one();
+	}
+	// waits for an element. Returns false if the queue was closed and is empty.
+	bool pop(T& result){
+		std::unique_lock<std::mutex> guard(lock);
+		available.wait(guard,[this]{ return !elements.empty() || closed; });
+		if(elements.empty()) return false;
+		result = std::move(elements.front());
+		elements.pop_front();
+		return true;
+	}
+	// never waits, returns false if nothing is available.
+	bool tryPop(T& result){
+		std::lock_guard<std::mutex> guard(lock);
+		if(elements.empty()) return false;
+		result = std::move(elements.front());
+		elements.pop_front();
+		return true;
+	}
+	size_t size(){
+		std::lock_guard<std::mutex> guard(lock);
+		return elements.size();
+	}
+	// wakes up every thread waiting in pop. Elements already in the queue can still be popped.
+	void close(){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			closed = true;
+		}
+		available.notify_all();
+	}
+};
+
+}
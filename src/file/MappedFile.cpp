@@ -0,0 +1,75 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "file/MappedFile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#include <codecvt>
+#include <locale>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vio{
+
+MappedFile::MappedFile(std::string filename){
+#ifdef WIN32
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+	std::wstring wpath = convert.from_bytes(filename.c_str());
+	HANDLE file = CreateFileW(wpath.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if(file == INVALID_HANDLE_VALUE) return;
+	fileHandle = file;
+
+	LARGE_INTEGER fsize;
+	if(!GetFileSizeEx(file,&fsize) || fsize.QuadPart == 0) return;
+	length = fsize.QuadPart;
+
+	HANDLE mapping = CreateFileMappingW(file,NULL,PAGE_WRITECOPY,0,0,NULL);
+	if(mapping == NULL) return;
+	mappingHandle = mapping;
+	ptr = (char*)MapViewOfFile(mapping,FILE_MAP_COPY,0,0,0);
+#else
+	int fd = open(filename.c_str(),O_RDONLY);
+	if(fd < 0) return;
+	struct stat st;
+	if(fstat(fd,&st) != 0 || st.st_size == 0){
+		close(fd);
+		return;
+	}
+	length = st.st_size;
+	void * p = mmap(0,length,PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0);
+	close(fd); // the mapping keeps a reference to the file.
+	if(p == MAP_FAILED) return;
+	ptr = (char*)p;
+#endif
+}
+
+MappedFile::~MappedFile(){
+#ifdef WIN32
+	if(ptr != 0) UnmapViewOfFile(ptr);
+	if(mappingHandle != 0) CloseHandle((HANDLE)mappingHandle);
+	if(fileHandle != 0) CloseHandle((HANDLE)fileHandle);
+#else
+	if(ptr != 0) munmap(ptr,length);
+#endif
+}
+
+bool MappedFile::isLoaded(){
+	return ptr != 0;
+}
+char * MappedFile::data(){
+	return ptr;
+}
+uint64_t MappedFile::size(){
+	return ptr != 0 ? length : 0;
+}
+
+}
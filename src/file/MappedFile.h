@@ -0,0 +1,48 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "utils/utils.h"
+
+namespace vio{
+
+/**
+A file mapped in memory. Pages are loaded by the OS when they are first accessed, nothing is read when the object is created.
+
+The mapping is private (copy on write): writing to data() is allowed and never modifies the file on disk.
+This is used by NeuralNetwork::loadMapped to use the weights of a model directly from the file.
+
+@code
+MappedFile mf(getExecutableFolderPath() + "/model.vlnn");
+if(mf.isLoaded()){
+	debug("First byte: %i",mf.data()[0]);
+}
+@endcode
+ */
+class MappedFile {
+	char * ptr = 0;
+	uint64_t length = 0;
+#ifdef WIN32
+	void * fileHandle = 0;
+	void * mappingHandle = 0;
+#endif
+public:
+	// filename should be encoded in utf8.
+	MappedFile(std::string filename);
+	MappedFile(MappedFile& f) = delete;
+	MappedFile& operator=(const MappedFile& v) = delete;
+	~MappedFile();
+
+	bool isLoaded();
+
+	char * data(); // aligned on a page boundary.
+	uint64_t size();
+};
+
+}
@@ -0,0 +1,94 @@
+/*
+ * SharedMemory.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "file/SharedMemory.h"
+
+#ifdef WIN32
+#include <windows.h>
+#include <codecvt>
+#include <locale>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vio{
+
+SharedMemory::SharedMemory(const std::string& name,uint64_t size,bool create){
+	this->name = name;
+	this->creator = create;
+	if(size == 0) return;
+#ifdef WIN32
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+	std::wstring wname = convert.from_bytes(("Local\\" + name).c_str());
+	HANDLE mapping;
+	if(create){
+		// backed by the page file, destroyed when the last handle is closed.
+		mapping = CreateFileMappingW(INVALID_HANDLE_VALUE,NULL,PAGE_READWRITE,(DWORD)(size >> 32),(DWORD)size,wname.c_str());
+		if(mapping != NULL && GetLastError() == ERROR_ALREADY_EXISTS){
+			// another process still uses the name: this would be its memory, not a new zeroed one.
+			CloseHandle(mapping);
+			return;
+		}
+	}else{
+		mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS,FALSE,wname.c_str());
+	}
+	if(mapping == NULL) return;
+	mappingHandle = mapping;
+	ptr = (char*)MapViewOfFile(mapping,FILE_MAP_ALL_ACCESS,0,0,size);
+	if(ptr != 0) length = size;
+#else
+	std::string path = "/" + name;
+	int fd;
+	if(create){
+		shm_unlink(path.c_str()); // leftover of a crashed process
+		fd = shm_open(path.c_str(),O_RDWR | O_CREAT | O_EXCL,0600);
+		if(fd >= 0 && ftruncate(fd,size) != 0){
+			close(fd);
+			shm_unlink(path.c_str());
+			return;
+		}
+	}else{
+		fd = shm_open(path.c_str(),O_RDWR,0600);
+		struct stat st;
+		if(fd >= 0 && (fstat(fd,&st) != 0 || (uint64_t)st.st_size < size)){ // not resized by the creator yet.
+			close(fd);
+			return;
+		}
+	}
+	if(fd < 0) return;
+	void * p = mmap(0,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	close(fd); // the mapping keeps a reference to the memory.
+	if(p == MAP_FAILED) return;
+	ptr = (char*)p;
+	length = size;
+#endif
+}
+
+SharedMemory::~SharedMemory(){
+#ifdef WIN32
+	if(ptr != 0) UnmapViewOfFile(ptr);
+	if(mappingHandle != 0) CloseHandle((HANDLE)mappingHandle);
+#else
+	if(ptr != 0) munmap(ptr,length);
+	if(creator) shm_unlink(("/" + name).c_str());
+#endif
+}
+
+bool SharedMemory::isLoaded(){
+	return ptr != 0;
+}
+char * SharedMemory::data(){
+	return ptr;
+}
+uint64_t SharedMemory::size(){
+	return ptr != 0 ? length : 0;
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+ * SharedMemory.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "utils/utils.h"
+
+namespace vio{
+
+/**
+A block of memory shared by the processes of a machine, identified by a name.
+
+One process creates it, the others open it with the same name and size. The memory starts filled with zeros.
+The creator removes the name when it is destroyed, the processes that already opened the memory can still use it.
+On Windows, the name lives as long as a process has the memory open: creating it again before fails.
+
+@code
+// process 1
+SharedMemory shm("vlearn_example",4096,true);
+shm.data()[0] = 42;
+// process 2
+SharedMemory shm("vlearn_example",4096,false);
+if(shm.isLoaded()) debug("%i",shm.data()[0]);
+@endcode
+ */
+class SharedMemory {
+	char * ptr = 0;
+	uint64_t length = 0;
+	std::string name;
+	bool creator;
+#ifdef WIN32
+	void * mappingHandle = 0;
+#endif
+public:
+	// name should only contain letters, digits and underscores.
+	// On Linux, create replaces any memory with the same name, the processes using the old one keep it.
+	// On Windows, create fails (isLoaded is false) while a process still has a memory with this name open.
+	SharedMemory(const std::string& name,uint64_t size,bool create);
+	SharedMemory(SharedMemory& s) = delete;
+	SharedMemory& operator=(const SharedMemory& s) = delete;
+	~SharedMemory();
+
+	bool isLoaded();
+
+	char * data(); // aligned on a page boundary.
+	uint64_t size();
+};
+
+}
@@ -1,446 +1,1055 @@
-// bitint library
-
-#include <string>
-#include <sstream>
-#include <map>
-#include "bigint.h"
-
-
-//Constructor
-Bigint::Bigint()
-{
-    positive = true;
-    base = Bigint::default_base;
-    skip = 0;
-}
-Bigint::Bigint(const Bigint &b)
-        : number(b.number),
-          positive(b.positive),
-          base(b.base),
-          skip(b.skip) { }
-Bigint::Bigint(long long value){
-    base = Bigint::default_base;
-    skip = 0;
-    if (value < 0) {
-        positive = false;
-        value *= -1;
-    } else {
-        positive = true;
-    }
-
-    while (value) {
-        number.push_back((int) (value % base));
-        value /= base;
-    }
-}
-
-Bigint::Bigint(std::string stringInteger){
-    int size = stringInteger.length();
-
-    base = Bigint::default_base;
-    skip = 0;
-    positive = (stringInteger[0] != '-');
-
-    while (true) {
-        if (size <= 0) break;
-        if (!positive && size <= 1) break;
-
-        int length = 0;
-        int num = 0;
-        int prefix = 1;
-        for (int i(size - 1); i >= 0 && i >= size - 9; --i) {
-            if (stringInteger[i] < '0' || stringInteger[i] > '9') break;
-            num += (stringInteger[i] - '0') * prefix;
-            prefix *= 10;
-            ++length;
-        }
-        number.push_back(num);
-        size -= length;
-    }
-}
-
-//Adding
-Bigint Bigint::operator+(Bigint const &b) const
-{
-    Bigint c = *this;
-    c += b;
-
-    return c;
-}
-
-Bigint &Bigint::operator+=(Bigint const &b)
-{
-    if (!b.positive) {
-        return *this -= b;
-    }
-    std::vector<int>::iterator
-        it1 = number.begin();
-    std::vector<int>::const_iterator
-        it2 = b.number.begin();
-    int sum = 0;
-    while (it1 != number.end() || it2 != b.number.end()) {
-        if (it1 != number.end()) {
-            sum += *it1;
-        } else {
-            number.push_back(0);
-            it1 = number.end()-1;
-        }
-        if (it2 != b.number.end()) {
-            sum += *it2;
-            ++it2;
-        }
-        *it1 = sum % base;
-        ++it1;
-        sum /= base;
-    }
-    if (sum) number.push_back(1);
-
-    return *this;
-}
-
-Bigint Bigint::operator+(long long const &b) const
-{
-    Bigint c = *this;
-    c += b;
-
-    return c;
-}
-
-Bigint &Bigint::operator+=(long long b)
-{
-    std::vector<int>::iterator it = number.begin();
-    if (skip > number.size()) {
-        number.insert(number.end(), skip - number.size(), 0);
-    }
-    it += skip;
-    bool initial_flag=true;
-    while (b || initial_flag) {
-        initial_flag=false;
-        if (it != number.end()) {
-            *it += b % base;
-            b /= base;
-            b += *it / base;
-            *it %= base;
-            ++it;
-        } else {
-            number.push_back(0);
-            it = number.end() - 1;
-        }
-    }
-
-    return *this;
-}
-
-//Subtraction
-Bigint Bigint::operator-(Bigint const &b) const
-{
-    Bigint c = *this;
-    c -= b;
-
-    return c;
-}
-
-Bigint &Bigint::operator-=(Bigint const &b)
-{
-    std::vector<int>::iterator
-        it1 = number.begin();
-    std::vector<int>::const_iterator
-        it2 = b.number.begin();
-    int dif = 0;
-    while (it1 != number.end() || it2 != b.number.end()) {
-        if (it1 != number.end()) {
-            dif += *it1;
-            ++it1;
-        }
-        if (it2 != b.number.end()) {
-            dif -= *it2;
-            ++it2;
-        }
-        if (dif < 0) {
-            *(it1 - 1) = dif + base;
-            dif = -1;
-        } else {
-            *(it1 - 1) = dif % base;
-            dif /= base;
-        }
-    }
-    if (dif < 0) positive = false;
-
-    if (number.size() > 1)
-    {
-        do
-        {
-            it1 = number.end() - 1;
-            if (*it1 == 0) number.pop_back();
-            else break;
-        } while (number.size() > 1);
-    }
-
-    return *this;
-}
-
-//Multiplication
-Bigint Bigint::operator*(Bigint const &b)
-{
-    if (b.number.size() == 1) return *this *= b.number[0];
-    std::vector<int>::iterator it1;
-    std::vector<int>::const_iterator it2;
-    Bigint c;
-    for (it1 = number.begin(); it1 != number.end(); ++it1) {
-        for (it2 = b.number.begin(); it2 != b.number.end(); ++it2) {
-            c.skip = (unsigned int) (it1 - number.begin()) + (it2 - b.number.begin()); //TODO
-            c += (long long) (*it1) * (*it2);
-        }
-    }
-    c.skip = 0;
-
-    return c;
-}
-
-Bigint &Bigint::operator*=(Bigint const &b)
-{
-    *this = *this * b;
-
-    return *this;
-}
-
-Bigint Bigint::operator*(long long const &b)
-{
-    Bigint c = *this;
-    c *= b;
-
-    return c;
-}
-
-Bigint &Bigint::operator*=(int const &b)
-{
-    std::vector<int>::iterator it = number.begin();
-    long long sum = 0;
-    while (it != number.end()) {
-        sum += (long long) (*it) * b;
-        *it = (int) (sum % base);
-        sum /= base;
-        ++it;
-    }
-    if (sum) number.push_back((int) sum);
-
-    return *this;
-}
-
-//Power
-Bigint Bigint::pow(int const &power, std::map<int, Bigint> &lookup)
-{
-    if (power == 1) return *this;
-    if (lookup.count(power)) return lookup[power];
-
-    int closestPower = 1;
-    while (closestPower < power) closestPower <<= 1;
-    closestPower >>= 1;
-
-    if (power == closestPower) lookup[power] = pow(power / 2, lookup) * pow(power / 2, lookup);
-    else lookup[power] = pow(closestPower, lookup) * pow(power - closestPower, lookup);
-
-    return lookup[power];
-}
-
-Bigint &Bigint::pow(int const &power)
-{
-    std::map<int, Bigint> lookup;
-    if (power % 2 == 0 && !positive) {
-        positive = true;
-    }
-    *this = pow(power, lookup);
-
-    return *this;
-}
-
-//Compare
-int Bigint::compare(const Bigint &a) const //0 this == a || -1 this < a || 1 this > a
-{
-    if (positive && !a.positive) return 1;
-    if (!positive && a.positive) return -1;
-
-    int check = 1;
-    if (!positive && !a.positive) check = -1;
-
-    if (number.size() < a.number.size()) return -1 * check;
-    if (number.size() > a.number.size()) return check;
-    for (size_t i(number.size()); i > 0; --i) {
-        if (number[i-1] < a.number[i-1]) return -1 * check;
-        if (number[i-1] > a.number[i-1]) return check;
-    }
-
-    return 0; // ==
-}
-
-bool Bigint::operator<(Bigint const &b) const
-{
-    return compare(b) == -1;
-}
-
-bool Bigint::operator<=(const Bigint &b) const
-{
-    int compared = compare(b);
-
-    return compared == 0 || compared == -1;
-}
-
-bool Bigint::operator>(const Bigint &b) const
-{
-    return compare(b) == 1;
-}
-
-bool Bigint::operator>=(const Bigint &b) const
-{
-    int compared = compare(b);
-
-    return compared == 0 || compared == 1;
-}
-
-bool Bigint::operator==(Bigint const &b) const
-{
-    return compare(b) == 0;
-}
-
-bool Bigint::operator!=(Bigint const &b) const
-{
-    return ! (*this == b);
-}
-
-//Allocation
-Bigint Bigint::operator=(const long long &a)
-{
-    number.clear();
-    long long t = a;
-    do {
-        number.push_back((int) (t % base));
-        t /= base;
-    } while (t != 0);
-
-    return *this;
-}
-
-//Access
-int Bigint::operator[](int const &b)
-{
-    return to_string(*this)[b] - '0';
-}
-
-//Trivia
-int Bigint::digits() const
-{
-    int segments = number.size();
-
-    if (segments == 0) return 0;
-
-    int digits = 9 * (segments - 1);
-    digits += segment_length(number.back());
-
-    return digits;
-}
-
-int Bigint::trailing_zeros() const
-{
-    if (number.empty() || (number.size() == 1 && number[0] == 0)) return 1;
-
-    int zeros = 0;
-    std::vector<int>::const_iterator it = number.begin();
-    if (number.size() > 1) {
-        for (; it != number.end() - 1 && *it == 0; ++it) {
-            zeros += 9;
-        }
-    }
-    int a = *it;
-    while (a % 10 == 0 && a) {
-        ++zeros;
-        a /= 10;
-    }
-
-    return zeros;
-}
-
-//Helpers
-void Bigint::clear()
-{
-    number.clear();
-    positive = true;
-    skip = 0;
-}
-
-Bigint &Bigint::abs()
-{
-    positive = true;
-
-    return *this;
-}
-
-//Input&Output
-std::ostream &operator<<(std::ostream &out, Bigint const &a)
-{
-    if (!a.number.size()) return out << 0;
-    int i = a.number.size() - 1;
-    for (; i>=0 && a.number[i] == 0; --i);
-
-    if (i == -1) return out << 0;
-    if (!a.positive) out << '-';
-
-    std::vector<int>::const_reverse_iterator it = a.number.rbegin() + (a.number.size() - i - 1);
-
-    out << *it++;
-    for (; it != a.number.rend(); ++it) {
-        for (int i(0), len = a.segment_length(*it); i < 9 - len; ++i) out << '0';
-        if (*it) out << *it;
-    }
-
-    return out;
-}
-
-std::istream &operator>>(std::istream &in, Bigint &a)
-{
-    std::string str;
-    in >> str;
-
-    a = str;
-
-    return in;
-}
-
-int Bigint::segment_length(int segment) const
-{
-    int length = 0;
-    while (segment) {
-        segment /= 10;
-        ++length;
-    }
-
-    return length;
-}
-
-Bigint abs(Bigint value)
-{
-    return value.abs();
-}
-
-std::string to_string(Bigint const &value)
-{
-    std::ostringstream stream;
-    stream << value;
-
-    return stream.str();
-}
-
-Bigint factorial(int n)
-{
-    Bigint result = 1;
-    if (n % 2) {
-        result = n;
-        --n;
-    }
-    int last = 0;
-    for (; n >= 2; n -= 2) {
-        result *= n + last;
-        last += n;
-    }
-
-    return result;
-}
+// bitint library
+
+#include <string>
+#include <sstream>
+#include <map>
+#include <cstring>
+#include <algorithm>
+#include "utils/ThreadPool.h"
+#include "bigint.h"
+
+typedef unsigned __int128 uint128;
+
+// 10^19, the largest power of 10 in a limb: numbers are converted from and to decimal 19 digits at a time.
+static const uint64_t decimal_chunk = 10000000000000000000ULL;
+static const int decimal_chunk_digits = 19;
+
+// Compares magnitudes of n limbs (no leading zero limb).
+static int compare_limbs(const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    if (na != nb) return na < nb ? -1 : 1;
+    for (size_t i(na); i > 0; --i) {
+        if (a[i-1] != b[i-1]) return a[i-1] < b[i-1] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Inverse of an odd d modulo 2^64, by Newton's iteration: every step doubles the number of correct bits (3 for d itself).
+static uint64_t inverse_limb(uint64_t d)
+{
+    uint64_t inverse = d;
+    for (int i = 0; i < 5; ++i) inverse *= 2 - d * inverse;
+    return inverse;
+}
+
+// q = a / d for an odd d, from the least significant limb (Hensel division): a multiplication per limb instead of
+// a division. Only correct when d divides a, which is what it returns. a and q have n limbs.
+static bool divide_exact(const uint64_t *a, size_t n, uint64_t d, uint64_t inverse, uint64_t *q)
+{
+    uint64_t borrow = 0;
+    for (size_t i(0); i < n; ++i) {
+        const uint64_t s = a[i] - borrow;
+        const uint64_t qi = s * inverse; // qi * d = s mod 2^64
+        q[i] = qi;
+        borrow = (uint64_t) (((uint128) qi * d) >> 64) + (a[i] < borrow);
+    }
+    return borrow == 0;
+}
+
+//Constructor
+Bigint::Bigint()
+{
+    positive = true;
+}
+Bigint::Bigint(const Bigint &b)
+        : limbs(b.limbs),
+          positive(b.positive) { }
+Bigint::Bigint(long long value){
+    positive = value >= 0;
+    // -value overflows for the smallest long long, the unsigned negation does not.
+    uint64_t magnitude = positive ? (uint64_t) value : 0 - (uint64_t) value;
+    if (magnitude) limbs.push_back(magnitude);
+}
+
+Bigint::Bigint(std::string stringInteger){
+    positive = (stringInteger[0] != '-');
+    size_t i = positive ? 0 : 1;
+    size_t end = i;
+    while (end < stringInteger.size() && stringInteger[end] >= '0' && stringInteger[end] <= '9') ++end;
+
+    // long numbers: the chunks of 19 digits are joined by pairs, low + high 10^19, then by pairs of pairs
+    // with 10^38... so that the large products use the fast multiplications.
+    const size_t chunks = (end - i + decimal_chunk_digits - 1) / decimal_chunk_digits;
+    if (chunks > 256) {
+        std::vector<Bigint> level;
+        level.reserve(chunks);
+        for (size_t last = end; last > i;) { // least significant first
+            size_t first = last - std::min<size_t>(decimal_chunk_digits, last - i);
+            uint64_t chunk = 0;
+            for (size_t j = first; j < last; ++j) chunk = chunk * 10 + (stringInteger[j] - '0');
+            level.push_back(Bigint());
+            if (chunk) level.back().limbs.push_back(chunk);
+            last = first;
+        }
+        Bigint scale;
+        scale.limbs.push_back(decimal_chunk);
+        while (level.size() > 1) {
+            for (size_t j(0); j < level.size() / 2; ++j) level[j] = level[2 * j] + level[2 * j + 1] * scale;
+            if (level.size() % 2) level[level.size() / 2] = level.back();
+            level.resize((level.size() + 1) / 2);
+            if (level.size() > 1) scale *= scale;
+        }
+        limbs = level[0].limbs;
+        if (limbs.empty()) positive = true;
+        return;
+    }
+
+    // the first chunk is the short one, so that the others have exactly 19 digits.
+    size_t first = (end - i) % decimal_chunk_digits;
+    if (first == 0) first = decimal_chunk_digits;
+    while (i < end) {
+        uint64_t chunk = 0, scale = 1;
+        for (size_t j(0); j < first; ++j, ++i) {
+            chunk = chunk * 10 + (stringInteger[i] - '0');
+            scale *= 10;
+        }
+        mulSmall(scale);
+        addMagnitude(&chunk, 1);
+        first = decimal_chunk_digits;
+    }
+    trim();
+    if (limbs.empty()) positive = true;
+}
+
+//Helpers on the magnitude
+void Bigint::trim()
+{
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+}
+
+void Bigint::addMagnitude(const uint64_t *b, size_t n)
+{
+    if (limbs.size() < n) limbs.resize(n, 0);
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < n; ++i) {
+        uint128 sum = (uint128) limbs[i] + b[i] + carry;
+        limbs[i] = (uint64_t) sum;
+        carry = (uint64_t) (sum >> 64);
+    }
+    for (; carry && i < limbs.size(); ++i) {
+        carry = ++limbs[i] == 0;
+    }
+    if (carry) limbs.push_back(1);
+}
+
+void Bigint::subMagnitude(const uint64_t *b, size_t n, bool reversed)
+{
+    // the larger one minus the smaller one, the caller knows which is which.
+    if (limbs.size() < n) limbs.resize(n, 0);
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < n; ++i) {
+        uint64_t x = reversed ? b[i] : limbs[i];
+        uint64_t y = reversed ? limbs[i] : b[i];
+        uint64_t d = x - y - borrow;
+        borrow = (x < y) || (x - y < borrow);
+        limbs[i] = d;
+    }
+    for (; borrow && i < limbs.size(); ++i) {
+        borrow = limbs[i]-- == 0;
+    }
+    trim();
+}
+
+void Bigint::mulSmall(uint64_t b)
+{
+    uint64_t carry = 0;
+    for (size_t i(0); i < limbs.size(); ++i) {
+        uint128 product = (uint128) limbs[i] * b + carry;
+        limbs[i] = (uint64_t) product;
+        carry = (uint64_t) (product >> 64);
+    }
+    if (carry) limbs.push_back(carry);
+    if (b == 0) limbs.clear();
+}
+
+// Division of (high:low) by 10^19 with high < 10^19, without a division instruction:
+// 10^19 has its top bit set, the quotient is found with its precomputed reciprocal (Moller and Granlund,
+// "Improved division by invariant integers"), 2 multiplications instead of a 128 bit division.
+static const uint64_t decimal_chunk_inverse = (uint64_t) (~(uint128) 0 / decimal_chunk); // floor((2^128 - 1) / d) - 2^64
+
+static inline uint64_t div_decimal_chunk(uint64_t high, uint64_t low, uint64_t *remainder)
+{
+    uint128 q = (uint128) decimal_chunk_inverse * high + (((uint128) (high + 1) << 64) | low);
+    uint64_t q1 = (uint64_t) (q >> 64);
+    uint64_t r = low - q1 * decimal_chunk;
+    if (r > (uint64_t) q) {
+        --q1;
+        r += decimal_chunk;
+    }
+    if (r >= decimal_chunk) {
+        ++q1;
+        r -= decimal_chunk;
+    }
+    *remainder = r;
+    return q1;
+}
+
+uint64_t Bigint::divSmall(uint64_t b)
+{
+    uint64_t remainder = 0;
+    if (b == decimal_chunk) {
+        for (size_t i(limbs.size()); i > 0; --i) {
+            limbs[i-1] = div_decimal_chunk(remainder, limbs[i-1], &remainder);
+        }
+    } else {
+        for (size_t i(limbs.size()); i > 0; --i) {
+            uint128 current = ((uint128) remainder << 64) | limbs[i-1];
+            limbs[i-1] = (uint64_t) (current / b);
+            remainder = (uint64_t) (current % b);
+        }
+    }
+    trim();
+    return remainder;
+}
+
+void Bigint::add(Bigint const &b, bool negate)
+{
+    bool bPositive = b.positive != negate || b.limbs.empty();
+    if (positive == bPositive) {
+        addMagnitude(b.limbs.data(), b.limbs.size());
+        return;
+    }
+    // different signs: the result has the sign of the larger magnitude.
+    int c = compare_limbs(limbs.data(), limbs.size(), b.limbs.data(), b.limbs.size());
+    if (c == 0) {
+        clear();
+        return;
+    }
+    subMagnitude(b.limbs.data(), b.limbs.size(), c < 0);
+    if (c < 0) positive = bPositive;
+}
+
+//Adding
+Bigint Bigint::operator+(Bigint const &b) const
+{
+    Bigint c = *this;
+    c += b;
+
+    return c;
+}
+
+Bigint &Bigint::operator+=(Bigint const &b)
+{
+    // b may be this, add reads all of b before writing.
+    if (&b == this) {
+        Bigint copy = b;
+        add(copy, false);
+        return *this;
+    }
+    add(b, false);
+
+    return *this;
+}
+
+Bigint Bigint::operator+(long long const &b) const
+{
+    Bigint c = *this;
+    c += b;
+
+    return c;
+}
+
+Bigint &Bigint::operator+=(long long b)
+{
+    if (b >= 0 && positive) { // the common case, no allocation.
+        uint64_t x = (uint64_t) b;
+        if (x) addMagnitude(&x, 1);
+        return *this;
+    }
+    add(Bigint(b), false);
+
+    return *this;
+}
+
+//Subtraction
+Bigint Bigint::operator-(Bigint const &b) const
+{
+    Bigint c = *this;
+    c -= b;
+
+    return c;
+}
+
+Bigint &Bigint::operator-=(Bigint const &b)
+{
+    if (&b == this) {
+        clear();
+        return *this;
+    }
+    add(b, true);
+
+    return *this;
+}
+
+//Multiplication
+// The kernels work on flat limb arrays. r never overlaps the inputs and has room for na + nb limbs.
+
+size_t Bigint::karatsubaThreshold = 24;
+size_t Bigint::toomThreshold = 160;
+size_t Bigint::nttThreshold = 6144;
+vio::ThreadPool * Bigint::pool = 0;
+
+static uint64_t add_limbs(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb) // r = a + b, na >= nb, returns the carry
+{
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < nb; ++i) {
+        uint128 sum = (uint128) a[i] + b[i] + carry;
+        r[i] = (uint64_t) sum;
+        carry = (uint64_t) (sum >> 64);
+    }
+    for (; i < na; ++i) {
+        r[i] = a[i] + carry;
+        carry = carry && r[i] == 0;
+    }
+    return carry;
+}
+
+static uint64_t sub_limbs(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb) // r = a - b, na >= nb, returns the borrow
+{
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < nb; ++i) {
+        uint64_t d = a[i] - b[i] - borrow;
+        borrow = (a[i] < b[i]) || (a[i] - b[i] < borrow);
+        r[i] = d;
+    }
+    for (; i < na; ++i) {
+        uint64_t x = a[i]; // r may be a
+        r[i] = x - borrow;
+        borrow = borrow && x == 0;
+    }
+    return borrow;
+}
+
+static size_t significant_limbs(const uint64_t *a, size_t n)
+{
+    while (n > 0 && a[n-1] == 0) --n;
+    return n;
+}
+
+static void add_at(uint64_t *r, size_t nr, const uint64_t *a, size_t na) // r += a, the sum fits in nr limbs
+{
+    add_limbs(r, r, nr, a, significant_limbs(a, na));
+}
+
+static void submul_small(uint64_t *r, size_t nr, const uint64_t *a, size_t na, uint64_t b) // r -= a * b, the result is positive
+{
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < na; ++i) {
+        uint128 t = (uint128) a[i] * b + borrow;
+        uint64_t low = (uint64_t) t;
+        borrow = (uint64_t) (t >> 64) + (r[i] < low);
+        r[i] -= low;
+    }
+    for (; borrow && i < nr; ++i) {
+        uint64_t x = r[i];
+        r[i] = x - borrow;
+        borrow = x < borrow;
+    }
+}
+
+static void shift_right_1(uint64_t *r, size_t n)
+{
+    for (size_t i(0); i + 1 < n; ++i) r[i] = (r[i] >> 1) | (r[i+1] << 63);
+    r[n-1] >>= 1;
+}
+
+static void divexact_3(uint64_t *r, size_t n) // r /= 3 when r is a multiple of 3, with the inverse of 3 modulo 2^64
+{
+    const uint64_t inverse = 0xAAAAAAAAAAAAAAABULL;
+    uint64_t borrow = 0;
+    for (size_t i(0); i < n; ++i) {
+        uint64_t x = r[i];
+        uint64_t d = x - borrow;
+        borrow = x < borrow;
+        uint64_t q = d * inverse;
+        r[i] = q;
+        borrow += (uint64_t) (((uint128) q * 3) >> 64);
+    }
+}
+
+// a - b or b - a, whichever is positive, in r (n limbs). Returns true if a < b.
+static bool abs_diff(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    bool less = compare_limbs(a, significant_limbs(a, n), b, significant_limbs(b, n)) < 0;
+    if (less) sub_limbs(r, b, n, a, n);
+    else sub_limbs(r, a, n, b, n);
+    return less;
+}
+
+static void mul_limbs(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb);
+
+static void mul_schoolbook(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    memset(r, 0, (na + nb) * sizeof(uint64_t));
+    for (size_t i(0); i < na; ++i) {
+        uint64_t carry = 0;
+        const uint64_t ai = a[i];
+        for (size_t j(0); j < nb; ++j) {
+            uint128 t = (uint128) ai * b[j] + r[i + j] + carry;
+            r[i + j] = (uint64_t) t;
+            carry = (uint64_t) (t >> 64);
+        }
+        r[i + nb] = carry;
+    }
+}
+
+// n x n limbs. With a = a0 + a1 X and b = b0 + b1 X:
+// a b = a0 b0 + (a0 b0 + a1 b1 - (a0 - a1)(b0 - b1)) X + a1 b1 X^2, 3 products of n / 2 limbs.
+static void mul_karatsuba(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    const size_t h = n / 2, hh = n - h; // low and high halves, hh >= h
+    mul_limbs(r, a, h, b, h);
+    mul_limbs(r + 2 * h, a + h, hh, b + h, hh);
+
+    std::vector<uint64_t> t(6 * hh + 1, 0);
+    uint64_t *da = t.data(), *db = da + hh, *m = db + hh, *middle = m + 2 * hh; // middle has 2 hh + 1 limbs
+    const size_t nm = 2 * hh + 1;
+    memcpy(da, a, h * sizeof(uint64_t)); // a0 padded to hh limbs
+    memcpy(db, b, h * sizeof(uint64_t));
+    bool negative = abs_diff(da, da, a + h, hh) != abs_diff(db, db, b + h, hh);
+    mul_limbs(m, da, hh, db, hh);
+
+    memcpy(middle, r, 2 * h * sizeof(uint64_t));
+    add_at(middle, nm, r + 2 * h, 2 * hh);
+    if (negative) add_at(middle, nm, m, 2 * hh);
+    else sub_limbs(middle, middle, nm, m, 2 * hh);
+    add_at(r + h, 2 * n - h, middle, nm);
+}
+
+// n x n limbs, split in 3 parts of k limbs: a = a0 + a1 X + a2 X^2. The product c0 + c1 X + ... + c4 X^4
+// is found from its values at 0, 1, -1, 2 and infinity, 5 products of about n / 3 limbs.
+static void mul_toom3(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n)
+{
+    const size_t k = (n + 2) / 3, s = n - 2 * k; // a2 and b2 have s limbs
+    const size_t e = k + 1, L = 2 * e; // size of the evaluations and of their products
+
+    // p(1) = a0 + a1 + a2, p(2) = a0 + 2 a1 + 4 a2, |p(-1)| = |a0 + a2 - a1|
+    std::vector<uint64_t> values(6 * e, 0);
+    uint64_t *p1 = values.data(), *p2 = p1 + e, *pm1 = p2 + e;
+    uint64_t *q1 = pm1 + e, *q2 = q1 + e, *qm1 = q2 + e;
+    bool negative = false;
+    for (int side = 0; side < 2; ++side) {
+        const uint64_t *x = side ? b : a;
+        uint64_t *v1 = side ? q1 : p1, *v2 = side ? q2 : p2, *vm1 = side ? qm1 : pm1;
+        uint128 c02 = 0, c1 = 0, c2 = 0;
+        for (size_t i(0); i < e; ++i) {
+            uint128 x0 = i < k ? x[i] : 0, x1 = i < k ? x[k + i] : 0, x2 = i < s ? x[2 * k + i] : 0;
+            c02 += x0 + x2;
+            c1 += x0 + x1 + x2;
+            c2 += x0 + 2 * x1 + 4 * x2;
+            vm1[i] = (uint64_t) c02; // a0 + a2 for now
+            v1[i] = (uint64_t) c1;
+            v2[i] = (uint64_t) c2;
+            c02 >>= 64;
+            c1 >>= 64;
+            c2 >>= 64;
+        }
+        std::vector<uint64_t> x1(e, 0);
+        std::copy(x + k, x + 2 * k, x1.begin());
+        negative ^= abs_diff(vm1, vm1, x1.data(), e);
+    }
+
+    std::vector<uint64_t> products(3 * L, 0);
+    uint64_t *v1 = products.data(), *vm1 = v1 + L, *v2 = vm1 + L;
+    mul_limbs(v1, p1, e, q1, e);
+    mul_limbs(vm1, pm1, e, qm1, e);
+    mul_limbs(v2, p2, e, q2, e);
+    memset(r, 0, 2 * n * sizeof(uint64_t));
+    mul_limbs(r, a, k, b, k); // c0, in place
+    mul_limbs(r + 4 * k, a + 2 * k, s, b + 2 * k, s); // c4, in place
+    const uint64_t *c0 = r, *c4 = r + 4 * k;
+    const size_t n0 = 2 * k, n4 = 2 * s;
+
+    // c2 = (v(1) + v(-1)) / 2 - c0 - c4, c1 + c3 = (v(1) - v(-1)) / 2, c1 + 4 c3 = (v(2) - c0 - 4 c2 - 16 c4) / 2
+    std::vector<uint64_t> interpolation(3 * L, 0);
+    uint64_t *c2 = interpolation.data(), *u = c2 + L, *w = u + L;
+    if (negative) {
+        sub_limbs(c2, v1, L, vm1, L);
+        add_limbs(u, v1, L, vm1, L);
+    } else {
+        add_limbs(c2, v1, L, vm1, L);
+        sub_limbs(u, v1, L, vm1, L);
+    }
+    shift_right_1(c2, L);
+    shift_right_1(u, L);
+    sub_limbs(c2, c2, L, c0, n0);
+    sub_limbs(c2, c2, L, c4, n4);
+    memcpy(w, v2, L * sizeof(uint64_t));
+    sub_limbs(w, w, L, c0, n0);
+    submul_small(w, L, c2, L, 4);
+    submul_small(w, L, c4, n4, 16);
+    shift_right_1(w, L);
+    // c3 = (c1 + 4 c3 - (c1 + c3)) / 3, c1 = c1 + c3 - c3
+    sub_limbs(w, w, L, u, L);
+    divexact_3(w, L);
+    sub_limbs(u, u, L, w, L);
+
+    add_at(r + k, 2 * n - k, u, L);
+    add_at(r + 2 * k, 2 * n - 2 * k, c2, L);
+    add_at(r + 3 * k, 2 * n - 3 * k, w, L);
+}
+
+// Number theoretic transforms modulo the primes 998244353, 167772161 and 469762049 (c 2^k + 1, 3 is a generator of all of them).
+// The operands are cut in 32 bit pieces, their cyclic convolution is computed modulo each prime and the exact
+// coefficients (less than 2^86) are rebuilt with the chinese remainder theorem.
+template<uint32_t P>
+struct ntt_prime {
+    static uint32_t mul(uint32_t a, uint32_t b) { return (uint32_t) ((uint64_t) a * b % P); }
+    static uint32_t add(uint32_t a, uint32_t b) { uint32_t r = a + b; return r >= P ? r - P : r; }
+    static uint32_t sub(uint32_t a, uint32_t b) { return a >= b ? a - b : a + P - b; }
+    static uint32_t pow(uint32_t a, uint64_t e)
+    {
+        uint32_t r = 1;
+        for (; e; e >>= 1, a = mul(a, a)) {
+            if (e & 1) r = mul(r, a);
+        }
+        return r;
+    }
+    static uint32_t inverse(uint32_t a) { return pow(a, P - 2); }
+};
+
+static const uint32_t ntt_p1 = 998244353, ntt_p2 = 167772161, ntt_p3 = 469762049;
+static const size_t ntt_max_length = (size_t) 1 << 23; // the largest power of 2 dividing every p - 1
+static const size_t ntt_block = 4096; // the stages working on blocks of this size are done block by block, in cache
+
+// [0,count) split between the threads of the pool, or on the calling thread.
+static void ntt_parallel(size_t count, size_t grain, const std::function<void(u32, u32, u32)> &fn)
+{
+    if (Bigint::pool && count > grain) Bigint::pool->parallelFor(count, grain, fn);
+    else fn(0, count, 0);
+}
+
+// roots[len + j] = w^j, w a root of unity of order 2 len, for every power of 2 len < n.
+// quotients[len + j] = floor(w^j 2^32 / P), to multiply by w^j without a division (Shoup).
+template<uint32_t P>
+static void ntt_roots(std::vector<uint32_t> &roots, std::vector<uint32_t> &quotients, size_t n)
+{
+    typedef ntt_prime<P> F;
+    roots.resize(std::max<size_t>(n, 2));
+    quotients.resize(roots.size());
+    for (size_t len = 1; len < n; len <<= 1) {
+        uint32_t w = F::pow(3, (P - 1) / (2 * len));
+        roots[len] = 1;
+        for (size_t j = 1; j < len; ++j) roots[len + j] = F::mul(roots[len + j - 1], w);
+    }
+    for (size_t i(0); i < roots.size(); ++i) quotients[i] = (uint32_t) (((uint64_t) roots[i] << 32) / P);
+}
+
+template<uint32_t P>
+static inline uint32_t mul_root(uint32_t a, uint32_t w, uint32_t quotient) // a w mod P
+{
+    uint32_t q = (uint32_t) (((uint64_t) a * quotient) >> 32);
+    uint32_t r = a * w - q * P; // in [0, 2P)
+    return r >= P ? r - P : r;
+}
+
+// Calls butterfly(i, len, j) for the butterflies begin to end of the stage of half size len:
+// butterfly t pairs i = 2 (t - j) + j and i + len, j = t mod len.
+template<typename Butterfly>
+static inline void ntt_stage(size_t len, size_t begin, size_t end, const Butterfly &butterfly)
+{
+    for (size_t t = begin; t < end;) {
+        size_t j = t & (len - 1), base = (t - j) * 2, run = std::min(len - j, end - t);
+        for (size_t k = j; k < j + run; ++k) butterfly(base + k, len, k);
+        t += run;
+    }
+}
+
+// Decimation in frequency: natural order in, bit reversed order out.
+template<uint32_t P>
+static void ntt_forward(uint32_t *a, size_t n, const uint32_t *roots, const uint32_t *quotients)
+{
+    typedef ntt_prime<P> F;
+    auto butterfly = [=](size_t i, size_t len, size_t j) {
+        uint32_t u = a[i], v = a[i + len];
+        a[i] = F::add(u, v);
+        a[i + len] = mul_root<P>(F::sub(u, v), roots[len + j], quotients[len + j]);
+    };
+    const size_t block = std::min(n, ntt_block);
+    for (size_t len = n / 2; len >= block; len >>= 1) {
+        ntt_parallel(n / 2, 1 << 14, [&](u32 begin, u32 end, u32) { ntt_stage(len, begin, end, butterfly); });
+    }
+    ntt_parallel(n / block, 1, [&](u32 begin, u32 end, u32) {
+        for (size_t b = begin; b < end; ++b) {
+            for (size_t l = block / 2; l >= 1; l >>= 1) ntt_stage(l, b * block / 2, (b + 1) * block / 2, butterfly);
+        }
+    });
+}
+
+// Decimation in time with the inverse roots: bit reversed order in, natural order out, times n.
+// w^-j = -w^(len - j) since w^len = -1, the roots of the forward transform are used backwards.
+template<uint32_t P>
+static void ntt_inverse(uint32_t *a, size_t n, const uint32_t *roots, const uint32_t *quotients)
+{
+    typedef ntt_prime<P> F;
+    auto butterfly = [=](size_t i, size_t len, size_t j) {
+        uint32_t u = a[i];
+        if (j == 0) {
+            uint32_t v = a[i + len];
+            a[i] = F::add(u, v);
+            a[i + len] = F::sub(u, v);
+        } else {
+            uint32_t v = mul_root<P>(a[i + len], roots[2 * len - j], quotients[2 * len - j]); // -a[i + len] w^-j
+            a[i] = F::sub(u, v);
+            a[i + len] = F::add(u, v);
+        }
+    };
+    const size_t block = std::min(n, ntt_block);
+    ntt_parallel(n / block, 1, [&](u32 begin, u32 end, u32) {
+        for (size_t b = begin; b < end; ++b) {
+            for (size_t l = 1; l < block; l <<= 1) ntt_stage(l, b * block / 2, (b + 1) * block / 2, butterfly);
+        }
+    });
+    for (size_t len = block; len < n; len <<= 1) {
+        ntt_parallel(n / 2, 1 << 14, [&](u32 begin, u32 end, u32) { ntt_stage(len, begin, end, butterfly); });
+    }
+}
+
+static void ntt_pieces(uint32_t *out, size_t n, const uint64_t *a, size_t na) // 32 bit pieces, zero padded to n
+{
+    memset(out, 0, n * sizeof(uint32_t));
+    for (size_t i(0); i < na; ++i) {
+        out[2 * i] = (uint32_t) a[i];
+        out[2 * i + 1] = (uint32_t) (a[i] >> 32);
+    }
+}
+
+// The cyclic convolution of a and b modulo P, in residues (n values).
+template<uint32_t P>
+static void ntt_convolution(uint32_t *residues, uint32_t *scratch, size_t n,
+                            const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    typedef ntt_prime<P> F;
+    std::vector<uint32_t> roots, quotients;
+    ntt_roots<P>(roots, quotients, n);
+    ntt_pieces(residues, n, a, na); // less than 2^32, reduced modulo P below
+    ntt_parallel(n, 1 << 16, [&](u32 begin, u32 end, u32) {
+        for (size_t i = begin; i < end; ++i) residues[i] %= P;
+    });
+    ntt_forward<P>(residues, n, roots.data(), quotients.data());
+    const bool square = a == b && na == nb;
+    if (!square) {
+        ntt_pieces(scratch, n, b, nb);
+        ntt_parallel(n, 1 << 16, [&](u32 begin, u32 end, u32) {
+            for (size_t i = begin; i < end; ++i) scratch[i] %= P;
+        });
+        ntt_forward<P>(scratch, n, roots.data(), quotients.data());
+    }
+    const uint32_t scale = F::inverse((uint32_t) n); // the inverse transform multiplies by n
+    const uint32_t *other = square ? residues : scratch;
+    ntt_parallel(n, 1 << 16, [&](u32 begin, u32 end, u32) {
+        for (size_t i = begin; i < end; ++i) residues[i] = F::mul(F::mul(residues[i], other[i]), scale);
+    });
+    ntt_inverse<P>(residues, n, roots.data(), quotients.data());
+}
+
+static bool ntt_fits(size_t na, size_t nb)
+{
+    // every coefficient is a sum of at most 2 min(na, nb) products of two 32 bit pieces, all of them are below p1 p2 p3.
+    const uint128 modulus = (uint128) ntt_p1 * ntt_p2 * ntt_p3;
+    const uint128 largest = (uint128) (2 * std::min(na, nb)) * (0xffffffffULL * 0xffffffffULL);
+    return largest < modulus && 2 * (na + nb) <= ntt_max_length;
+}
+
+static void mul_ntt(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    size_t n = 1;
+    while (n < 2 * (na + nb)) n <<= 1;
+    std::vector<uint32_t> buffer(4 * n);
+    uint32_t *r1 = buffer.data(), *r2 = r1 + n, *r3 = r2 + n, *scratch = r3 + n;
+    ntt_convolution<ntt_p1>(r1, scratch, n, a, na, b, nb);
+    ntt_convolution<ntt_p2>(r2, scratch, n, a, na, b, nb);
+    ntt_convolution<ntt_p3>(r3, scratch, n, a, na, b, nb);
+
+    // Chinese remainders (Garner), x = x1 + p1 (t2 + p2 t3), and the carries, chunk by chunk:
+    // each chunk propagates its own carries, the carries between the chunks are added afterwards.
+    typedef ntt_prime<ntt_p2> F2;
+    typedef ntt_prime<ntt_p3> F3;
+    const uint32_t inv_p1 = F2::inverse(ntt_p1 % ntt_p2);
+    const uint32_t inv_p1p2 = F3::inverse(F3::mul(ntt_p1 % ntt_p3, ntt_p2 % ntt_p3));
+    const uint64_t p1p2 = (uint64_t) ntt_p1 * ntt_p2;
+    const size_t pieces = 2 * (na + nb), chunk = 1 << 16, chunks = (pieces + chunk - 1) / chunk;
+    uint32_t *out = scratch; // the product in 32 bit pieces
+    std::vector<uint128> chunk_carry(chunks);
+    ntt_parallel(chunks, 1, [&](u32 begin, u32 end, u32) {
+        for (size_t c = begin; c < end; ++c) {
+            uint128 carry = 0;
+            for (size_t i = c * chunk; i < std::min(pieces, (c + 1) * chunk); ++i) {
+                uint32_t x1 = r1[i];
+                uint32_t t2 = F2::mul(F2::sub(r2[i], x1 % ntt_p2), inv_p1);
+                uint64_t x12 = x1 + (uint64_t) ntt_p1 * t2;
+                uint32_t t3 = F3::mul(F3::sub(r3[i], (uint32_t) (x12 % ntt_p3)), inv_p1p2);
+                carry += x12 + (uint128) p1p2 * t3;
+                out[i] = (uint32_t) carry;
+                carry >>= 32;
+            }
+            chunk_carry[c] = carry;
+        }
+    });
+    uint128 carry = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        for (size_t i = c * chunk; carry && i < std::min(pieces, (c + 1) * chunk); ++i) {
+            carry += out[i];
+            out[i] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        carry += chunk_carry[c];
+    }
+    for (size_t i(0); i < na + nb; ++i) r[i] = out[2 * i] | ((uint64_t) out[2 * i + 1] << 32);
+}
+
+// na >= nb or not, r has na + nb limbs.
+static void mul_limbs(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < std::max<size_t>(Bigint::karatsubaThreshold, 2)) {
+        mul_schoolbook(r, a, na, b, nb);
+        return;
+    }
+    if (nb >= Bigint::nttThreshold && ntt_fits(na, nb)) { // larger products are cut by toom3 or in pieces of nb limbs
+        mul_ntt(r, a, na, b, nb);
+        return;
+    }
+    if (na == nb) {
+        if (na < std::max<size_t>(Bigint::toomThreshold, 5)) mul_karatsuba(r, a, b, na); // toom3 needs 3 non empty parts
+        else mul_toom3(r, a, b, na);
+        return;
+    }
+    // unbalanced: a is cut in pieces of nb limbs, multiplied by b one after the other.
+    memset(r, 0, (na + nb) * sizeof(uint64_t));
+    std::vector<uint64_t> t(2 * nb);
+    for (size_t i = 0; i < na; i += nb) {
+        size_t piece = std::min(nb, na - i);
+        mul_limbs(t.data(), a + i, piece, b, nb);
+        add_at(r + i, na + nb - i, t.data(), piece + nb);
+    }
+}
+
+Bigint Bigint::operator*(Bigint const &b)
+{
+    Bigint c;
+    if (limbs.empty() || b.limbs.empty()) return c;
+    c.limbs.resize(limbs.size() + b.limbs.size());
+    mul_limbs(c.limbs.data(), limbs.data(), limbs.size(), b.limbs.data(), b.limbs.size());
+    c.trim();
+    c.positive = positive == b.positive;
+
+    return c;
+}
+
+Bigint &Bigint::operator*=(Bigint const &b)
+{
+    *this = *this * b;
+
+    return *this;
+}
+
+Bigint Bigint::operator*(long long const &b)
+{
+    Bigint c = *this;
+    c.mulSmall(b >= 0 ? (uint64_t) b : 0 - (uint64_t) b);
+    if (b < 0) c.positive = !c.positive;
+    if (c.limbs.empty()) c.positive = true;
+
+    return c;
+}
+
+Bigint &Bigint::operator*=(int const &b)
+{
+    mulSmall(b >= 0 ? (uint64_t) b : 0 - (uint64_t) (long long) b);
+    if (b < 0) positive = !positive;
+    if (limbs.empty()) positive = true;
+
+    return *this;
+}
+
+//Power
+Bigint &Bigint::pow(int const &power)
+{
+    // square and multiply
+    Bigint result = 1;
+    Bigint square = *this;
+    for (int p = power; p > 0; p >>= 1) {
+        if (p & 1) result *= square;
+        if (p > 1) square *= square;
+    }
+    *this = result;
+
+    return *this;
+}
+
+//Compare
+int Bigint::compare(const Bigint &a) const //0 this == a || -1 this < a || 1 this > a
+{
+    if (positive && !a.positive) return 1;
+    if (!positive && a.positive) return -1;
+
+    int check = 1;
+    if (!positive && !a.positive) check = -1;
+
+    return check * compare_limbs(limbs.data(), limbs.size(), a.limbs.data(), a.limbs.size());
+}
+
+bool Bigint::operator<(Bigint const &b) const
+{
+    return compare(b) == -1;
+}
+
+bool Bigint::operator<=(const Bigint &b) const
+{
+    int compared = compare(b);
+
+    return compared == 0 || compared == -1;
+}
+
+bool Bigint::operator>(const Bigint &b) const
+{
+    return compare(b) == 1;
+}
+
+bool Bigint::operator>=(const Bigint &b) const
+{
+    int compared = compare(b);
+
+    return compared == 0 || compared == 1;
+}
+
+bool Bigint::operator==(Bigint const &b) const
+{
+    return compare(b) == 0;
+}
+
+bool Bigint::operator!=(Bigint const &b) const
+{
+    return ! (*this == b);
+}
+
+//Allocation
+Bigint &Bigint::operator=(const Bigint &a)
+{
+    limbs = a.limbs;
+    positive = a.positive;
+
+    return *this;
+}
+
+Bigint Bigint::operator=(const long long &a)
+{
+    *this = Bigint(a);
+
+    return *this;
+}
+
+//Access
+int Bigint::operator[](int const &b)
+{
+    return to_string(*this)[b] - '0';
+}
+
+//Trivia
+int Bigint::digits() const
+{
+    if (limbs.empty()) return 0;
+
+    // 2^(bits-1) <= |this| < 2^bits, so the number has floor((bits-1) log10(2)) + 1 to floor(bits log10(2)) + 1 digits,
+    // at most two values: one comparison with a power of ten decides. The margins cover the rounding of the products.
+    uint64_t bits = 64 * (limbs.size() - 1);
+    for (uint64_t top = limbs.back(); top != 0; top >>= 1) ++bits;
+    const double log10_2 = 0.30102999566398119521;
+    const int low = (int) ((bits - 1) * log10_2 - 1e-6) + 1;
+    const int high = (int) (bits * log10_2 + 1e-6) + 1;
+    if (low == high) return low;
+    Bigint power = 10;
+    power.pow(low); // the smallest number with high digits
+
+    return compare_limbs(limbs.data(), limbs.size(), power.limbs.data(), power.limbs.size()) < 0 ? low : high;
+}
+
+int Bigint::trailing_zeros() const
+{
+    if (limbs.empty()) return 1;
+
+    // 10^k divides the number when 2^k and 5^k do. The factors 2 are the trailing zero bits.
+    int twos = 0;
+    size_t first = 0;
+    while (limbs[first] == 0) {
+        twos += 64;
+        ++first;
+    }
+    for (uint64_t low = limbs[first]; (low & 1) == 0; low >>= 1) ++twos;
+    if (twos == 0) return 0;
+
+    // The factors 5, 27 at a time (5^27 is the largest power of 5 in a limb), then one at a time, no further than the 2s.
+    // Each exact division is one pass over a number that shrinks as it goes.
+    const uint64_t five27 = 7450580596923828125ULL;
+    std::vector<uint64_t> a(limbs), q(limbs.size());
+    size_t n = a.size();
+    uint64_t d = five27;
+    int step = 27;
+    int fives = 0;
+    while (fives < twos) {
+        if (!divide_exact(a.data(), n, d, inverse_limb(d), q.data())) {
+            if (step == 1) break;
+            d = 5;
+            step = 1;
+            continue;
+        }
+        a.swap(q);
+        while (a[n - 1] == 0) --n;
+        fives += step;
+    }
+
+    return fives < twos ? fives : twos;
+}
+
+size_t Bigint::limbCount() const
+{
+    return limbs.size();
+}
+
+//Helpers
+void Bigint::clear()
+{
+    limbs.clear();
+    positive = true;
+}
+
+Bigint &Bigint::abs()
+{
+    positive = true;
+
+    return *this;
+}
+
+//Input&Output
+std::ostream &operator<<(std::ostream &out, Bigint const &a)
+{
+    return out << to_string(a);
+}
+
+std::istream &operator>>(std::istream &in, Bigint &a)
+{
+    std::string str;
+    in >> str;
+
+    a = str;
+
+    return in;
+}
+
+Bigint abs(Bigint value)
+{
+    return value.abs();
+}
+
+std::string to_string(Bigint const &value)
+{
+    if (value.limbs.empty()) return "0";
+
+    // 19 digits at a time, from the least significant ones, written backwards.
+    // Each sweep divides by 10^19 four times: the remainder chains of the 4 divisions overlap,
+    // a single division per sweep would wait on the latency of the multiplications.
+    std::vector<uint64_t> q = value.limbs;
+    std::string out((q.size() / 3 + 1) * 4 * decimal_chunk_digits + 1, '0'); // a sweep removes more than 3 limbs
+    size_t end = out.size();
+    size_t n = q.size();
+    while (n > 0) {
+        uint64_t r[4] = {0, 0, 0, 0};
+        for (size_t i(n); i > 0; --i) {
+            uint64_t x = q[i-1];
+            x = div_decimal_chunk(r[0], x, &r[0]);
+            x = div_decimal_chunk(r[1], x, &r[1]);
+            x = div_decimal_chunk(r[2], x, &r[2]);
+            q[i-1] = div_decimal_chunk(r[3], x, &r[3]);
+        }
+        while (n > 0 && q[n-1] == 0) --n;
+        for (int k = 0; k < 4; ++k) {
+            size_t chunk_end = end - decimal_chunk_digits;
+            for (uint64_t chunk = r[k]; chunk; chunk /= 10) out[--end] = '0' + chunk % 10;
+            end = chunk_end; // keep the leading zeros of the inner chunks
+        }
+    }
+    while (out[end] == '0') ++end;
+    if (!value.positive) out[--end] = '-';
+
+    return out.substr(end);
+}
+
+// lo * (lo + 1) * ... * hi, by halves so that the large products are balanced and use the fast multiplications.
+Bigint Bigint::rangeProduct(uint64_t lo, uint64_t hi)
+{
+    if (hi < lo) return 1; // empty product
+    if (lo == 0) return Bigint();
+    if (hi - lo < 64) {
+        Bigint result = 1;
+        uint64_t packed = 1; // as many factors as fit in a limb per multiplication
+        for (uint64_t i = lo;; ++i) {
+            if (packed > ~(uint64_t) 0 / i) {
+                result.mulSmall(packed);
+                packed = 1;
+            }
+            packed *= i;
+            if (i == hi) break; // not i <= hi, hi can be the largest uint64_t
+        }
+        result.mulSmall(packed);
+        return result;
+    }
+    uint64_t mid = lo + (hi - lo) / 2;
+
+    return rangeProduct(lo, mid) * rangeProduct(mid + 1, hi);
+}
+
+Bigint Bigint::product(const uint64_t *factors, size_t count)
+{
+    if (count <= 64) {
+        Bigint result = 1;
+        uint64_t packed = 1;
+        for (size_t i(0); i < count; ++i) {
+            if (factors[i] == 0) return Bigint();
+            if (packed > ~(uint64_t) 0 / factors[i]) {
+                result.mulSmall(packed);
+                packed = 1;
+            }
+            packed *= factors[i];
+        }
+        result.mulSmall(packed);
+        return result;
+    }
+
+    return product(factors, count / 2) * product(factors + count / 2, count - count / 2);
+}
+
+Bigint factorial(int n)
+{
+    if (n < 2) return 1;
+
+    return Bigint::rangeProduct(2, n);
+}
+
+Bigint binomial(int n, int k)
+{
+    if (k < 0 || k > n) return 0;
+    k = std::min(k, n - k);
+
+    // the exponent of a prime p in n! / (k! (n - k)!) is the sum over the powers q of p of n/q - k/q - (n - k)/q (Legendre):
+    // the result is a product of prime powers, without any division.
+    std::vector<char> composite(n + 1, 0);
+    std::vector<uint64_t> factors;
+    for (long long p = 2; p <= n; ++p) {
+        if (composite[p]) continue;
+        for (long long m = p * p; m <= n; m += p) composite[m] = 1;
+        int exponent = 0;
+        for (long long q = p; q <= n; q *= p) exponent += n / q - k / q - (n - k) / q;
+        for (int e = 0; e < exponent; ++e) factors.push_back(p);
+    }
+
+    return Bigint::product(factors.data(), factors.size());
+}
@@ -1,80 +1,101 @@
-#ifndef DODECAHEDRON_BIGINT_H_
-#define DODECAHEDRON_BIGINT_H_
-
-#include <vector>
-#include <iostream>
-#include <map>
-
-// note: perf of this is probably shit.
-// the default base is not max int.
-// it does not exploit 64 bit operations.
-
-class Bigint{
-private:
-    std::vector<int> number;
-    bool positive;
-    int base;
-    unsigned int skip;
-    static const int default_base = 1000000000;
-public:
-    //Constructors
-    Bigint();
-    Bigint(long long);
-    Bigint(std::string);
-    Bigint(const Bigint& b);
-
-    //Adding
-    Bigint operator+(Bigint const &) const;
-    Bigint &operator+=(Bigint const &);
-    Bigint operator+(long long const &) const;
-    Bigint &operator+=(long long);
-
-    //Subtraction
-    Bigint operator-(Bigint const &) const;
-    Bigint &operator-=(Bigint const &);
-
-    //Multiplication
-    Bigint operator*(Bigint const &);
-    Bigint &operator*=(Bigint const &);
-    Bigint operator*(long long const &);
-    Bigint &operator*=(int const &);
-
-    //Compare
-    bool operator<(const Bigint &) const;
-    bool operator>(const Bigint &) const;
-    bool operator<=(const Bigint &) const;
-    bool operator>=(const Bigint &) const;
-    bool operator==(const Bigint &) const;
-    bool operator!=(const Bigint &) const;
-
-    //Allocation
-    Bigint operator=(const long long &);
-
-    //Access
-    int operator[](int const &);
-
-    //Input&Output
-    friend std::istream &operator>>(std::istream &, Bigint &);
-    friend std::ostream &operator<<(std::ostream &, Bigint const &);
-
-    //Helpers
-    void clear();
-    Bigint &abs();
-
-    //Power
-    Bigint &pow(int const &);
-
-    //Trivia
-    int digits() const;
-    int trailing_zeros() const;
-private:
-    int segment_length(int) const;
-    Bigint pow(int const &, std::map<int, Bigint> &);
-    int compare(Bigint const &) const; //0 a == b, -1 a < b, 1 a > b
-};
-
-Bigint abs(Bigint);
-std::string to_string(Bigint const &);
-Bigint factorial(int);
-
-#endif
\ No newline at end of file
+#ifndef DODECAHEDRON_BIGINT_H_
+#define DODECAHEDRON_BIGINT_H_
+
+#include <vector>
+#include <iostream>
+#include <map>
+#include <cstdint>
+
+namespace vio{
+    class ThreadPool;
+}
+
+// Arbitrary precision integers: sign and magnitude, the magnitude is stored in binary, in 64 bit limbs
+// (least significant first, no leading zero limb, 0 has no limbs).
+// The carries are propagated with 128 bit products, decimal is only used to read and print numbers.
+
+class Bigint{
+private:
+    std::vector<uint64_t> limbs;
+    bool positive;
+public:
+    //Constructors
+    Bigint();
+    Bigint(long long);
+    Bigint(std::string);
+    Bigint(const Bigint& b);
+
+    //Adding
+    Bigint operator+(Bigint const &) const;
+    Bigint &operator+=(Bigint const &);
+    Bigint operator+(long long const &) const;
+    Bigint &operator+=(long long);
+
+    //Subtraction
+    Bigint operator-(Bigint const &) const;
+    Bigint &operator-=(Bigint const &);
+
+    //Multiplication
+    Bigint operator*(Bigint const &);
+    Bigint &operator*=(Bigint const &);
+    Bigint operator*(long long const &);
+    Bigint &operator*=(int const &);
+
+    //Compare
+    bool operator<(const Bigint &) const;
+    bool operator>(const Bigint &) const;
+    bool operator<=(const Bigint &) const;
+    bool operator>=(const Bigint &) const;
+    bool operator==(const Bigint &) const;
+    bool operator!=(const Bigint &) const;
+
+    //Allocation
+    Bigint &operator=(const Bigint &);
+    Bigint operator=(const long long &);
+
+    //Access
+    int operator[](int const &);
+
+    //Input&Output
+    friend std::istream &operator>>(std::istream &, Bigint &);
+    friend std::ostream &operator<<(std::ostream &, Bigint const &);
+    friend std::string to_string(Bigint const &);
+
+    //Helpers
+    void clear();
+    Bigint &abs();
+
+    //Power
+    Bigint &pow(int const &);
+
+    //Trivia
+    int digits() const;
+    int trailing_zeros() const;
+    size_t limbCount() const; // number of 64 bit limbs of the magnitude
+
+    // Products of at least karatsubaThreshold limbs (both operands) use Karatsuba, toomThreshold limbs Toom-3,
+    // nttThreshold limbs number theoretic transforms, smaller ones the schoolbook method.
+    // Tuned with the bigint suite of src/bench.
+    static size_t karatsubaThreshold;
+    static size_t toomThreshold;
+    static size_t nttThreshold;
+    static vio::ThreadPool * pool; // when set, the transforms of the large products are split between its threads
+
+    static Bigint rangeProduct(uint64_t lo, uint64_t hi); // lo * (lo + 1) * ... * hi, 1 if hi < lo
+    static Bigint product(const uint64_t * factors, size_t count); // by a balanced tree, like rangeProduct
+private:
+    void addMagnitude(const uint64_t * b, size_t n); // |this| += b
+    void subMagnitude(const uint64_t * b, size_t n, bool reversed); // |this| = |this| - b, or b - |this| if reversed
+    void mulSmall(uint64_t b); // |this| *= b
+    uint64_t divSmall(uint64_t b); // |this| /= b, returns the remainder
+    void add(Bigint const &, bool negate); // this += b or this -= b
+    void trim();
+    int compare(Bigint const &) const; //0 a == b, -1 a < b, 1 a > b
+};
+
+Bigint abs(Bigint);
+std::string to_string(Bigint const &);
+Bigint factorial(int);
+Bigint binomial(int n, int k); // n! / (k! (n - k)!), 0 if k < 0 or k > n
+
+#endif
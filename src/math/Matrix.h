@@ -1,53 +1,65 @@
-#pragma once
-#include <cstdint>
-
-#include "utils/utils.h"
-#include "Vector.h"
-
-
-namespace vio{
-
-	struct Vector;
-
-	struct Matrix{
-	private:
-		u32 w;
-		u32 h;
-		// only rows need to be close in memory for vector evaluation.
-		// note that this means that multiplication can get very slow for large sizes.
-		float * matData;
-	public:
-		Matrix() = delete;
-		Matrix(u32 w,u32 h);
-		Matrix(const Matrix& m); // copy.
-		~Matrix();
-		Matrix& operator=(const Matrix& m); // assignement
-		Matrix& operator=(Matrix&& m); // move
-
-		u32 width() const;
-		u32 height() const;
-		float get(u32 y,u32 x) const;
-		float& at(u32 y,u32 x);
-
-		void fill(float v);
-		void fillRandom(float coef = 1,float mean = 0);
-		void transpose(); // assumes that w == h
-		Matrix transpose() const; // assumes nothing, requires a copy.
-
-		float normSquared() const;
-
-		void print(); // debug.
-
-		Matrix& operator+=(const Matrix& m);
-		Matrix& operator-=(const Matrix& m);
-		Matrix& operator*=(float v);
-		
-		Vector apply(const Vector& v) const; // returns this * v
-		Vector applyTranspose(const Vector& v) const; // returns v * transpose(this) (but without copies of this)
-
-		static Matrix mul(const Matrix& a,const Matrix& b);
-	};
-
-	// Add some data structure for GPU computation here.
-
-}
+#pragma once
+#include <cstdint>
+
+#include "utils/utils.h"
+#include "Vector.h"
+
+
+namespace vio{
+
+	struct Vector;
+	class RandomStream;
+
+	struct Matrix{
+	private:
+		u32 w;
+		u32 h;
+		// only rows need to be close in memory for vector evaluation.
+		// note that this means that multiplication can get very slow for large sizes.
+		float * matData;
+		bool owner = true; // false when matData points to memory we do not manage (a mapped model file for example)
+	public:
+		Matrix() = delete;
+		Matrix(u32 w,u32 h);
+		Matrix(u32 w,u32 h,float * external); // view over external memory, nothing is copied or freed.
+		Matrix(const Matrix& m); // copy.
+		~Matrix();
+		Matrix& operator=(const Matrix& m); // assignement
+		Matrix& operator=(Matrix&& m); // move
+
+		u32 width() const;
+		u32 height() const;
+		float get(u32 y,u32 x) const;
+		float& at(u32 y,u32 x);
+
+		float * data(); // row major, w*h floats
+		const float * data() const;
+		void bind(float * external); // drop the current storage and use external instead (same dimensions)
+
+		void fill(float v);
+		void fillRandom(float coef = 1,float mean = 0);
+		void fillRandom(RandomStream& rng,float dev = 1,float mean = 0); // uniform in [mean-dev,mean+dev)
+		void fillGaussian(RandomStream& rng,float dev = 1,float mean = 0);
+		void transpose(); // assumes that w == h
+		Matrix transpose() const; // assumes nothing, requires a copy.
+
+		float normSquared() const;
+
+		void print(); // debug.
+
+		Matrix& operator+=(const Matrix& m);
+		Matrix& operator-=(const Matrix& m);
+		Matrix& operator*=(float v);
+		Matrix& operator/=(float v);
+		
+		Vector apply(const Vector& v) const; // returns this * v
+		void apply(const Vector& v,Vector& res) const; // res = this * v, without allocating. res must have the right size.
+		Vector applyTranspose(const Vector& v) const; // returns v * transpose(this) (but without copies of this)
+		void applyTranspose(const Vector& v,Vector& res) const; // same, without allocating. res must have the right size.
+
+		static Matrix mul(const Matrix& a,const Matrix& b);
+	};
+
+	// Add some data structure for GPU computation here.
+
+}
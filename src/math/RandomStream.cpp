@@ -0,0 +1,270 @@
+#include "RandomStream.h"
+#include "utils/ThreadPool.h"
+#include "math.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace vio{
+
+	static constexpr u32 PHILOX_M0 = 0xD2511F53;
+	static constexpr u32 PHILOX_M1 = 0xCD9E8D57;
+	static constexpr u32 PHILOX_W0 = 0x9E3779B9;
+	static constexpr u32 PHILOX_W1 = 0xBB67AE85;
+	static constexpr u32 LANES = 8; // blocks computed together by the scalar version
+
+#ifdef __SSE2__
+	// 4 blocks at once, one block per lane. Returns the high and low halves of m * x for the 4 lanes of x.
+	static inline void mulhilo(__m128i x,__m128i m,__m128i& hi,__m128i& lo){
+		const __m128i even = _mm_shuffle_epi32(_mm_mul_epu32(x,m),_MM_SHUFFLE(3,1,2,0)); // lo0 lo2 hi0 hi2
+		const __m128i odd = _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_epi64(x,32),m),_MM_SHUFFLE(3,1,2,0)); // lo1 lo3 hi1 hi3
+		lo = _mm_unpacklo_epi32(even,odd);
+		hi = _mm_unpackhi_epi32(even,odd);
+	}
+	// SETS groups of 4 blocks are interleaved to hide the latency of the multiplications.
+	static constexpr u32 SETS = 2;
+	static void philoxBlocksSSE(uint64_t key,uint64_t first,uint64_t stream,u32 * out){
+		__m128i x0[SETS],x1[SETS],x2[SETS],x3[SETS];
+		for(u32 s = 0;s < SETS;s++){
+			const uint64_t b = first + 4 * s;
+			// low words of the 4 counters in x0, high words in x1
+			x0[s] = _mm_set_epi32((u32)(b + 3),(u32)(b + 2),(u32)(b + 1),(u32)b);
+			x1[s] = _mm_set_epi32((u32)((b + 3) >> 32),(u32)((b + 2) >> 32),(u32)((b + 1) >> 32),(u32)(b >> 32));
+			x2[s] = _mm_set1_epi32((u32)stream);
+			x3[s] = _mm_set1_epi32((u32)(stream >> 32));
+		}
+		const __m128i m0 = _mm_set1_epi32(PHILOX_M0),m1 = _mm_set1_epi32(PHILOX_M1);
+		u32 k0 = (u32)key,k1 = (u32)(key >> 32);
+		for(u32 r = 0;r < 10;r++){
+			const __m128i key0 = _mm_set1_epi32(k0),key1 = _mm_set1_epi32(k1);
+			for(u32 s = 0;s < SETS;s++){
+				__m128i hi0,lo0,hi1,lo1;
+				mulhilo(x0[s],m0,hi0,lo0);
+				mulhilo(x2[s],m1,hi1,lo1);
+				x0[s] = _mm_xor_si128(_mm_xor_si128(hi1,x1[s]),key0);
+				x1[s] = lo1;
+				x2[s] = _mm_xor_si128(_mm_xor_si128(hi0,x3[s]),key1);
+				x3[s] = lo0;
+			}
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+		for(u32 s = 0;s < SETS;s++){
+			// transpose: one block per row
+			const __m128i t0 = _mm_unpacklo_epi32(x0[s],x1[s]),t1 = _mm_unpacklo_epi32(x2[s],x3[s]);
+			const __m128i t2 = _mm_unpackhi_epi32(x0[s],x1[s]),t3 = _mm_unpackhi_epi32(x2[s],x3[s]);
+			__m128i * o = (__m128i*)(out + 16 * s);
+			_mm_storeu_si128(o,_mm_unpacklo_epi64(t0,t1));
+			_mm_storeu_si128(o + 1,_mm_unpackhi_epi64(t0,t1));
+			_mm_storeu_si128(o + 2,_mm_unpacklo_epi64(t2,t3));
+			_mm_storeu_si128(o + 3,_mm_unpackhi_epi64(t2,t3));
+		}
+	}
+#endif
+
+	// Writes the 4 * count numbers of the blocks [first,first+count) of a stream.
+	static void philoxBlocks(uint64_t key,uint64_t first,uint64_t stream,size_t count,u32 * out){
+#ifdef __SSE2__
+		for(;count >= 4 * SETS;count -= 4 * SETS,first += 4 * SETS,out += 16 * SETS){
+			philoxBlocksSSE(key,first,stream,out);
+		}
+#endif
+		for(size_t base = 0;base < count;base += LANES){
+			u32 c0[LANES],c1[LANES],c2[LANES],c3[LANES];
+			for(u32 l = 0;l < LANES;l++){
+				const uint64_t b = first + base + l;
+				c0[l] = (u32)b;
+				c1[l] = (u32)(b >> 32);
+				c2[l] = (u32)stream;
+				c3[l] = (u32)(stream >> 32);
+			}
+			u32 k0 = (u32)key,k1 = (u32)(key >> 32);
+			for(u32 r = 0;r < 10;r++){
+				for(u32 l = 0;l < LANES;l++){
+					const uint64_t p0 = (uint64_t)PHILOX_M0 * c0[l];
+					const uint64_t p1 = (uint64_t)PHILOX_M1 * c2[l];
+					c0[l] = (u32)(p1 >> 32) ^ c1[l] ^ k0;
+					c1[l] = (u32)p1;
+					c2[l] = (u32)(p0 >> 32) ^ c3[l] ^ k1;
+					c3[l] = (u32)p0;
+				}
+				k0 += PHILOX_W0;
+				k1 += PHILOX_W1;
+			}
+			const size_t used = count - base < LANES ? count - base : LANES;
+			for(u32 l = 0;l < used;l++){
+				u32 * o = out + 4 * (base + l);
+				o[0] = c0[l];
+				o[1] = c1[l];
+				o[2] = c2[l];
+				o[3] = c3[l];
+			}
+		}
+	}
+
+	// splitmix64 finalizer
+	static inline uint64_t mix64(uint64_t z){
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	static inline float toFloat(u32 x){ // 24 bits, in [0,1)
+		return (x >> 8) * (1.0f / 16777216.0f);
+	}
+	// Box-Muller: the pair (a,b) gives 2 independent gaussians.
+	static inline void toGaussians(u32 a,u32 b,float& even,float& odd){
+		const double u1 = (a + 0.5) / 4294967296.0; // in (0,1), the log is defined
+		const double angle = 6.283185307179586 * (b / 4294967296.0);
+		const double r = std::sqrt(-2 * std::log(u1));
+		even = r * std::cos(angle);
+		odd = r * std::sin(angle);
+	}
+
+	// Ranges larger than this are split between the threads of the pool.
+	static constexpr size_t PARALLEL_CHUNK = 1 << 16;
+
+	// Calls fill(stream at position + begin,out + begin,size) for every chunk of [0,n).
+	template<typename F>
+	static void forChunks(const RandomStream& rng,size_t n,ThreadPool * pool,const F& fill){
+		if(pool == 0 || n <= PARALLEL_CHUNK){
+			fill(rng,(size_t)0,n);
+			return;
+		}
+		const u32 chunks = (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+		pool->parallelFor(chunks,1,[&](u32 begin,u32 end,u32 worker){
+			for(u32 c = begin;c < end;c++){
+				const size_t first = (size_t)c * PARALLEL_CHUNK;
+				RandomStream part = rng;
+				part.skip(first);
+				fill(part,first,n - first < PARALLEL_CHUNK ? n - first : PARALLEL_CHUNK);
+			}
+		});
+	}
+
+	RandomStream::RandomStream(uint64_t key,uint64_t stream){
+		this->key = key;
+		this->stream = stream;
+	}
+	RandomStream RandomStream::fromGlobal(){
+		const uint64_t high = randomU32(0xFFFFFFFF);
+		return RandomStream(high << 32 | randomU32(0xFFFFFFFF));
+	}
+	RandomStream RandomStream::split(uint64_t id) const{
+		return RandomStream(key,mix64(stream ^ mix64(id + 0x9e3779b97f4a7c15ULL)));
+	}
+
+	void RandomStream::block(uint64_t key,uint64_t counterLow,uint64_t counterHigh,u32 out[4]){
+		philoxBlocks(key,counterLow,counterHigh,1,out);
+	}
+
+	u32 RandomStream::nextU32(){
+		u32 b[4];
+		block(key,position / 4,stream,b);
+		return b[position++ % 4];
+	}
+	u32 RandomStream::nextU32(u32 max){
+		u32 p2 = max; // next power of 2 minus 1, see randomU32
+		p2 |= p2 >> 1;
+		p2 |= p2 >> 2;
+		p2 |= p2 >> 4;
+		p2 |= p2 >> 8;
+		p2 |= p2 >> 16;
+		u32 rnd;
+		do{
+			rnd = nextU32() & p2;
+		}while(rnd > max);
+		return rnd;
+	}
+	float RandomStream::nextFloat(){
+		return toFloat(nextU32());
+	}
+	float RandomStream::nextGaussian(){
+		u32 b[4];
+		block(key,position / 4,stream,b);
+		const u32 pair = position % 4 & ~1u;
+		float even,odd;
+		toGaussians(b[pair],b[pair + 1],even,odd);
+		return position++ % 2 == 0 ? even : odd;
+	}
+
+	void RandomStream::fillU32(u32 * out,size_t n,ThreadPool * pool){
+		forChunks(*this,n,pool,[&](const RandomStream& rng,size_t first,size_t size){
+			u32 * o = out + first;
+			uint64_t p = rng.position;
+			// the end of the current block, then whole blocks straight into out, then the beginning of the last one.
+			u32 b[4];
+			if(p % 4 != 0 && size > 0){
+				block(rng.key,p / 4,rng.stream,b);
+				while(p % 4 != 0 && size > 0){
+					*o++ = b[p++ % 4];
+					size--;
+				}
+			}
+			const size_t whole = size / 4;
+			philoxBlocks(rng.key,p / 4,rng.stream,whole,o);
+			o += 4 * whole;
+			p += 4 * whole;
+			size -= 4 * whole;
+			if(size > 0){
+				block(rng.key,p / 4,rng.stream,b);
+				for(size_t i = 0;i < size;i++) o[i] = b[i];
+			}
+		});
+		position += n;
+	}
+
+	void RandomStream::fillUniform(float * out,size_t n,float low,float high,ThreadPool * pool){
+		const float range = high - low;
+		forChunks(*this,n,pool,[&](const RandomStream& rng,size_t first,size_t size){
+			RandomStream part = rng;
+			u32 buffer[1024];
+			for(size_t done = 0;done < size;done += 1024){
+				const size_t s = size - done < 1024 ? size - done : 1024;
+				part.fillU32(buffer,s);
+				float * o = out + first + done;
+				for(size_t i = 0;i < s;i++) o[i] = low + range * toFloat(buffer[i]);
+			}
+		});
+		position += n;
+	}
+
+	void RandomStream::fillGaussian(float * out,size_t n,float mean,float deviation,ThreadPool * pool){
+		forChunks(*this,n,pool,[&](const RandomStream& rng,size_t first,size_t size){
+			if(size == 0) return;
+			// whole pairs of positions, the first and the last values may only use half of their pair.
+			RandomStream part = rng;
+			const bool odd = part.position % 2 == 1;
+			part.seek(part.position - odd);
+			u32 buffer[1024];
+			size_t i = 0;
+			size_t remaining = size + odd;
+			float * o = out + first;
+			while(remaining > 0){
+				const size_t s = remaining < 1024 ? remaining : 1024;
+				const size_t filled = s + (s % 2); // always whole pairs
+				part.fillU32(buffer,filled);
+				for(size_t j = 0;j < s;j += 2){
+					float even,oddValue;
+					toGaussians(buffer[j],buffer[j + 1],even,oddValue);
+					if(i > 0 || !odd) o[i++ - odd] = mean + deviation * even;
+					else i++; // the even half of the first pair is before the range
+					if(j + 1 < s) o[i++ - odd] = mean + deviation * oddValue;
+				}
+				remaining -= s;
+			}
+		});
+		position += n;
+	}
+
+	void RandomStream::shuffle(u32 * values,u32 n){
+		for(u32 i = n;i > 1;i--){
+			const u32 j = nextU32(i - 1);
+			const u32 t = values[i - 1];
+			values[i - 1] = values[j];
+			values[j] = t;
+		}
+	}
+
+}
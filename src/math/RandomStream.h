@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include "utils/utils.h"
+
+namespace vio{
+
+	class ThreadPool;
+
+	/**
+	A counter based random generator (Philox4x32-10, see "Parallel random numbers: as easy as 1, 2, 3", Salmon et al.).
+
+	The n-th number of a stream is a pure function of (key,stream,n): there is no state to share between threads,
+	jumping ahead is free and a range of numbers can be filled by several threads with the same result as one.
+	Give every thread, tensor or sample its own stream (or key) instead of locking the global generator of math.h.
+
+	Every position of a stream holds one u32. The floats and the gaussians at a position are computed from it
+	(a gaussian uses the pair of positions it belongs to), so filling an array or calling next* one at a time
+	gives the same numbers, whatever the starting position.
+	@code
+	RandomStream rng(42);
+	Matrix m(256,256);
+	m.fillGaussian(rng,0.1); // the same matrix on any machine, for any number of threads
+	RandomStream perThread = rng.split(worker); // independent from rng
+	@endcode
+	 */
+	class RandomStream{
+	private:
+		uint64_t key;
+		uint64_t stream;
+		uint64_t position = 0;
+	public:
+		RandomStream(uint64_t key = 0,uint64_t stream = 0);
+		static RandomStream fromGlobal(); // key drawn from the global generator, so that seed() also controls it.
+
+		RandomStream split(uint64_t id) const; // another stream of the same key, starting at 0. split(a) and split(b) are independent for a != b.
+
+		void seek(uint64_t p){ position = p; }
+		void skip(uint64_t n){ position += n; } // jump ahead, O(1)
+		uint64_t tell() const{ return position; }
+		uint64_t getKey() const{ return key; }
+		uint64_t getStream() const{ return stream; }
+
+		u32 nextU32();
+		u32 nextU32(u32 max); // from 0 to max included, like randomU32
+		float nextFloat(); // in [0,1)
+		float nextGaussian(); // mean 0, deviation 1
+
+		// Bulk generation, much faster than one call per number. With a pool, the range is split between the threads.
+		void fillU32(u32 * out,size_t n,ThreadPool * pool = 0);
+		void fillUniform(float * out,size_t n,float low = 0,float high = 1,ThreadPool * pool = 0);
+		void fillGaussian(float * out,size_t n,float mean = 0,float deviation = 1,ThreadPool * pool = 0);
+
+		void shuffle(u32 * values,u32 n); // Fisher-Yates
+
+		// The raw Philox block: 4 numbers for a 128 bit counter and a 64 bit key.
+		static void block(uint64_t key,uint64_t counterLow,uint64_t counterHigh,u32 out[4]);
+	};
+
+}
@@ -1,163 +1,222 @@
-#include "vector.h"
-#include "utils/utils.h"
-#include "math.h"
-#include <cstdio>
-
-namespace vio{
-
-	Vector::Vector(u32 size){
-		this->s = size;
-		this->data = new float[size];
-	}
-	Vector::Vector(const Vector& v){
-		this->s = v.s;
-		this->data = new float[v.s];
-		for(u32 i = 0;i < v.s;i++){
-			this->data[i] = v.data[i];
-		}
-	}
-	Vector::~Vector(){
-		delete [] this->data;
-	}
-
-	Vector& Vector::operator=(const Vector& v){
-		this->~Vector();
-		*this = Vector(v);
-		return *this;
-	}
-	Vector& Vector::operator=(Vector&& v){
-		this->~Vector();
-		this->s = v.s;
-		this->data = v.data;
-        // now remove the content of other so that it cannot be used anymore
-        v.data = 0;
-        v.s = 0;
-        return *this;
-    }
-
-	u32 Vector::size() const{
-		return s;
-	}
-	float& Vector::at(u32 i){
-		vassert(i < s);
-		return data[i];
-	}
-	float Vector::get(u32 i) const{
-		vassert(i < s);
-		return data[i];
-	}
-	float Vector::normSquared() const{
-		float n = 0;
-		for(u32 i = 0;i < s;i++){
-			n += data[i] * data[i];
-		}
-		return n;
-	}
-	float Vector::norm() const{
-		return std::sqrt(this->normSquared());
-	}
-
-	void Vector::fill(float v){
-		for(u32 i = 0;i < s;i++){
-			data[i] = v;
-		}
-	}
-	void Vector::fillRandom(float dev,float mean){
-		for(u32 i = 0;i < s;i++){
-			data[i] = (randomFloat()-.5) * 2 * dev + mean;
-		}
-	}
-
-	Vector& Vector::operator+=(const Vector& v){
-		vassert(v.size() == this->size());
-		for(u32 i = 0;i < s;i++){
-			data[i] += v.data[i];
-		}
-		return *this;
-	}
-	Vector& Vector::operator-=(const Vector& v){
-		vassert(v.size() == this->size());
-		for(u32 i = 0;i < s;i++){
-			data[i] -= v.data[i];
-		}
-		return *this;
-	}
-	Vector& Vector::operator*=(const Vector& v){
-		vassert(v.size() == this->size());
-		for(u32 i = 0;i < s;i++){
-			data[i] *= v.data[i];
-		}
-		return *this;
-	}
-	Vector& Vector::operator*=(float v){
-		for(u32 i = 0;i < s;i++){
-			data[i] *= v;
-		}
-		return *this;
-	}
-	Vector& Vector::operator/=(float v){
-		for(u32 i = 0;i < s;i++){
-			data[i] /= v;
-		}
-		return *this;
-	}
-
-	void Vector::print() const{
-		printf("[ ");
-		for(u32 i = 0;i < s;i++){
-			printf("%.3f ",data[i]);
-		}
-		printf("]\n");
-	}
-	Vector Vector::softmax() const{
-		Vector v(s);
-		float sum = 0;
-		// substract max of data to prevent precision issues.
-		float datamax = data[0];
-		for(u32 i = 1;i < s;i++){
-			if(data[i] > datamax) datamax = data[i];
-		}
-		for(u32 i = 0;i < s;i++){
-			sum += exp(data[i] - datamax + 5); // e^5 = 148
-		}
-		for(u32 i = 0;i < s;i++){
-			v.data[i] = exp(data[i] - datamax + 5) / sum;
-		}
-		return v;
-	}
-	Vector Vector::add(const Vector& a,const Vector& b){
-		vassert(a.s == b.s);
-		Vector v(a.s);
-		for(u32 i = 0;i < a.s;i++){
-			v.data[i] = a.data[i] + b.data[i];
-		}
-		return v;
-	}
-	Vector Vector::sub(const Vector& a,const Vector& b){
-		vassert(a.s == b.s);
-		Vector v(a.s);
-		for(u32 i = 0;i < a.s;i++){
-			v.data[i] = a.data[i] - b.data[i];
-		}
-		return v;
-	}
-
-	float Vector::dot(const Vector& a,const Vector& b){
-		vassert(a.s == b.s);
-		float f = 0;
-		for(u32 i = 0;i < a.s;i++){
-			f += a.data[i] * b.data[i];
-		}
-		return f;
-	}
-	Matrix Vector::crossNorm(const Vector& a,const Vector& b){
-		Matrix m(b.s,a.s);
-		for(u32 y = 0;y < a.s;y++){
-			for(u32 x = 0;x < b.s;x++){
-				m.at(y,x) = a.data[y] * b.data[x];
-			}
-		}
-		return m;
-	}
-
-}
+#include "vector.h"
+#include "RandomStream.h"
+#include "utils/utils.h"
+#include "math.h"
+#include <cstdio>
+
+namespace vio{
+
+	Vector::Vector(u32 size){
+		this->s = size;
+		this->data = 0;
+		if(size == 0) return; // empty vectors are used as placeholders, they should cost nothing.
+		this->data = new float[size];
+		countAllocation((uint64_t)size * sizeof(float));
+	}
+	Vector::Vector(u32 size,float * external){
+		this->s = size;
+		this->data = external;
+		this->owner = false;
+	}
+	Vector::Vector(const Vector& v){
+		this->s = v.s;
+		this->data = 0;
+		if(v.s == 0) return;
+		this->data = new float[v.s];
+		countAllocation((uint64_t)v.s * sizeof(float));
+		for(u32 i = 0;i < v.s;i++){
+			this->data[i] = v.data[i];
+		}
+	}
+	Vector::~Vector(){
+		if(owner) delete [] this->data;
+	}
+
+	Vector& Vector::operator=(const Vector& v){
+		*this = Vector(v);
+		return *this;
+	}
+	Vector& Vector::operator=(Vector&& v){
+		this->~Vector();
+		this->s = v.s;
+		this->data = v.data;
+		this->owner = v.owner;
+        // now remove the content of other so that it cannot be used anymore
+        v.data = 0;
+        v.owner = true;
+        v.s = 0;
+        return *this;
+    }
+
+	float * Vector::raw(){
+		return data;
+	}
+	const float * Vector::raw() const{
+		return data;
+	}
+	void Vector::bind(float * external){
+		this->~Vector();
+		this->data = external;
+		this->owner = false;
+	}
+
+	u32 Vector::size() const{
+		return s;
+	}
+	float& Vector::at(u32 i){
+		vassert(i < s);
+		return data[i];
+	}
+	float Vector::get(u32 i) const{
+		vassert(i < s);
+		return data[i];
+	}
+	float Vector::normSquared() const{
+		float n = 0;
+		for(u32 i = 0;i < s;i++){
+			n += data[i] * data[i];
+		}
+		return n;
+	}
+	float Vector::norm() const{
+		return std::sqrt(this->normSquared());
+	}
+
+	void Vector::fill(float v){
+		for(u32 i = 0;i < s;i++){
+			data[i] = v;
+		}
+	}
+	void Vector::fillRandom(float dev,float mean){
+		randomFloats(data,s);
+		for(u32 i = 0;i < s;i++){
+			data[i] = (data[i]-.5) * 2 * dev + mean;
+		}
+	}
+
+	void Vector::fillRandom(RandomStream& rng,float dev,float mean){
+		rng.fillUniform(data,s,mean - dev,mean + dev);
+	}
+	void Vector::fillGaussian(RandomStream& rng,float dev,float mean){
+		rng.fillGaussian(data,s,mean,dev);
+	}
+
+	Vector& Vector::operator+=(const Vector& v){
+		vassert(v.size() == this->size());
+		for(u32 i = 0;i < s;i++){
+			data[i] += v.data[i];
+		}
+		return *this;
+	}
+	Vector& Vector::operator-=(const Vector& v){
+		vassert(v.size() == this->size());
+		for(u32 i = 0;i < s;i++){
+			data[i] -= v.data[i];
+		}
+		return *this;
+	}
+	Vector& Vector::operator*=(const Vector& v){
+		vassert(v.size() == this->size());
+		for(u32 i = 0;i < s;i++){
+			data[i] *= v.data[i];
+		}
+		return *this;
+	}
+	Vector& Vector::operator*=(float v){
+		for(u32 i = 0;i < s;i++){
+			data[i] *= v;
+		}
+		return *this;
+	}
+	Vector& Vector::operator/=(float v){
+		for(u32 i = 0;i < s;i++){
+			data[i] /= v;
+		}
+		return *this;
+	}
+
+	void Vector::print() const{
+		printf("[ ");
+		for(u32 i = 0;i < s;i++){
+			printf("%.3f ",data[i]);
+		}
+		printf("]\n");
+	}
+	Vector Vector::softmax() const{
+		Vector v(s);
+		softmax(v);
+		return v;
+	}
+	void Vector::softmax(Vector& v) const{
+		vassert(v.s == s);
+		float sum = 0;
+		// substract max of data to prevent precision issues.
+		float datamax = data[0];
+		for(u32 i = 1;i < s;i++){
+			if(data[i] > datamax) datamax = data[i];
+		}
+		for(u32 i = 0;i < s;i++){
+			sum += exp(data[i] - datamax + 5); // e^5 = 148
+		}
+		for(u32 i = 0;i < s;i++){
+			v.data[i] = exp(data[i] - datamax + 5) / sum;
+		}
+	}
+	Vector Vector::add(const Vector& a,const Vector& b){
+		vassert(a.s == b.s);
+		Vector v(a.s);
+		for(u32 i = 0;i < a.s;i++){
+			v.data[i] = a.data[i] + b.data[i];
+		}
+		return v;
+	}
+	Vector Vector::sub(const Vector& a,const Vector& b){
+		vassert(a.s == b.s);
+		Vector v(a.s);
+		for(u32 i = 0;i < a.s;i++){
+			v.data[i] = a.data[i] - b.data[i];
+		}
+		return v;
+	}
+
+	float Vector::dot(const Vector& a,const Vector& b){
+		vassert(a.s == b.s);
+		float f = 0;
+		for(u32 i = 0;i < a.s;i++){
+			f += a.data[i] * b.data[i];
+		}
+		return f;
+	}
+	void Vector::addCrossNorm(Matrix& m,const Vector& a,const Vector& b){
+		vassert(m.width() == b.s && m.height() == a.s);
+		float * md = m.data();
+		for(u32 y = 0;y < a.s;y++){
+			const float ay = a.data[y];
+			float * row = md + y * b.s;
+			for(u32 x = 0;x < b.s;x++){
+				row[x] += ay * b.data[x];
+			}
+		}
+	}
+	Matrix Vector::crossNorm(const Vector& a,const Vector& b){
+		Matrix m(b.s,a.s);
+		for(u32 y = 0;y < a.s;y++){
+			for(u32 x = 0;x < b.s;x++){
+				m.at(y,x) = a.data[y] * b.data[x];
+			}
+		}
+		return m;
+	}
+	void Vector::crossNorm(const Vector& a,const Vector& b,Matrix& out){
+		vassert(out.width() == b.s && out.height() == a.s);
+		float * md = out.data();
+		for(u32 y = 0;y < a.s;y++){
+			const float ay = a.data[y];
+			float * row = md + y * b.s;
+			for(u32 x = 0;x < b.s;x++){
+				row[x] = ay * b.data[x];
+			}
+		}
+	}
+
+}
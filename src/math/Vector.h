@@ -1,50 +1,62 @@
-#pragma once
-
-#include "utils/utils.h"
-#include "Matrix.h"
-
-namespace vio{
-
-	struct Matrix; // forward declaration.
-	
-	// fixed size container meant for linear algebra
-	struct Vector{
-	private:
-		u32 s;
-		float * data;
-	public:
-		Vector(u32 size);
-		Vector(const Vector& v);
-		~Vector();
-
-		Vector& operator=(const Vector& v);
-		Vector& operator=(Vector&& v);
-
-		void fill(float v);
-		void fillRandom(float dev = 1,float mean = 0);
-
-		float normSquared() const;
-		float norm() const;
-
-		u32 size() const;
-
-		void print() const;
-
-		float& at(u32 x);
-		float get(u32 x) const;
-
-		Vector& operator+=(const Vector& v);
-		Vector& operator-=(const Vector& v);
-		Vector& operator*=(const Vector& v); // element wise.
-		Vector& operator*=(float v);
-		Vector& operator/=(float v);
-
-		Vector softmax() const;
-
-		static Vector add (const Vector& a,const Vector& b);
-		static Vector sub(const Vector& a,const Vector& b);
-		static float dot (const Vector& a,const Vector& b); // aᵀb
-		static Matrix crossNorm(const Vector& a,const Vector& b); // abᵀ
-	};
-
-}
+#pragma once
+
+#include "utils/utils.h"
+#include "Matrix.h"
+
+namespace vio{
+
+	struct Matrix; // forward declaration.
+	class RandomStream;
+	
+	// fixed size container meant for linear algebra
+	struct Vector{
+	private:
+		u32 s;
+		float * data;
+		bool owner = true; // false for views over external memory
+	public:
+		Vector(u32 size); // Vector(0) allocates nothing
+		Vector(u32 size,float * external); // view over external memory, nothing is copied or freed.
+		Vector(const Vector& v);
+		~Vector();
+
+		Vector& operator=(const Vector& v);
+		Vector& operator=(Vector&& v);
+
+		void fill(float v);
+		void fillRandom(float dev = 1,float mean = 0);
+		void fillRandom(RandomStream& rng,float dev = 1,float mean = 0); // uniform in [mean-dev,mean+dev)
+		void fillGaussian(RandomStream& rng,float dev = 1,float mean = 0);
+
+		float normSquared() const;
+		float norm() const;
+
+		u32 size() const;
+
+		void print() const;
+
+		float& at(u32 x);
+		float get(u32 x) const;
+
+		float * raw();
+		const float * raw() const;
+		void bind(float * external); // drop the current storage and use external instead (same size)
+
+		Vector& operator+=(const Vector& v);
+		Vector& operator-=(const Vector& v);
+		Vector& operator*=(const Vector& v); // element wise.
+		Vector& operator*=(float v);
+		Vector& operator/=(float v);
+
+		Vector softmax() const;
+		void softmax(Vector& out) const; // same without allocating
+
+		static Vector add (const Vector& a,const Vector& b);
+		static Vector sub(const Vector& a,const Vector& b);
+		static float dot (const Vector& a,const Vector& b); // aᵀb
+		static Matrix crossNorm(const Vector& a,const Vector& b); // abᵀ
+		static void crossNorm(const Vector& a,const Vector& b,Matrix& out); // same without allocating
+		static void addCrossNorm(Matrix& m,const Vector& a,const Vector& b); // m += abᵀ, used to accumulate gradients without allocating.
+	};
+
+}
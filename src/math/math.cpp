@@ -1,236 +1,459 @@
-#include "math.h"
-#include <chrono>
-
-namespace vio{
-
-
-	// find a library to do this! Maybe processor have a build-in thing for this which is faster.
-	u32 nChoosek(u32 n, u32 k){
-		vassert(k <= n);
-		if (k * 2 > n) k = n-k;
-		if (k == 0) return 1;
-
-		u32 result = n;
-		for(u32 i = 2; i <= k; ++i ) {
-			result *= (n-i+1);
-			result /= i;
-		}
-		return result;
-	}
-
-	i32 modPow(i32 base,i32 exponent,i32 modulus){
-	    if(modulus == 1) return 0;
-	    i32 result = 1;
-	    base = mod(base,modulus);
-	    while(exponent > 0){
-	        if(mod(exponent,2) == 1){
-	            result = mod(result * base,modulus);
-	        }
-	        exponent = exponent >> 1;
-	        base = mod(base * base,modulus);
-	    }
-	    return result;
-	}
-
-	struct Fasthash{
-		i32 a,b,c;
-		i32 hash(i32 x){
-			uint16_t low = (uint16_t)x;
-			uint16_t high = x >> 16;
-			return (low * a + high * b + c);
-		};
-		i32 hash(i32 x,i32 y,i32 z){
-			return this->hash(this->hash(this->hash(this->hash(x) ^ y) ^ z) ^ x);
-		}
-		double randAtInt(i32 x,i32 y,i32 z){
-			return ((double)this->hash(x,y,z)) / 2. / (INT_MAX);
-		}
-	};
-	static inline double fade(double t) noexcept{
-		return t * t * t * (t * (t * 6 - 15) + 10);
-	}
-	static inline double lerp(double t, double a, double b) noexcept{
-		return a + t * (b - a);
-	}
-	static inline i32 fastfloor(float a){
-	    i32 ai = (i32) a;
-	    return (a < ai) ? ai-1 : ai;
-	}
-	double perlin(double x, double y, double z){
-		const int32_t X = fastfloor(x);
-		const int32_t Y = fastfloor(y);
-		const int32_t Z = fastfloor(z);
-
-		x -= X;
-		y -= Y;
-		z -= Z;
-
-		const double u = fade(x); // add option for fade?
-		const double v = fade(y);
-		const double w = fade(z);
-
-		Fasthash fh = Fasthash();
-		fh.a = 413441;
-		fh.b = 134134;
-		fh.c = 431231;
-
-		const double XYZ = fh.randAtInt(X,Y,Z);
-		const double XmYZ = fh.randAtInt(X+1,Y,Z);
-		const double XYmZ = fh.randAtInt(X,Y+1,Z);
-		const double XmYmZ = fh.randAtInt(X+1,Y+1,Z);
-
-		const double XYZm = fh.randAtInt(X,Y,Z+1);
-		const double XmYZm = fh.randAtInt(X+1,Y,Z+1);
-		const double XYmZm = fh.randAtInt(X,Y+1,Z+1);
-		const double XmYmZm = fh.randAtInt(X+1,Y+1,Z+1);
-
-		return lerp(w, 
-			lerp(v, lerp(u, XYZ, XmYZ), lerp(u, XYmZ, XmYmZ)),
-			lerp(v, lerp(u, XYZm,XmYZm),lerp(u, XYmZm,XmYmZm)))
-		*2 - 1;
-	}
-	double isoperlin(double x,double y,double z){
-		return (
-				perlin(x,y,z) +
-				perlin((y+z)/2,(x+z)/2,(x+y)/2) +
-				perlin((y-z)/2,(x-z)/2,(x-y)/2)
-		) / 3.;
-	}
-
-	// Randomness implementation.
-	static constexpr size_t SIZE   = 624;
-	static constexpr size_t PERIOD = 397;
-	static constexpr size_t DIFF   = SIZE - PERIOD;
-	static constexpr u32 MAGIC = 0x9908b0df;
-
-	struct MTState {
-		u32 MT[SIZE];
-		u32 MT_TEMPERED[SIZE];
-		size_t index = SIZE;
-	};
-
-	static MTState state;
-	static bool seeded = false;
-
-	#define M32(x) (0x80000000 & x) // 32nd MSB
-	#define L31(x) (0x7FFFFFFF & x) // 31 LSBs
-
-	#define UNROLL(expr) \
-		y = M32(state.MT[i]) | L31(state.MT[i+1]); \
-		state.MT[i] = state.MT[expr] ^ (y >> 1) ^ (((i32(y) << 31) >> 31) & MAGIC); \
-		++i;
-
-	static void generate_numbers(){
-		if(!seeded){seed(342);seeded = true;}
-		size_t i = 0;
-		u32 y;
-		while ( i < DIFF ) {
-			UNROLL(i+PERIOD);
-		}
-		while ( i < SIZE -1 ) {
-			UNROLL(i-DIFF);
-		}
-
-		{
-			// i = 623, last step rolls over
-			y = M32(state.MT[SIZE-1]) | L31(state.MT[0]);
-			state.MT[SIZE-1] = state.MT[PERIOD-1] ^ (y >> 1) ^ (((i32(y) << 31) >>
-						31) & MAGIC);
-		}
-
-		// Temper all numbers in a batch
-		for (size_t i = 0; i < SIZE; ++i) {
-			y = state.MT[i];
-			y ^= y >> 11;
-			y ^= y << 7  & 0x9d2c5680;
-			y ^= y << 15 & 0xefc60000;
-			y ^= y >> 18;
-			state.MT_TEMPERED[i] = y;
-		}
-
-		state.index = 0;
-	}
-
-	void seed(u32 value){
-		seeded = true;
-		state.MT[0] = value;
-		// but all the other values of MT to 0 to reset the entropy.
-		for(u32 i = 1;i < sizeof(state.MT);i++){
-			state.MT[1] = 0;
-		}
-		state.index = SIZE;
-
-		for ( uint_fast32_t i = 1; i < SIZE; ++i) // shuffle
-			state.MT[i] = 0x6c078965*(state.MT[i-1] ^ state.MT[i-1]>>30) + i;
-	}
-	// provide more entropy for the generator
-	void seed(u32 value1,u32 value2){
-		seeded = true;
-		state.MT[0] = value1;
-		state.MT[1] = value2;
-		for(u32 i = 2;i < sizeof(state.MT);i++){
-			state.MT[1] = 0;
-		}
-		for (uint_fast32_t i = 2; i < SIZE; ++i) // shuffle
-			state.MT[i] = 0x6c078965*(state.MT[i-1] ^ state.MT[i-1]>>30) + i;
-		state.index = SIZE;
-	}
-
-	u32 unique_random(){
-		unsigned long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-			    std::chrono::system_clock::now().time_since_epoch()
-			).count();
-		// wow, so random
-		return ms;
-	}
-	void seed(){
-		seed(unique_random());
-	}
-
-	u32 rand_u32(){ // private
-		if (state.index == SIZE) {
-			generate_numbers();
-			state.index = 0;
-		}
-		return state.MT_TEMPERED[state.index++];
-	}
-
-	// Already defined.
-	// #define UINT32_MAX  ((u32)-1)
-
-	float randomFloat(){
-		u32 i = rand_u32();
-		return ((double)i) / UINT32_MAX;
-	}
-	float random(){
-		return randomFloat();
-	}
-
-	u32 randomU32(const u32 max){ // from 0 to max included. 100% uniform.
-		// compute the next highest power of 2 of 32-bit v (2,3 -> 4, 4,5,6,7 -> 8 etc..)
-		u32 p2 = max;
-		p2 |= p2 >> 1;
-		p2 |= p2 >> 2;
-		p2 |= p2 >> 4;
-		p2 |= p2 >> 8;
-		p2 |= p2 >> 16;
-
-		u32 rnd;
-		do{
-			rnd = rand_u32() & p2; // fast modulo
-		}while(rnd > max);
-		return rnd;
-	}
-	i32 randomI32(const i32 min,const i32 max){
-		vassert(max >= min);
-		return randomU32(max - min) + min;
-	}
-
-	double randAtInt(i32 x,i32 y,i32 z){
-		Fasthash fh = Fasthash();
-		fh.a = 483401;
-		fh.b = 134734;
-		fh.c = 931281;
-		return fh.randAtInt(x,y,z);
-	}
-}
+#include "utils/ThreadPool.h" // before math.h and its max macro
+#include "math.h"
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace vio{
+
+
+	float pairwiseSum(const float * v,u32 n){
+		if(n <= 8){ // small enough, a loop is as precise.
+			float s = 0;
+			for(u32 i = 0;i < n;i++) s += v[i];
+			return s;
+		}
+		u32 half = n / 2;
+		return pairwiseSum(v,half) + pairwiseSum(v + half,n - half);
+	}
+
+	// find a library to do this! Maybe processor have a build-in thing for this which is faster.
+	u32 nChoosek(u32 n, u32 k){
+		vassert(k <= n);
+		if (k * 2 > n) k = n-k;
+		if (k == 0) return 1;
+
+		u32 result = n;
+		for(u32 i = 2; i <= k; ++i ) {
+			result *= (n-i+1);
+			result /= i;
+		}
+		return result;
+	}
+
+	i32 modPow(i32 base,i32 exponent,i32 modulus){
+	    if(modulus == 1) return 0;
+	    i32 result = 1;
+	    base = mod(base,modulus);
+	    while(exponent > 0){
+	        if(mod(exponent,2) == 1){
+	            result = mod(result * base,modulus);
+	        }
+	        exponent = exponent >> 1;
+	        base = mod(base * base,modulus);
+	    }
+	    return result;
+	}
+
+	struct Fasthash{
+		i32 a,b,c;
+		i32 hash(i32 x){
+			uint16_t low = (uint16_t)x;
+			uint16_t high = x >> 16;
+			return (low * a + high * b + c);
+		};
+		i32 hash(i32 x,i32 y,i32 z){
+			return this->hash(this->hash(this->hash(this->hash(x) ^ y) ^ z) ^ x);
+		}
+		double randAtInt(i32 x,i32 y,i32 z){
+			return ((double)this->hash(x,y,z)) / 2. / (INT_MAX);
+		}
+	};
+	static inline double fade(double t) noexcept{
+		return t * t * t * (t * (t * 6 - 15) + 10);
+	}
+	static inline double lerp(double t, double a, double b) noexcept{
+		return a + t * (b - a);
+	}
+	static inline i32 fastfloor(float a){
+	    i32 ai = (i32) a;
+	    return (a < ai) ? ai-1 : ai;
+	}
+	double perlin(double x, double y, double z){
+		const int32_t X = fastfloor(x);
+		const int32_t Y = fastfloor(y);
+		const int32_t Z = fastfloor(z);
+
+		x -= X;
+		y -= Y;
+		z -= Z;
+
+		const double u = fade(x); // add option for fade?
+		const double v = fade(y);
+		const double w = fade(z);
+
+		Fasthash fh = Fasthash();
+		fh.a = 413441;
+		fh.b = 134134;
+		fh.c = 431231;
+
+		const double XYZ = fh.randAtInt(X,Y,Z);
+		const double XmYZ = fh.randAtInt(X+1,Y,Z);
+		const double XYmZ = fh.randAtInt(X,Y+1,Z);
+		const double XmYmZ = fh.randAtInt(X+1,Y+1,Z);
+
+		const double XYZm = fh.randAtInt(X,Y,Z+1);
+		const double XmYZm = fh.randAtInt(X+1,Y,Z+1);
+		const double XYmZm = fh.randAtInt(X,Y+1,Z+1);
+		const double XmYmZm = fh.randAtInt(X+1,Y+1,Z+1);
+
+		return lerp(w, 
+			lerp(v, lerp(u, XYZ, XmYZ), lerp(u, XYmZ, XmYmZ)),
+			lerp(v, lerp(u, XYZm,XmYZm),lerp(u, XYmZm,XmYmZm)))
+		*2 - 1;
+	}
+	double isoperlin(double x,double y,double z){
+		return (
+				perlin(x,y,z) +
+				perlin((y+z)/2,(x+z)/2,(x+y)/2) +
+				perlin((y-z)/2,(x-z)/2,(x-y)/2)
+		) / 3.;
+	}
+
+	// Everything perlin needs for one row of a grid (fixed y and z) and one octave.
+	// The columns (x) are shared by all the rows: X[i], u[i]. The corner values are computed once per cell of the row.
+	struct PerlinRow{
+		std::vector<double> corners[8]; // corners[c][i]: value at (X[i] + (c&1),Y + (c>>1&1),Z + (c>>2)) as in perlin
+		std::vector<double> value;
+	};
+
+	static void perlinRow(const i32 * X,const double * u,u32 n,double y,double z,PerlinRow& row){
+		const int32_t Y = fastfloor(y);
+		const int32_t Z = fastfloor(z);
+		const double v = fade(y - Y);
+		const double w = fade(z - Z);
+
+		Fasthash fh = Fasthash();
+		fh.a = 413441;
+		fh.b = 134134;
+		fh.c = 431231;
+
+		double * c[8];
+		for(u32 k = 0;k < 8;k++){
+			row.corners[k].resize(n);
+			c[k] = row.corners[k].data();
+		}
+		row.value.resize(n);
+		for(u32 i = 0;i < n;i++){
+			if(i > 0 && X[i] == X[i-1]){ // same cell
+				for(u32 k = 0;k < 8;k++) c[k][i] = c[k][i-1];
+				continue;
+			}
+			for(u32 k = 0;k < 8;k += 2){
+				const i32 dy = k >> 1 & 1,dz = k >> 2;
+				// the left corners of a cell are the right corners of the previous one
+				c[k][i] = i > 0 && X[i] == X[i-1] + 1 ? c[k+1][i-1] : fh.randAtInt(X[i],Y + dy,Z + dz);
+				c[k+1][i] = fh.randAtInt(X[i] + 1,Y + dy,Z + dz);
+			}
+		}
+
+		double * out = row.value.data();
+		u32 i = 0;
+#ifdef __SSE2__
+		// the operations of perlin, in the same order, 2 points at a time.
+		const __m128d vv = _mm_set1_pd(v),ww = _mm_set1_pd(w);
+		auto lerp2 = [](__m128d t,__m128d a,__m128d b){ return _mm_add_pd(a,_mm_mul_pd(t,_mm_sub_pd(b,a))); };
+		for(;i + 2 <= n;i += 2){
+			const __m128d uu = _mm_loadu_pd(u + i);
+			__m128d l[4];
+			for(u32 k = 0;k < 4;k++){
+				l[k] = lerp2(uu,_mm_loadu_pd(c[2*k] + i),_mm_loadu_pd(c[2*k+1] + i));
+			}
+			const __m128d r = lerp2(ww,lerp2(vv,l[0],l[1]),lerp2(vv,l[2],l[3]));
+			_mm_storeu_pd(out + i,_mm_sub_pd(_mm_mul_pd(r,_mm_set1_pd(2)),_mm_set1_pd(1)));
+		}
+#endif
+		for(;i < n;i++){
+			out[i] = lerp(w,
+				lerp(v, lerp(u[i], c[0][i], c[1][i]), lerp(u[i], c[2][i], c[3][i])),
+				lerp(v, lerp(u[i], c[4][i], c[5][i]), lerp(u[i], c[6][i], c[7][i])))
+			*2 - 1;
+		}
+	}
+
+	template<typename T>
+	static void perlinGridImpl(const double origin[3],const double step[3],const u32 dims[3],u32 octaves,T * out,ThreadPool * pool){
+		const u32 n = dims[0];
+		const u32 rows = dims[1] * dims[2];
+		if(n == 0 || rows == 0 || octaves == 0) return;
+
+		// the columns of every octave
+		std::vector<i32> X((size_t)octaves * n);
+		std::vector<double> u((size_t)octaves * n);
+		for(u32 o = 0;o < octaves;o++){
+			const double f = std::ldexp(1.0,o);
+			for(u32 i = 0;i < n;i++){
+				const double x = (origin[0] + i * step[0]) * f;
+				X[(size_t)o * n + i] = fastfloor(x);
+				u[(size_t)o * n + i] = fade(x - X[(size_t)o * n + i]);
+			}
+		}
+
+		auto work = [&](u32 begin,u32 end,u32 worker){
+			PerlinRow row;
+			std::vector<double> sum(n);
+			for(u32 r = begin;r < end;r++){
+				const u32 j = r % dims[1],k = r / dims[1];
+				for(u32 o = 0;o < octaves;o++){
+					const double f = std::ldexp(1.0,o);
+					const double amplitude = std::ldexp(1.0,-(i32)o);
+					perlinRow(X.data() + (size_t)o * n,u.data() + (size_t)o * n,n,
+						(origin[1] + j * step[1]) * f,(origin[2] + k * step[2]) * f,row);
+					for(u32 i = 0;i < n;i++){
+						sum[i] = o == 0 ? row.value[i] : sum[i] + amplitude * row.value[i];
+					}
+				}
+				T * o = out + (size_t)r * n;
+				for(u32 i = 0;i < n;i++) o[i] = (T)sum[i];
+			}
+		};
+		if(pool != 0){
+			pool->parallelFor(rows,max(1u,16384 / n),work); // enough points per task to amortize the row buffers
+		}else{
+			work(0,rows,0);
+		}
+	}
+
+	void perlinGrid(const double origin[3],const double step[3],const u32 dims[3],u32 octaves,double * out,ThreadPool * pool){
+		perlinGridImpl(origin,step,dims,octaves,out,pool);
+	}
+	void perlinGrid(const double origin[3],const double step[3],const u32 dims[3],u32 octaves,float * out,ThreadPool * pool){
+		perlinGridImpl(origin,step,dims,octaves,out,pool);
+	}
+
+	// Randomness implementation.
+	static constexpr size_t SIZE   = 624;
+	static constexpr size_t PERIOD = 397;
+	static constexpr size_t DIFF   = SIZE - PERIOD;
+	static constexpr u32 MAGIC = 0x9908b0df;
+
+	struct MTState {
+		u32 MT[SIZE];
+		u32 MT_TEMPERED[SIZE];
+		size_t index = SIZE;
+	};
+
+	static MTState state;
+	static bool seeded = false;
+
+	#define M32(x) (0x80000000 & x) // 32nd MSB
+	#define L31(x) (0x7FFFFFFF & x) // 31 LSBs
+
+	#define UNROLL(expr) \
+		y = M32(state.MT[i]) | L31(state.MT[i+1]); \
+		state.MT[i] = state.MT[expr] ^ (y >> 1) ^ (((i32(y) << 31) >> 31) & MAGIC); \
+		++i;
+
+#ifdef __SSE2__
+	// 4 steps of the recurrence: MT[i..i+3] from MT[i..i+4] and MT[other..other+3].
+	// The 4 steps are independent: they only read values that none of them writes.
+	static inline void unroll4(size_t i,size_t other){
+		const __m128i upper = _mm_set1_epi32(0x80000000);
+		const __m128i lower = _mm_set1_epi32(0x7FFFFFFF);
+		const __m128i current = _mm_loadu_si128((const __m128i*)(state.MT + i));
+		const __m128i next = _mm_loadu_si128((const __m128i*)(state.MT + i + 1));
+		const __m128i far = _mm_loadu_si128((const __m128i*)(state.MT + other));
+		const __m128i y = _mm_or_si128(_mm_and_si128(current,upper),_mm_and_si128(next,lower));
+		const __m128i magic = _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(y,31),31),_mm_set1_epi32(MAGIC));
+		_mm_storeu_si128((__m128i*)(state.MT + i),_mm_xor_si128(_mm_xor_si128(far,_mm_srli_epi32(y,1)),magic));
+	}
+#endif
+
+	static void generate_numbers(){
+		if(!seeded){seed(342);seeded = true;}
+		size_t i = 0;
+		u32 y;
+#ifdef __SSE2__
+		// The scalar loops finish what the vector loops leave, the output is the same.
+		for(;i + 4 <= DIFF;i += 4){
+			unroll4(i,i+PERIOD);
+		}
+#endif
+		while ( i < DIFF ) {
+			UNROLL(i+PERIOD);
+		}
+#ifdef __SSE2__
+		// no scalar tail here: it would be dead code, and gcc warns about it at -Ofast.
+		static_assert((SIZE - 1 - DIFF) % 4 == 0,"the second vector loop must cover [DIFF,SIZE-1) exactly");
+		for(;i + 4 <= SIZE - 1;i += 4){
+			unroll4(i,i-DIFF);
+		}
+#else
+		while ( i < SIZE -1 ) {
+			UNROLL(i-DIFF);
+		}
+#endif
+
+		{
+			// i = 623, last step rolls over
+			y = M32(state.MT[SIZE-1]) | L31(state.MT[0]);
+			state.MT[SIZE-1] = state.MT[PERIOD-1] ^ (y >> 1) ^ (((i32(y) << 31) >>
+						31) & MAGIC);
+		}
+
+		// Temper all numbers in a batch
+		size_t t = 0;
+#ifdef __SSE2__
+		for(;t + 4 <= SIZE;t += 4){
+			__m128i v = _mm_loadu_si128((const __m128i*)(state.MT + t));
+			v = _mm_xor_si128(v,_mm_srli_epi32(v,11));
+			v = _mm_xor_si128(v,_mm_and_si128(_mm_slli_epi32(v,7),_mm_set1_epi32(0x9d2c5680)));
+			v = _mm_xor_si128(v,_mm_and_si128(_mm_slli_epi32(v,15),_mm_set1_epi32(0xefc60000)));
+			v = _mm_xor_si128(v,_mm_srli_epi32(v,18));
+			_mm_storeu_si128((__m128i*)(state.MT_TEMPERED + t),v);
+		}
+#endif
+		for (size_t i = t; i < SIZE; ++i) {
+			y = state.MT[i];
+			y ^= y >> 11;
+			y ^= y << 7  & 0x9d2c5680;
+			y ^= y << 15 & 0xefc60000;
+			y ^= y >> 18;
+			state.MT_TEMPERED[i] = y;
+		}
+
+		state.index = 0;
+	}
+
+	void seed(u32 value){
+		seeded = true;
+		state.MT[0] = value;
+		// but all the other values of MT to 0 to reset the entropy.
+		for(u32 i = 1;i < sizeof(state.MT);i++){
+			state.MT[1] = 0;
+		}
+		state.index = SIZE;
+
+		for ( uint_fast32_t i = 1; i < SIZE; ++i) // shuffle
+			state.MT[i] = 0x6c078965*(state.MT[i-1] ^ state.MT[i-1]>>30) + i;
+	}
+	// provide more entropy for the generator
+	void seed(u32 value1,u32 value2){
+		seeded = true;
+		state.MT[0] = value1;
+		state.MT[1] = value2;
+		for(u32 i = 2;i < sizeof(state.MT);i++){
+			state.MT[1] = 0;
+		}
+		for (uint_fast32_t i = 2; i < SIZE; ++i) // shuffle
+			state.MT[i] = 0x6c078965*(state.MT[i-1] ^ state.MT[i-1]>>30) + i;
+		state.index = SIZE;
+	}
+
+	u32 unique_random(){
+		unsigned long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::system_clock::now().time_since_epoch()
+			).count();
+		// wow, so random
+		return ms;
+	}
+	void seed(){
+		seed(unique_random());
+	}
+
+	u32 rand_u32(){ // private
+		if (state.index == SIZE) {
+			generate_numbers();
+			state.index = 0;
+		}
+		return state.MT_TEMPERED[state.index++];
+	}
+
+	// Already defined.
+	// #define UINT32_MAX  ((u32)-1)
+
+	float randomFloat(){
+		u32 i = rand_u32();
+		return ((double)i) / UINT32_MAX;
+	}
+	float random(){
+		return randomFloat();
+	}
+
+	void randomU32s(u32 * out,size_t n){
+		while(n > 0){
+			if (state.index == SIZE) {
+				generate_numbers();
+				state.index = 0;
+			}
+			const size_t available = SIZE - state.index;
+			const size_t count = n < available ? n : available;
+			std::memcpy(out,state.MT_TEMPERED + state.index,count * sizeof(u32));
+			state.index += count;
+			out += count;
+			n -= count;
+		}
+	}
+	void randomFloats(float * out,size_t n){
+		while(n > 0){
+			if (state.index == SIZE) {
+				generate_numbers();
+				state.index = 0;
+			}
+			const size_t available = SIZE - state.index;
+			const size_t count = n < available ? n : available;
+			const u32 * from = state.MT_TEMPERED + state.index;
+			size_t i = 0;
+#ifdef __SSE2__
+			// 2 doubles at a time, the division and the roundings are the ones of the scalar code.
+			const __m128d divisor = _mm_set1_pd(UINT32_MAX);
+			const __m128d offset = _mm_set1_pd(2147483648.0);
+			const __m128i flip = _mm_set1_epi32(0x80000000);
+			for(;i + 4 <= count;i += 4){
+				const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(from + i)),flip); // u32 - 2^31 as i32
+				const __m128d low = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(x),offset),divisor);
+				const __m128d high = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x,_MM_SHUFFLE(1,0,3,2))),offset),divisor);
+				_mm_storeu_ps(out + i,_mm_movelh_ps(_mm_cvtpd_ps(low),_mm_cvtpd_ps(high)));
+			}
+#endif
+			for(;i < count;i++){
+				out[i] = ((double)from[i]) / UINT32_MAX; // the same rounding as randomFloat
+			}
+			state.index += count;
+			out += count;
+			n -= count;
+		}
+	}
+
+	// splitmix64 finalizer, every bit of the input changes half of the bits of the output.
+	static inline uint64_t mix64(uint64_t z){
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+	u32 hashRandom(u32 key,u32 counter){
+		return mix64(((uint64_t)key << 32 | counter) + 0x9e3779b97f4a7c15ULL) >> 32;
+	}
+
+	u32 randomU32(const u32 max){ // from 0 to max included. 100% uniform.
+		// compute the next highest power of 2 of 32-bit v (2,3 -> 4, 4,5,6,7 -> 8 etc..)
+		u32 p2 = max;
+		p2 |= p2 >> 1;
+		p2 |= p2 >> 2;
+		p2 |= p2 >> 4;
+		p2 |= p2 >> 8;
+		p2 |= p2 >> 16;
+
+		u32 rnd;
+		do{
+			rnd = rand_u32() & p2; // fast modulo
+		}while(rnd > max);
+		return rnd;
+	}
+	i32 randomI32(const i32 min,const i32 max){
+		vassert(max >= min);
+		return randomU32(max - min) + min;
+	}
+
+	double randAtInt(i32 x,i32 y,i32 z){
+		Fasthash fh = Fasthash();
+		fh.a = 483401;
+		fh.b = 134734;
+		fh.c = 931281;
+		return fh.randAtInt(x,y,z);
+	}
+}
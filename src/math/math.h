@@ -1,77 +1,108 @@
-#pragma once
-
-#include "utils/utils.h"
-#include <cmath>
-/**
-@notitle
-	math.h provide math, number related function not found in <cmath>
-
-	This includes:
-	- fast randomness (seedable)
-	- perlin noise
-	- modulo operations
-	- nChoosek
-	- ...
-*/
-
-namespace vio{
-
-	// defined here because should not have to include algorithm to have access to max.
-	#define max(a,b) \
-	   ({ __typeof__ (a) _a = (a); \
-		   __typeof__ (b) _b = (b); \
-		 _a > _b ? _a : _b; })
-	#define min(a,b) \
-	   ({ __typeof__ (a) _a = (a); \
-		   __typeof__ (b) _b = (b); \
-		 _a <= _b ? _a : _b; })
-
-	void seed();
-	void seed(u32 value);
-	void seed(u32 value1,u32 value2); // use this if you want more entropy.
-
-	float randomFloat();
-	/**
-	Returns a random float between 0 and 1
-	This method is an alias of randomFloat()
-	The randomness is not cryptographically secure.
-
-	The sequence returned by this method will always be the same (for a given seed) making it useful if you need to reproduce
-	a bug you encoutered in code involving randomness.
-	You can seed this function using the seed(u32 value) function or just seed().
-	@code
-	seed(312);
-	float r = 0;
-	for(u32 i = 0;i < 100;i++){
-		r += random();
-	}
-	vassert(abs(r - 50.783) < 0.01);
-	debug("r = %f",r); // r will always be the same.
-	@endcode
-	 */
-	float random(); // alias
-	float randomFloat();
-	double randomDouble();
-	u32 randomU32(const u32 max); // max included
-	i32 randomI32(const i32 min,const i32 max); // max and min included
-
-	double randAtInt(i32 x,i32 y,i32 z);
-
-	inline float mod(float base, float div) { // modulus for floating numbers
-		float fractPart = modff(base / div, nullptr); // nullptr is usually used to retrieve the integer part of base / div (pointer to float)
-		if (fractPart <= 0) fractPart += 1;
-		return fractPart * div;
-	}
-	inline i32 mod(i32 base, i32 div) {
-		i32 m = base % div;
-		if (m < 0) return m + div;
-		return m;
-	}
-
-	u32 nChoosek(u32 n, u32 k);
-	i32 modPow(i32 base,i32 exponent,i32 modulus);
-
-	double perlin(double x, double y, double z);
-	double isoperlin(double x,double y,double z);
-
-}
+#pragma once
+
+#include "utils/utils.h"
+#include <cmath>
+/**
+@notitle
+	math.h provide math, number related function not found in <cmath>
+
+	This includes:
+	- fast randomness (seedable)
+	- perlin noise
+	- modulo operations
+	- nChoosek
+	- ...
+*/
+
+namespace vio{
+
+	// defined here because should not have to include algorithm to have access to max.
+	#define max(a,b) \
+	   ({ __typeof__ (a) _a = (a); \
+		   __typeof__ (b) _b = (b); \
+		 _a > _b ? _a : _b; })
+	#define min(a,b) \
+	   ({ __typeof__ (a) _a = (a); \
+		   __typeof__ (b) _b = (b); \
+		 _a <= _b ? _a : _b; })
+
+	void seed();
+	void seed(u32 value);
+	void seed(u32 value1,u32 value2); // use this if you want more entropy.
+
+	float randomFloat();
+	/**
+	Returns a random float between 0 and 1
+	This method is an alias of randomFloat()
+	The randomness is not cryptographically secure. The global generator is not thread safe, see RandomStream for that.
+
+	The sequence returned by this method will always be the same (for a given seed) making it useful if you need to reproduce
+	a bug you encoutered in code involving randomness.
+	You can seed this function using the seed(u32 value) function or just seed().
+	@code
+	seed(312);
+	float r = 0;
+	for(u32 i = 0;i < 100;i++){
+		r += random();
+	}
+	vassert(abs(r - 50.783) < 0.01);
+	debug("r = %f",r); // r will always be the same.
+	@endcode
+	 */
+	float random(); // alias
+	float randomFloat();
+	double randomDouble();
+	u32 randomU32(const u32 max); // max included
+	// The next n numbers of the global generator, the same as n calls to randomU32(UINT32_MAX) or randomFloat() but much faster.
+	void randomU32s(u32 * out,size_t n);
+	void randomFloats(float * out,size_t n);
+	i32 randomI32(const i32 min,const i32 max); // max and min included
+
+	// Counter based randomness: the result only depends on (key,counter), so a value can be recomputed anywhere,
+	// in any order and on any thread without storing it or sharing a generator. It does not use or change the seed.
+	// Use RandomStream (math/RandomStream.h) for streams of numbers, bulk fills and gaussians.
+	u32 hashRandom(u32 key,u32 counter);
+
+	double randAtInt(i32 x,i32 y,i32 z);
+
+	inline float mod(float base, float div) { // modulus for floating numbers
+		float fractPart = modff(base / div, nullptr); // nullptr is usually used to retrieve the integer part of base / div (pointer to float)
+		if (fractPart <= 0) fractPart += 1;
+		return fractPart * div;
+	}
+	inline i32 mod(i32 base, i32 div) {
+		i32 m = base % div;
+		if (m < 0) return m + div;
+		return m;
+	}
+
+	// Sum of n floats by recursive halving. The rounding error grows in log(n) instead of n,
+	// and the order of the additions only depends on n, so the result is reproducible.
+	float pairwiseSum(const float * v,u32 n);
+
+	u32 nChoosek(u32 n, u32 k);
+	i32 modPow(i32 base,i32 exponent,i32 modulus);
+
+	double perlin(double x, double y, double z);
+	double isoperlin(double x,double y,double z);
+
+	class ThreadPool;
+	/**
+	Samples perlin on a whole lattice, much faster than one call per point: the corners shared by neighbouring cells
+	are only hashed once, the interpolation is vectorized and the rows can be split between the threads of a pool.
+
+	out[(k * dims[1] + j) * dims[0] + i] is the sum over the octaves o of perlin(f*x,f*y,f*z) / f, with f = 2^o and
+	(x,y,z) = origin + (i,j,k) * step. With 1 octave, the values are the ones of perlin (rounded to float for the float version).
+	For a 2D field, use dims[2] = 1.
+	@code
+	const double origin[3] = {0,0,0.5};
+	const double step[3] = {0.05,0.05,0};
+	const u32 dims[3] = {256,256,1};
+	std::vector<float> field(256 * 256);
+	perlinGrid(origin,step,dims,4,field.data(),&pool);
+	@endcode
+	 */
+	void perlinGrid(const double origin[3],const double step[3],const u32 dims[3],u32 octaves,double * out,ThreadPool * pool = 0);
+	void perlinGrid(const double origin[3],const double step[3],const u32 dims[3],u32 octaves,float * out,ThreadPool * pool = 0);
+
+}
@@ -0,0 +1,200 @@
+/*
+ * Checkpointer.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "Checkpointer.h"
+#include "NeuralNetwork.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#include <codecvt>
+#include <locale>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace vio {
+
+	Checkpointer::Checkpointer(const std::string& path,u32 interval,Optimizer * optimizer,u32 syncBatch){
+		this->path = path;
+		this->interval = interval;
+		this->optimizer = optimizer;
+		this->syncBatch = syncBatch > 0 ? syncBatch : 1;
+		writer = std::thread(&Checkpointer::writerLoop,this);
+	}
+	Checkpointer::~Checkpointer(){
+		flush();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		cond.notify_all();
+		writer.join();
+		delete[] buffers[0].data;
+		delete[] buffers[1].data;
+	}
+
+	void Checkpointer::step(NeuralNetwork& nn,u32 samples){
+		if(interval == 0) return;
+		sinceLastCheckpoint += samples;
+		if(sinceLastCheckpoint >= interval){
+			sinceLastCheckpoint = 0;
+			snapshot(nn);
+		}
+	}
+
+	void Checkpointer::snapshot(NeuralNetwork& nn){
+		std::vector<ParameterBlock> extra;
+		if(optimizer != 0) extra = optimizer->state();
+
+		if(nn.layers != layoutLayers || extra.size() != layoutExtraCount || layout.size == 0){
+			// the network changed (or first snapshot), the blocks move.
+			layout = computeModelLayout(nn.layers,extra);
+			layoutLayers = nn.layers;
+			layoutExtraCount = extra.size();
+		}
+
+		// Take the buffer that is not being written. If it was waiting to be written, it is replaced by this newer snapshot.
+		int spare;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			spare = writing == 0 ? 1 : 0;
+			if(pending == spare) pending = -1;
+		}
+
+		Buffer& b = buffers[spare];
+		if(b.capacity < layout.size){
+			delete[] b.data;
+			b.data = new char[layout.size];
+			b.capacity = layout.size;
+		}
+		b.size = layout.size;
+		writeModelHeader(layout,nn.lossFunctionId(),b.data); // only the tables, the weights are not touched.
+		writeModelWeights(layout,nn.layers,extra,b.data);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			pending = spare;
+		}
+		cond.notify_all();
+	}
+
+	void Checkpointer::flush(){
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard,[this]{ return pending == -1 && writing == -1; });
+		if(unsyncedRenames > 0){
+			syncDirectory();
+			unsyncedRenames = 0;
+		}
+	}
+
+	u32 Checkpointer::checkpointsWritten(){
+		std::lock_guard<std::mutex> guard(lock);
+		return written;
+	}
+
+	bool Checkpointer::restoreOptimizer(const std::string& image,Optimizer& optimizer){
+		if(validateModel(image.data(),image.size()) != 0) return false;
+		const ModelHeader * h = (const ModelHeader*)image.data();
+		const ModelBlockRecord * br = (const ModelBlockRecord*)(image.data() + h->blockTableOffset);
+
+		std::vector<ParameterBlock> state = optimizer.state();
+		u32 first = h->blockCount;
+		while(first > 0 && br[first-1].layer == MODEL_NO_LAYER) first--;
+		if(h->blockCount - first != state.size()) return false;
+		for(u32 i = 0;i < state.size();i++){
+			if(br[first+i].size != state[i].size) return false;
+		}
+		for(u32 i = 0;i < state.size();i++){
+			memcpy(state[i].data,image.data() + br[first+i].offset,(size_t)state[i].size * sizeof(float));
+		}
+		return true;
+	}
+
+	void Checkpointer::writerLoop(){
+		std::unique_lock<std::mutex> guard(lock);
+		while(true){
+			cond.wait(guard,[this]{ return pending != -1 || stopping; });
+			if(pending == -1) return; // stopping and nothing left to write.
+
+			writing = pending;
+			pending = -1;
+			guard.unlock();
+
+			bool ok = writeBuffer(buffers[writing]);
+
+			guard.lock();
+			writing = -1;
+			if(ok){
+				written++;
+				unsyncedRenames++;
+				if(unsyncedRenames >= syncBatch){
+					syncDirectory();
+					unsyncedRenames = 0;
+				}
+			}
+			cond.notify_all();
+		}
+	}
+
+	// Writes to path.tmp, syncs it and renames it over path.
+	bool Checkpointer::writeBuffer(const Buffer& b){
+		std::string tmp = path + ".tmp";
+#ifdef WIN32
+		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+		std::wstring wtmp = convert.from_bytes(tmp.c_str());
+		std::wstring wpath = convert.from_bytes(path.c_str());
+		FILE * f = 0;
+		_wfopen_s(&f,wtmp.c_str(),L"wb");
+#else
+		FILE * f = fopen(tmp.c_str(),"wb");
+#endif
+		if(f == 0){
+			debug("Checkpoint: unable to open %s",tmp.c_str());
+			return false;
+		}
+		bool ok = fwrite(b.data,1,b.size,f) == b.size;
+		ok = fflush(f) == 0 && ok;
+#ifdef WIN32
+		ok = _commit(_fileno(f)) == 0 && ok;
+#else
+		ok = fsync(fileno(f)) == 0 && ok;
+#endif
+		ok = fclose(f) == 0 && ok;
+		if(!ok){
+			debug("Checkpoint: unable to write %s",tmp.c_str());
+			return false;
+		}
+#ifdef WIN32
+		ok = MoveFileExW(wtmp.c_str(),wpath.c_str(),MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		ok = rename(tmp.c_str(),path.c_str()) == 0;
+#endif
+		if(!ok){
+			debug("Checkpoint: unable to rename %s",tmp.c_str());
+		}
+		return ok;
+	}
+
+	void Checkpointer::syncDirectory(){
+#ifndef WIN32
+		// MOVEFILE_WRITE_THROUGH already makes the rename durable on windows.
+		std::string dir = ".";
+		size_t slash = path.find_last_of('/');
+		if(slash != std::string::npos) dir = slash == 0 ? "/" : path.substr(0,slash);
+		int fd = open(dir.c_str(),O_RDONLY);
+		if(fd < 0) return;
+		fsync(fd);
+		close(fd);
+#endif
+	}
+
+} /* namespace vio */
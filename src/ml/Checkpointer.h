@@ -0,0 +1,97 @@
+/*
+ * Checkpointer.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "ModelFormat.h"
+#include "Optimizer.h"
+
+namespace vio {
+
+	class NeuralNetwork;
+
+	/**
+	Saves a NeuralNetwork periodically during training without stopping it.
+
+	A checkpoint is a model file (see ModelFormat.h) followed by the state of the optimizer, if there is one.
+	Taking a checkpoint only copies the weights into a spare buffer (a few memcpy), the file is written
+	by a background thread. There are two buffers: while one is being written, the next snapshot goes to the other one.
+	If the disk is slower than the checkpoint interval, the snapshots that could not be written in time are replaced by newer ones.
+
+	The file is written to path + ".tmp", synced and renamed to path, so path always contains a complete checkpoint,
+	even if the process crashes in the middle of a write. The syncs of the directory (needed for the rename to survive a power loss)
+	are batched: one every syncBatch checkpoints and one on flush().
+
+	@code
+	Checkpointer cp("model.vlnn",10000); // every 10000 training samples
+	nn.checkpointer = &cp;
+	for(u32 i = 0;i < 100;i++){
+		nn.train(trainingInputs,trainingOutputs);
+	}
+	cp.flush();
+	// model.vlnn can be opened with NeuralNetwork::load / loadMapped
+	@endcode
+	 */
+	class Checkpointer{
+	private:
+		std::string path;
+		u32 interval;
+		u32 syncBatch;
+		Optimizer * optimizer;
+
+		u32 sinceLastCheckpoint = 0;
+
+		// Layout of the network when the last snapshot was taken, recomputed when the layers change.
+		ModelLayout layout;
+		std::vector<Layer*> layoutLayers;
+		u32 layoutExtraCount = 0;
+
+		struct Buffer{
+			char * data = 0;
+			uint64_t capacity = 0;
+			uint64_t size = 0;
+		};
+		Buffer buffers[2];
+
+		std::thread writer;
+		std::mutex lock;
+		std::condition_variable cond;
+		int pending = -1; // buffer ready to be written
+		int writing = -1; // buffer being written by the background thread
+		bool stopping = false;
+		u32 written = 0;
+		u32 unsyncedRenames = 0;
+
+		void writerLoop();
+		bool writeBuffer(const Buffer& b);
+		void syncDirectory();
+	public:
+		// interval: number of training samples between checkpoints (0 to only snapshot manually).
+		Checkpointer(const std::string& path,u32 interval,Optimizer * optimizer = 0,u32 syncBatch = 8);
+		Checkpointer(Checkpointer& c) = delete;
+		Checkpointer& operator=(const Checkpointer& c) = delete;
+		~Checkpointer(); // flushes
+
+		// Called by NeuralNetwork::train after every sample, takes a snapshot every interval samples.
+		void step(NeuralNetwork& nn,u32 samples = 1);
+		// Takes a snapshot now. Only copies memory, the write happens in the background.
+		void snapshot(NeuralNetwork& nn);
+		// Blocks until the latest snapshot is on disk.
+		void flush();
+
+		u32 checkpointsWritten();
+
+		// Copies the optimizer state stored in a checkpoint image back into the optimizer (the weights are restored by NeuralNetwork::load).
+		// Returns false if the image does not contain a state of the right shape.
+		static bool restoreOptimizer(const std::string& image,Optimizer& optimizer);
+	};
+
+} /* namespace vio */
@@ -1,118 +1,315 @@
-/*
- * DenseLayer.cpp
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#include "DenseLayer.h"
-#include "math/math.h"
-
-namespace vio {
-
-// The activator functions
-float reluFn(float f){
-	return f > 0 ? f : 0;
-}
-float reluDerivativeFn(float f){
-	return f > 0 ? 1 : 0;
-}
-float leakyReluFn(float f){
-	return f > 0 ? f : 0.01*f;
-}
-float leakyReluDerivativeFn(float f){
-	return f > 0 ? 1 : 0.01;
-}
-float sigmoidFn(float f){
-	return 1 / (1 + std::exp(-f));
-}
-float sigmoidDerivativeFn(float f){
-	return f*(1-f); // this is sigmoid'(x) = sigmoid(x) * (1 - sigmoid(x))
-}
-float tanhFn(float f){
-	return std::tanh(f);
-}
-float tanhDerivativeFn(float f){
-	return 1-f*f; // tanh' = 1 - tanh(f)**2
-}
-float softmaxFn(float f){
-	return std::log(1+std::exp(f));
-}
-float softmaxDerivativeFn(float f){
-	return std::exp(-f);
-}
-
-typedef float (*mathFn)(float);
-mathFn getActivator(const std::string& actName){
-	if(actName == "sigmoid"){
-		return sigmoidFn;
-	}else if(actName == "tanh"){
-		return tanhFn;
-	}else if(actName == "relu"){
-		return reluFn;
-	}else if(actName == "softmax"){
-		return softmaxFn;
-	}else{ // leaky relu.
-		return leakyReluFn;
-	}
-}
-mathFn getActivatorDerivative(const std::string& actName){
-	if(actName == "sigmoid"){
-		return sigmoidDerivativeFn;
-	}else if(actName == "tanh"){
-		return tanhDerivativeFn;
-	}else if(actName == "relu"){
-		return reluDerivativeFn;
-	}else if(actName == "softmax"){
-		return softmaxDerivativeFn;
-	}else{ // leaky relu.
-		return leakyReluDerivativeFn;
-	}
-}
-
-DenseLayer::DenseLayer(u32 inputSize,u32 outputSize,const std::string& activator) : Layer(inputSize,outputSize),m(inputSize,outputSize),b(outputSize){
-	activatorFn = getActivator(activator);
-	activatorDerivativeFn = getActivatorDerivative(activator);
-	this->learnable = true;
-	this->bias = true;
-	this->b.fill(0); // it is common to init the biases at 0 at the beginning.
-}
-DenseLayer::~DenseLayer(){
-
-}
-void DenseLayer::print(){
-	debug("Layer %i x %i (dense)",this->inS,this->outS);
-	debug("m=");
-	m.print();
-	debug("b=");
-	b.print();
-}
-Vector DenseLayer::apply(const Vector& x){
-	vassert(x.size() == inS);
-	// y = relu(mx)
-	Vector y = m.apply(x);
-	y += b;
-	for(u32 i = 0;i < y.size();i++){
-		y.at(i) = activatorFn(y.get(i));
-	}
-	return y;
-}
-Vector DenseLayer::applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& unused){
-	Vector r = m.applyTranspose(in);
-	// Note that the evaluation position is the once after the layer has been applied.
-	for(u32 x = 0;x < r.size();x++){
-		r.at(x) *= this->activatorDerivativeFn(evaluationPosition.get(x));
-	}
-	return r;
-}
-void DenseLayer::updateBias(const Vector& vec){
-	this->b -= vec;
-}
-void DenseLayer::updateMatrix(const Matrix& um){
-	this->m -= um;
-}
-void DenseLayer::randomInit(float dev,float mean){
-	this->m.fillRandom(dev,mean); // r = (x-.5) * 2 * dev + mean
-}
-
-} /* namespace vio */
+/*
+ * DenseLayer.cpp
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#include "DenseLayer.h"
+#include "math/RandomStream.h"
+#include "math/math.h"
+
+namespace vio {
+
+// The activator functions
+float reluFn(float f){
+	return f > 0 ? f : 0;
+}
+float reluDerivativeFn(float f){
+	return f > 0 ? 1 : 0;
+}
+float leakyReluFn(float f){
+	return f > 0 ? f : 0.01*f;
+}
+float leakyReluDerivativeFn(float f){
+	return f > 0 ? 1 : 0.01;
+}
+float sigmoidFn(float f){
+	return 1 / (1 + std::exp(-f));
+}
+float sigmoidDerivativeFn(float f){
+	return f*(1-f); // this is sigmoid'(x) = sigmoid(x) * (1 - sigmoid(x))
+}
+float tanhFn(float f){
+	return std::tanh(f);
+}
+float tanhDerivativeFn(float f){
+	return 1-f*f; // tanh' = 1 - tanh(f)**2
+}
+float softmaxFn(float f){
+	return std::log(1+std::exp(f));
+}
+float softmaxDerivativeFn(float f){
+	return std::exp(-f);
+}
+
+// The position in this table is what model files store, only append to it.
+static const char * activatorNames[] = {"leakyrelu","sigmoid","tanh","relu","softmax"};
+static constexpr u32 activatorCount = sizeof(activatorNames) / sizeof(activatorNames[0]);
+
+u32 getActivatorId(const std::string& actName){
+	for(u32 i = 1;i < activatorCount;i++){
+		if(actName == activatorNames[i]) return i;
+	}
+	return 0; // leaky relu.
+}
+
+typedef float (*mathFn)(float);
+mathFn getActivator(const std::string& actName){
+	if(actName == "sigmoid"){
+		return sigmoidFn;
+	}else if(actName == "tanh"){
+		return tanhFn;
+	}else if(actName == "relu"){
+		return reluFn;
+	}else if(actName == "softmax"){
+		return softmaxFn;
+	}else{ // leaky relu.
+		return leakyReluFn;
+	}
+}
+mathFn getActivatorDerivative(const std::string& actName){
+	if(actName == "sigmoid"){
+		return sigmoidDerivativeFn;
+	}else if(actName == "tanh"){
+		return tanhDerivativeFn;
+	}else if(actName == "relu"){
+		return reluDerivativeFn;
+	}else if(actName == "softmax"){
+		return softmaxDerivativeFn;
+	}else{ // leaky relu.
+		return leakyReluDerivativeFn;
+	}
+}
+
+DenseLayer::DenseLayer(u32 inputSize,u32 outputSize,const std::string& activator) : Layer(inputSize,outputSize),m(inputSize,outputSize),b(outputSize){
+	activatorFn = getActivator(activator);
+	activatorDerivativeFn = getActivatorDerivative(activator);
+	activatorId = getActivatorId(activator);
+	this->learnable = true;
+	this->bias = true;
+	this->b.fill(0); // it is common to init the biases at 0 at the beginning.
+}
+DenseLayer::~DenseLayer(){
+
+}
+void DenseLayer::print(){
+	debug("Layer %i x %i (dense)",this->inS,this->outS);
+	debug("m=");
+	m.print();
+	debug("b=");
+	b.print();
+}
+Vector DenseLayer::apply(const Vector& x){
+	Vector y(outS);
+	applyInto(x,y);
+	return y;
+}
+// [begin,end) of the shard-th part out of count parts of size elements.
+static inline u32 shardBegin(u32 size,u32 shard,u32 count){
+	return (uint64_t)size * shard / count;
+}
+
+u32 DenseLayer::shardCount(){
+	if(shardPool == 0 || shardMode == SHARD_NONE || ThreadPool::insideParallelFor()) return 1;
+	return shardPool->size();
+}
+void DenseLayer::shard(ThreadPool * pool,ShardMode mode){
+	shardPool = pool;
+	shardMode = pool == 0 ? SHARD_NONE : mode;
+	if(shardMode == SHARD_NONE){
+		partial = std::vector<float>();
+	}else{
+		partial.assign((size_t)pool->size() * (inS > outS ? inS : outS),0);
+	}
+}
+
+// y[r] = activator(m[r].x + b[r]) for the rows [begin,end) of m. The unsharded and the SHARD_ROWS forward passes
+// both use it, so they give the same result whatever the compiler does with the loop.
+static void forwardRows(const float * md,const float * xd,const float * bd,float * yd,u32 inS,u32 begin,u32 end,float (*activator)(float)){
+	for(u32 r = begin;r < end;r++){
+		const float * row = md + (size_t)r * inS;
+		float acc = 0;
+		for(u32 c = 0;c < inS;c++){
+			acc += row[c] * xd[c];
+		}
+		yd[r] = activator(acc + bd[r]);
+	}
+}
+// r[c] = derivative(e[c]) * sum over y of m[y][c] * v[y], for the columns [begin,end) of m.
+// Shared by the unsharded and the SHARD_COLUMNS backward passes, like forwardRows.
+static void backwardColumns(const float * md,const float * vd,const float * ed,float * rd,u32 inS,u32 outS,u32 begin,u32 end,float (*derivative)(float)){
+	for(u32 c = begin;c < end;c++) rd[c] = 0;
+	for(u32 y = 0;y < outS;y++){
+		const float * row = md + (size_t)y * inS;
+		for(u32 c = begin;c < end;c++){
+			rd[c] += row[c] * vd[y];
+		}
+	}
+	for(u32 c = begin;c < end;c++){
+		rd[c] *= derivative(ed[c]);
+	}
+}
+
+void DenseLayer::applyInto(const Vector& x,Vector& y){
+	vassert(x.size() == inS);
+	vassert(y.size() == outS);
+	const float * md = m.data();
+	const float * xd = x.raw();
+	float * yd = y.raw();
+	const float * bd = b.raw();
+	const u32 shards = shardCount();
+	if(shards == 1){
+		forwardRows(md,xd,bd,yd,inS,0,outS,activatorFn);
+		return;
+	}
+
+	if(shardMode == SHARD_ROWS){
+		// every shard computes its own outputs, no communication.
+		shardPool->forEachWorker([&](u32 s){
+			forwardRows(md,xd,bd,yd,inS,shardBegin(outS,s,shards),shardBegin(outS,s+1,shards),activatorFn);
+		});
+		return;
+	}
+
+	// SHARD_COLUMNS: partial products of every shard, then every shard sums a range of outputs (reduce-scatter).
+	float * pd = partial.data();
+	shardPool->forEachWorker([&](u32 s){
+		const u32 cb = shardBegin(inS,s,shards);
+		const u32 ce = shardBegin(inS,s+1,shards);
+		float * p = pd + (size_t)s * outS;
+		for(u32 r = 0;r < outS;r++){
+			const float * row = md + (size_t)r * inS;
+			float acc = 0;
+			for(u32 c = cb;c < ce;c++){
+				acc += row[c] * xd[c];
+			}
+			p[r] = acc;
+		}
+	});
+	shardPool->forEachWorker([&](u32 s){
+		for(u32 r = shardBegin(outS,s,shards);r < shardBegin(outS,s+1,shards);r++){
+			float acc = 0;
+			for(u32 k = 0;k < shards;k++){
+				acc += pd[(size_t)k * outS + r];
+			}
+			yd[r] = activatorFn(acc + bd[r]);
+		}
+	});
+}
+Vector DenseLayer::applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& unused){
+	Vector r(inS);
+	applyGradientInto(in,evaluationPosition,unused,r);
+	return r;
+}
+void DenseLayer::applyGradientInto(const Vector& in,const Vector& evaluationPosition,const Vector& unused,Vector& r){
+	// Note that the evaluation position is the once after the layer has been applied.
+	vassert(in.size() == outS);
+	vassert(r.size() == inS);
+	const float * md = m.data();
+	const float * vd = in.raw();
+	const float * ed = evaluationPosition.raw();
+	float * rd = r.raw();
+	const u32 shards = shardCount();
+	if(shards == 1){
+		backwardColumns(md,vd,ed,rd,inS,outS,0,inS,activatorDerivativeFn);
+		return;
+	}
+
+	if(shardMode == SHARD_COLUMNS){
+		// every shard computes its own inputs, no communication.
+		shardPool->forEachWorker([&](u32 s){
+			backwardColumns(md,vd,ed,rd,inS,outS,shardBegin(inS,s,shards),shardBegin(inS,s+1,shards),activatorDerivativeFn);
+		});
+		return;
+	}
+
+	// SHARD_ROWS: partial gradients of every shard, then reduce-scatter over the inputs.
+	float * pd = partial.data();
+	shardPool->forEachWorker([&](u32 s){
+		float * p = pd + (size_t)s * inS;
+		for(u32 c = 0;c < inS;c++) p[c] = 0;
+		for(u32 y = shardBegin(outS,s,shards);y < shardBegin(outS,s+1,shards);y++){
+			const float * row = md + (size_t)y * inS;
+			for(u32 c = 0;c < inS;c++){
+				p[c] += row[c] * vd[y];
+			}
+		}
+	});
+	shardPool->forEachWorker([&](u32 s){
+		for(u32 c = shardBegin(inS,s,shards);c < shardBegin(inS,s+1,shards);c++){
+			float acc = 0;
+			for(u32 k = 0;k < shards;k++){
+				acc += pd[(size_t)k * inS + c];
+			}
+			rd[c] = acc * this->activatorDerivativeFn(ed[c]);
+		}
+	});
+}
+void DenseLayer::updateBias(const Vector& vec){
+	this->b -= vec;
+}
+double DenseLayer::applyFlops(){
+	return 2.0 * inS * outS + 2.0 * outS;
+}
+double DenseLayer::gradientFlops(){
+	return 2.0 * inS * outS + outS;
+}
+void DenseLayer::updateMatrix(const Matrix& um){
+	const u32 shards = shardCount();
+	if(shards == 1){
+		this->m -= um;
+		return;
+	}
+	vassert(um.width() == inS && um.height() == outS);
+	float * md = m.data();
+	const float * ud = um.data();
+	// every shard updates the weights it uses, on the same worker as the passes.
+	shardPool->forEachWorker([&](u32 s){
+		if(shardMode == SHARD_ROWS){
+			const size_t e = (size_t)shardBegin(outS,s+1,shards) * inS;
+			for(size_t i = (size_t)shardBegin(outS,s,shards) * inS;i < e;i++){
+				md[i] -= ud[i];
+			}
+			return;
+		}
+		const u32 cb = shardBegin(inS,s,shards);
+		const u32 ce = shardBegin(inS,s+1,shards);
+		for(u32 r = 0;r < outS;r++){
+			for(size_t i = (size_t)r * inS + cb;i < (size_t)r * inS + ce;i++){
+				md[i] -= ud[i];
+			}
+		}
+	});
+}
+void DenseLayer::randomInit(float dev,float mean){
+	this->m.fillRandom(dev,mean); // r = (x-.5) * 2 * dev + mean
+}
+void DenseLayer::randomInit(RandomStream& rng,float dev,float mean){
+	rng.fillUniform(this->m.data(),(size_t)inS * outS,mean - dev,mean + dev,shardPool);
+}
+LayerDescriptor DenseLayer::describe(){
+	LayerDescriptor d;
+	d.type = LAYER_DENSE;
+	d.inputSize = inS;
+	d.outputSize = outS;
+	d.args[0] = activatorId;
+	return d;
+}
+std::vector<ParameterBlock> DenseLayer::parameters(){
+	return {
+		{m.data(),m.width() * m.height()},
+		{b.raw(),b.size()}
+	};
+}
+void DenseLayer::bindParameters(const std::vector<float*>& blocks){
+	vassert(blocks.size() == 2);
+	m.bind(blocks[0]);
+	b.bind(blocks[1]);
+}
+const char * DenseLayer::activatorName(u32 activatorId){
+	if(activatorId >= activatorCount) return activatorNames[0];
+	return activatorNames[activatorId];
+}
+
+} /* namespace vio */
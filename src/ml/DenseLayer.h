@@ -1,60 +1,103 @@
-/*
- * DenseLayer.h
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#pragma once
-
-#include "Layer.h"
-#include "math/Matrix.h"
-#include "math/Vector.h"
-#include "utils/utils.h"
-#include <string>
-
-namespace vio {
-
-/**
-	 This is similar to a Dense Keras layer.
-	 It supports multiple activation functions but uses leaky relu by default.
-	 Example:
-	 @code
-	NeuralNetwork nn;
-	DenseLayer l1(3,5,"leakyrelu"); // inputsize, outputsize, activation function
-	DenseLayer l2(5,2,"leakyrelu"); // inputsize, outputsize, activation function
-	nn.layers.push_back(l1);
-	nn.layers.push_back(l2);
-	nn.prepare();
-	// You are ready to train / use the network now !
-	// It takes 3 numbers as input and outputs 2 numbers (a vector of size 2)
-	 @endcode
-	*/
-	class DenseLayer : public Layer{
-	private:
-		Matrix m;
-		Vector b;
-		float (*activatorFn)(float);
-		float (*activatorDerivativeFn)(float);
-
-	public:
-		DenseLayer(u32 inputSize,u32 outputSize,const std::string& activator = "leakyrelu");
-		~DenseLayer();
-
-		void print();
-
-		// function every layer has to implement
-		Vector apply(const Vector& in);
-
-		// used for gradient backpropagation
-		Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition);
-
-		// in case the layer is non learnable, those 2 functions are never called, they
-		// are used to update the weights
-		void updateMatrix(const Matrix& m);
-		void updateBias(const Vector& vec);
-
-		void randomInit(float dev,float mean = 0);
-	};
-} /* namespace vio */
-
+/*
+ * DenseLayer.h
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include "utils/ThreadPool.h"
+#include "Layer.h"
+#include "math/Matrix.h"
+#include "math/Vector.h"
+#include "utils/utils.h"
+#include <string>
+
+namespace vio {
+
+/**
+	 This is similar to a Dense Keras layer.
+	 It supports multiple activation functions but uses leaky relu by default.
+	 Example:
+	 @code
+	NeuralNetwork nn;
+	DenseLayer l1(3,5,"leakyrelu"); // inputsize, outputsize, activation function
+	DenseLayer l2(5,2,"leakyrelu"); // inputsize, outputsize, activation function
+	nn.layers.push_back(l1);
+	nn.layers.push_back(l2);
+	nn.prepare();
+	// You are ready to train / use the network now !
+	// It takes 3 numbers as input and outputs 2 numbers (a vector of size 2)
+	 @endcode
+
+	 Very wide layers can be split across the threads of a pool with shard():
+	 - SHARD_ROWS: every thread owns a range of outputs. The forward pass needs no communication,
+	   the backward pass sums the partial input gradients of every thread.
+	 - SHARD_COLUMNS: every thread owns a range of inputs. The backward pass needs no communication,
+	   the forward pass sums the partial outputs of every thread.
+	 The pass without communication gives the same result as an unsharded layer, the other one only differs by rounding.
+	 Shard i always runs on worker i of the pool (ThreadPool::forEachWorker), so its weights stay in the same core's cache.
+	 When called from inside a parallelFor (for example by NeuralNetwork::loss), the layer runs unsharded.
+	 A sharded layer keeps its partial sums in a buffer of its own: it must not be called by two threads at once.
+	 @code
+	ThreadPool pool(8);
+	DenseLayer wide(1024,32768);
+	wide.shard(&pool,DenseLayer::SHARD_ROWS);
+	 @endcode
+	*/
+	class DenseLayer : public Layer{
+	public:
+		enum ShardMode{
+			SHARD_NONE,
+			SHARD_ROWS, // split by outputs
+			SHARD_COLUMNS // split by inputs
+		};
+	private:
+		Matrix m;
+		Vector b;
+		float (*activatorFn)(float);
+		float (*activatorDerivativeFn)(float);
+		u32 activatorId; // index in the activator table, stored in model files.
+
+		ThreadPool * shardPool = 0;
+		ShardMode shardMode = SHARD_NONE;
+		std::vector<float> partial; // shards x max(inS,outS), partial sums of the pass that communicates
+		u32 shardCount(); // 1 when the layer runs unsharded.
+
+	public:
+		DenseLayer(u32 inputSize,u32 outputSize,const std::string& activator = "leakyrelu");
+		~DenseLayer();
+
+		void print();
+
+		// function every layer has to implement
+		Vector apply(const Vector& in);
+		void applyInto(const Vector& in,Vector& out);
+
+		// used for gradient backpropagation
+		Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition);
+		void applyGradientInto(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition,Vector& out);
+
+		// in case the layer is non learnable, those 2 functions are never called, they
+		// are used to update the weights
+		void updateMatrix(const Matrix& m);
+		void updateBias(const Vector& vec);
+
+		double applyFlops(); // matrix product, bias and activation
+		double gradientFlops();
+
+		void randomInit(float dev,float mean = 0);
+		void randomInit(RandomStream& rng,float dev,float mean = 0); // reproducible, uses the shard pool if there is one
+
+		LayerDescriptor describe();
+		std::vector<ParameterBlock> parameters(); // m then b
+		void bindParameters(const std::vector<float*>& blocks);
+
+		// The pool is not owned by the layer and must outlive it. shard(0,SHARD_NONE) goes back to a single thread.
+		void shard(ThreadPool * pool,ShardMode mode);
+
+		static const char * activatorName(u32 activatorId); // inverse of the activator argument of the constructor
+	};
+} /* namespace vio */
+
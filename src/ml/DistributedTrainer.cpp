@@ -0,0 +1,358 @@
+/*
+ * DistributedTrainer.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include <chrono>
+#include <cstring>
+#include "DistributedTrainer.h"
+#include "Checkpointer.h"
+#include "math/math.h"
+
+namespace vio {
+
+	DistributedTrainer::DistributedTrainer(NeuralNetwork& nn,u32 rank,const std::vector<std::string>& workers) : nn(nn){
+		vassert(rank < workers.size());
+		this->rank = rank;
+		this->workers = workers;
+	}
+
+	DistributedTrainer::~DistributedTrainer(){
+		reduceQueue.close();
+		sendQueue.close();
+		if(reducer.joinable()) reducer.join();
+		if(sender.joinable()) sender.join();
+	}
+
+	u32 DistributedTrainer::workerCount(){
+		return workers.size();
+	}
+
+	u32 DistributedTrainer::listen(){
+		if(!listener.isOpen() && !listener.listen(portOf(workers[rank]))) return 0;
+		return listener.localPort();
+	}
+
+	void DistributedTrainer::setWorkers(const std::vector<std::string>& workers){
+		vassert(workers.size() == this->workers.size());
+		this->workers = workers;
+	}
+
+	bool DistributedTrainer::connect(){
+		const u32 n = workerCount();
+		if(n == 1) return true;
+		if(listen() == 0) return false;
+
+		// the next worker might not be started yet.
+		const std::string& to = workers[(rank + 1) % n];
+		auto start = std::chrono::steady_clock::now();
+		while(!next.connect(hostOf(to),portOf(to))){
+			if(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(connectTimeout)) return false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		if(!listener.accept(previous)) return false;
+		listener.close();
+
+		// same starting point for everybody.
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				if(!broadcast(p.data,p.size * sizeof(float))) return false;
+			}
+		}
+
+		reducer = std::thread(&DistributedTrainer::reducerLoop,this);
+		sender = std::thread(&DistributedTrainer::senderLoop,this);
+		return true;
+	}
+
+	bool DistributedTrainer::broadcast(void * data,u32 size){
+		const u32 n = workerCount();
+		if(n == 1) return true;
+		if(rank != 0 && !previous.receive(data,size)){
+			debug("Lost the connection to worker %i",(rank + n - 1) % n);
+			return fail();
+		}
+		if(rank + 1 < n && !next.send(data,size)){
+			debug("Lost the connection to worker %i",rank + 1);
+			return fail();
+		}
+		return true;
+	}
+
+	bool DistributedTrainer::fail(){
+		// the neighbours are blocked on these sockets: closing them lets the failure go around the ring.
+		failed = true;
+		next.close();
+		previous.close();
+		return false;
+	}
+
+	void DistributedTrainer::senderLoop(){
+		SendJob job;
+		while(sendQueue.pop(job)){
+			sentQueue.push(next.send(job.data,job.size));
+		}
+	}
+
+	void DistributedTrainer::reducerLoop(){
+		u32 b;
+		while(reduceQueue.pop(b)){
+			// after a failure, the buckets left are only handed back: train stops once the step is over.
+			if(!failed){
+				if(compressor != 0){
+					compressedAllGather(b);
+				}else{
+					allReduce(buckets[b].begin,buckets[b].end);
+				}
+			}
+			reducedQueue.push(b);
+		}
+	}
+
+	bool DistributedTrainer::allReduce(u32 begin,u32 end){
+		const u32 n = workerCount();
+		const u32 length = end - begin;
+		float * data = gradientData.data();
+		auto chunkBegin = [&](u32 c){ return begin + (u32)((uint64_t)length * c / n); };
+		auto chunkSize = [&](u32 c){ return chunkBegin(c + 1) - chunkBegin(c); };
+		auto exchange = [&](u32 sent,float * into,u32 received){
+			sendQueue.push({data + chunkBegin(sent),chunkSize(sent) * sizeof(float)});
+			bool ok = previous.receive(into,received * sizeof(float));
+			bool sentOk = false;
+			sentQueue.pop(sentOk);
+			if(!ok || !sentOk){
+				debug("Lost the connection to the other workers during an all-reduce");
+				return fail();
+			}
+			return true;
+		};
+		if(receiveBuffer.size() < chunkSize(0) + 1) receiveBuffer.resize(chunkSize(0) + 1);
+
+		// reduce-scatter: after n-1 steps, this worker has the sum of chunk rank+1.
+		for(u32 k = 0;k + 1 < n;k++){
+			const u32 s = (rank + n - k) % n;
+			const u32 r = (rank + 2 * n - k - 1) % n;
+			if(!exchange(s,receiveBuffer.data(),chunkSize(r))) return false;
+			float * target = data + chunkBegin(r);
+			for(u32 i = 0;i < chunkSize(r);i++){
+				target[i] += receiveBuffer[i];
+			}
+		}
+		// all-gather: pass the summed chunks around the ring.
+		for(u32 k = 0;k + 1 < n;k++){
+			const u32 s = (rank + 1 + n - k) % n;
+			const u32 r = (rank + n - k) % n;
+			if(!exchange(s,data + chunkBegin(r),chunkSize(r))) return false;
+		}
+		return true;
+	}
+
+	bool DistributedTrainer::compressedAllGather(u32 bucket){
+		const u32 n = workerCount();
+		u32 begin = buckets[bucket].begin;
+		const u32 end = buckets[bucket].end;
+		if(begin < 2){
+			if(!allReduce(0,2)) return false; // the stats of the step must stay exact.
+			begin = 2;
+		}
+		if(begin >= end) return true;
+		const u32 length = end - begin;
+		// with many workers, sending every compressed bucket costs more than the all-reduce.
+		if(!compressor->compresses(length,n)) return allReduce(begin,end);
+		float * data = gradientData.data() + begin;
+
+		// every payload starts with its size in bytes.
+		payloads.resize(n);
+		std::vector<char>& mine = payloads[rank];
+		mine.assign(sizeof(u32),0);
+		compressor->compress(bucket,data,length,mine);
+		u32 size = mine.size() - sizeof(u32);
+		memcpy(mine.data(),&size,sizeof(u32));
+
+		// pass the payloads around the ring: at step k, send the one of rank - k and receive the one of rank - k - 1.
+		for(u32 k = 0;k + 1 < n;k++){
+			std::vector<char>& sent = payloads[(rank + n - k) % n];
+			std::vector<char>& received = payloads[(rank + 2 * n - k - 1) % n];
+			sendQueue.push({sent.data(),sent.size()});
+			bool ok = previous.receive(&size,sizeof(u32));
+			if(ok){
+				received.resize(sizeof(u32) + size);
+				memcpy(received.data(),&size,sizeof(u32));
+				ok = previous.receive(received.data() + sizeof(u32),size);
+			}
+			bool sentOk = false;
+			sentQueue.pop(sentOk);
+			if(!ok || !sentOk){
+				debug("Lost the connection to the other workers during an all-gather");
+				return fail();
+			}
+		}
+
+		// same order on every worker, so the same sums.
+		std::fill(data,data + length,0);
+		for(u32 r = 0;r < n;r++){
+			compressor->decompressAdd(payloads[r].data() + sizeof(u32),length,data);
+		}
+		return true;
+	}
+
+	void DistributedTrainer::buildBuckets(){
+		const u32 L = nn.layers.size();
+		gradientOffset.assign(L,0);
+		buckets.clear();
+		u32 offset = 2; // loss sum and correct samples
+		u32 bucketStart = 0;
+		u32 lastAdded = L;
+		for(i32 j = L - 1;j >= 0;j--){
+			Layer * l = nn.layers[j];
+			if(!l->isLearnable()) continue;
+			gradientOffset[j] = offset;
+			offset += l->inputSize() * l->outputSize() + (l->isBias() ? l->outputSize() : 0);
+			lastAdded = j;
+			if(offset - bucketStart >= bucketSize){
+				buckets.push_back({bucketStart,offset,(u32)j});
+				bucketStart = offset;
+			}
+		}
+		if(bucketStart < offset){
+			buckets.push_back({bucketStart,offset,lastAdded});
+		}
+		gradientData.resize(offset);
+	}
+
+	EpochStats DistributedTrainer::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		vassert(in.size() == out.size());
+		vassert(batchSize > 0);
+		EpochStats stats;
+		stats.samples = in.size();
+		if(failed){
+			stats.ok = false;
+			return stats;
+		}
+		if(in.size() == 0) return stats;
+
+		const u32 n = workerCount();
+		const u32 L = nn.layers.size();
+		buildBuckets();
+
+		// shuffle in and out using a permutation, chosen by rank 0.
+		std::vector<u32> permutation = rank == 0 ? NeuralNetwork::shuffledIndices(in.size()) : std::vector<u32>(in.size());
+		if(!broadcast(permutation.data(),permutation.size() * sizeof(u32))){
+			stats.ok = false;
+			return stats;
+		}
+
+		u32 firstLearnable = L; // nothing needs to be propagated below this layer.
+		for(u32 i = 0;i < L;i++){
+			if(nn.layers[i]->isLearnable()){
+				firstLearnable = i;
+				break;
+			}
+		}
+
+		std::vector<std::vector<Vector>> activations(batchSize,std::vector<Vector>(L + 1,Vector(0)));
+		std::vector<Vector> gradient(batchSize,Vector(0));
+		double lossSum = 0;
+		double correct = 0;
+		const u32 stepSize = batchSize * n;
+
+		for(u32 start = 0;start < in.size();start += stepSize){
+			const u32 count = in.size() - start < stepSize ? in.size() - start : stepSize;
+			const u32 first = start + (u32)((uint64_t)count * rank / n);
+			const u32 samples = start + (u32)((uint64_t)count * (rank + 1) / n) - first;
+			std::fill(gradientData.begin(),gradientData.end(),0);
+
+			// forward pass of the samples of this worker
+			for(u32 i = 0;i < samples;i++){
+				const u32 index = permutation[first + i];
+				std::vector<Vector>& acts = activations[i];
+				acts[0] = Vector(in[index].size(),in[index].raw()); // a view, no copy.
+				for(u32 j = 0;j < L;j++){
+					acts[j+1] = nn.layers[j]->apply(acts[j]);
+				}
+				gradientData[0] += nn.errorFunction(acts[L],out[index]);
+				if(nn.computeAccuracy && NeuralNetwork::argmax(acts[L]) == NeuralNetwork::argmax(out[index])){
+					gradientData[1] += 1;
+				}
+				gradient[i] = nn.errorFunctionGradient(acts[L],out[index]);
+				if(gradient[i].normSquared() == 0.00){
+					gradient[i] = Vector(0); // nothing to learn from this sample.
+				}
+			}
+
+			// backward pass, one layer at a time for every sample. A bucket is sent as soon as its layers are done.
+			u32 nextBucket = 0;
+			for(i32 j = L - 1;j >= (i32)firstLearnable;j--){
+				Layer * l = nn.layers[j];
+				const bool propagate = j > (i32)firstLearnable;
+				for(u32 i = 0;i < samples;i++){
+					activations[i][j+1] = Vector(0); // not needed anymore
+					Vector& v2 = gradient[i];
+					if(v2.size() == 0) continue;
+					Vector next(0);
+					if(propagate){
+						next = l->applyGradient(v2,activations[i][j],activations[i][j-1]);
+					}
+					if(l->isLearnable()){
+						float * g = gradientData.data() + gradientOffset[j];
+						Matrix gm(l->inputSize(),l->outputSize(),g);
+						Vector::addCrossNorm(gm,v2,activations[i][j]); // J/dx * dx/dm = J/dm
+						if(l->isBias()){
+							Vector gb(l->outputSize(),g + l->inputSize() * l->outputSize());
+							gb += v2;
+						}
+					}
+					v2 = std::move(next);
+				}
+				while(n > 1 && nextBucket < buckets.size() && buckets[nextBucket].lastLayer == (u32)j){
+					reduceQueue.push(nextBucket++);
+				}
+			}
+			if(n > 1){
+				while(nextBucket < buckets.size()){
+					reduceQueue.push(nextBucket++);
+				}
+				for(u32 b = 0;b < buckets.size();b++){
+					u32 done;
+					reducedQueue.pop(done);
+				}
+				if(failed){
+					// some sums are missing: the update would make the workers diverge.
+					stats.ok = false;
+					return stats;
+				}
+			}
+
+			// every worker has the same sums and does the same update.
+			const float scale = learningRate / count;
+			for(u32 j = firstLearnable;j < L;j++){
+				Layer * l = nn.layers[j];
+				if(!l->isLearnable()) continue;
+				float * g = gradientData.data() + gradientOffset[j];
+				Matrix gm(l->inputSize(),l->outputSize(),g);
+				gm *= scale;
+				l->updateMatrix(gm);
+				if(l->isBias()){
+					Vector gb(l->outputSize(),g + l->inputSize() * l->outputSize());
+					gb *= scale;
+					l->updateBias(gb);
+				}
+			}
+			lossSum += gradientData[0];
+			correct += gradientData[1];
+
+			if(nn.checkpointer != 0 && rank == 0){
+				nn.checkpointer->step(nn,count);
+			}
+		}
+
+		stats.loss = lossSum / in.size();
+		if(nn.computeAccuracy){
+			stats.accuracy = correct / in.size();
+		}
+		return stats;
+	}
+
+} /* namespace vio */
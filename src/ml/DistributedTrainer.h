@@ -0,0 +1,121 @@
+/*
+ * DistributedTrainer.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include "NeuralNetwork.h"
+#include "GradientCompressor.h"
+#include "net/Socket.h"
+#include "datas/BlockingQueue.h"
+
+namespace vio {
+
+	/**
+	Data parallel training over the network.
+
+	Every worker (a process, on this machine or on another one) has the same network and the same dataset.
+	The workers are connected in a ring over TCP: worker r sends to worker r+1 and receives from worker r-1.
+	A step takes batchSize samples per worker. Every worker computes the gradient of its samples,
+	the gradients are summed with a ring all-reduce and every worker applies the same update, so the networks stay identical.
+
+	The backward pass goes layer by layer over all the samples of the worker. Once the layers of a bucket are done,
+	the bucket is all-reduced by a background thread while the backward pass continues with the layers below,
+	so most of the communication is hidden behind computation.
+
+	With a compressor (see GradientCompressor.h), the buckets are compressed and all-gathered instead of all-reduced:
+	every worker sends its compressed bucket around the ring and sums the ones of the others itself.
+	This sends n-1 compressed buckets per worker: when that is more than the all-reduce, the bucket is all-reduced uncompressed.
+
+	The workers exchange raw floats, they must have the same endianness.
+
+	@code
+	// on every worker, with rank = 0, 1 or 2:
+	std::vector<std::string> workers = {"10.0.0.1:4000","10.0.0.2:4000","10.0.0.3:4000"};
+	DistributedTrainer dt(nn,rank,workers);
+	if(!dt.connect()) vpanic("Unable to reach the other workers");
+	for(u32 i = 0;i < 100;i++){
+		EpochStats stats = dt.train(trainingInputs,trainingOutputs,0.01);
+		if(!stats.ok) break; // a worker is gone, the weights of this epoch are not applied.
+	}
+	@endcode
+	 */
+	class DistributedTrainer{
+	private:
+		struct Bucket{
+			u32 begin; // range of gradientData
+			u32 end;
+			u32 lastLayer; // the bucket is complete once the backward pass is done with this layer.
+		};
+		struct SendJob{
+			const void * data;
+			size_t size;
+		};
+
+		NeuralNetwork& nn;
+		u32 rank;
+		std::vector<std::string> workers;
+
+		Socket listener;
+		Socket next; // to rank + 1
+		Socket previous; // from rank - 1
+
+		// Gradients of the step, layers from last to first (the order in which the backward pass completes them).
+		// gradientData[0] and [1] are the loss sum and the number of correct samples of the step.
+		std::vector<float> gradientData;
+		std::vector<u32> gradientOffset; // per layer, position of the matrix in gradientData, then the bias.
+		std::vector<Bucket> buckets;
+
+		std::thread reducer; // all-reduces the buckets of reduceQueue
+		std::thread sender; // sends to next, so that a worker can send and receive at the same time.
+		BlockingQueue<u32> reduceQueue;
+		BlockingQueue<u32> reducedQueue;
+		BlockingQueue<SendJob> sendQueue;
+		BlockingQueue<bool> sentQueue;
+		std::vector<float> receiveBuffer;
+		std::vector<std::vector<char>> payloads; // compressed bucket of every worker
+
+		void reducerLoop();
+		void senderLoop();
+		// These return false when a connection is lost.
+		bool allReduce(u32 begin,u32 end); // sums gradientData[begin,end) over every worker.
+		bool compressedAllGather(u32 bucket); // same, but every worker sends a compressed version of its values.
+		bool broadcast(void * data,u32 size); // copies the data of rank 0 to every worker.
+		bool fail(); // closes the ring and returns false.
+		bool failed = false; // set by the reducer or by train, read by train once the reducer handed back every bucket.
+		void buildBuckets();
+	public:
+		// workers = "host:port" of every worker, the same list on every worker. This worker listens on the port of workers[rank].
+		DistributedTrainer(NeuralNetwork& nn,u32 rank,const std::vector<std::string>& workers);
+		DistributedTrainer(DistributedTrainer& d) = delete;
+		DistributedTrainer& operator=(const DistributedTrainer& d) = delete;
+		~DistributedTrainer();
+
+		u32 batchSize = 16; // samples per worker per step
+		u32 bucketSize = 1 << 16; // minimum number of floats sent in one all-reduce.
+		u32 connectTimeout = 30000; // in ms, time given to the other workers to start.
+		GradientCompressor * compressor = 0; // not owned. Only used with more than one worker.
+
+		// Starts listening on the port of workers[rank] and returns it, or 0 on failure. With port 0, the system picks a free port:
+		// call listen on every worker first, then give the list of the ports returned to setWorkers. connect listens if needed.
+		u32 listen();
+		// Replaces the addresses of the workers (same size), between listen and connect.
+		void setWorkers(const std::vector<std::string>& workers);
+		// Connects the ring and copies the weights of rank 0 to every worker. Returns false if a worker cannot be reached.
+		bool connect();
+		u32 workerCount();
+
+		// One pass over the dataset, shuffled by rank 0. Every worker must call it with the same dataset.
+		// The stats are over the samples of every worker.
+		// When a connection is lost, the step is not applied and stats.ok is false. The trainer cannot be used anymore:
+		// the ring is closed, so the other workers stop too.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate = 0.01);
+	};
+
+} /* namespace vio */
@@ -0,0 +1,147 @@
+/*
+ * EvolutionStrategy.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "EvolutionStrategy.h"
+#include "math/RandomStream.h"
+#include "math/math.h"
+
+namespace vio {
+
+	EvolutionStrategy::EvolutionStrategy(NeuralNetwork& nn,u32 threadCount) : nn(nn),pool(threadCount){
+
+	}
+	EvolutionStrategy::~EvolutionStrategy(){
+		for(NeuralNetwork * c : copies){
+			delete c;
+		}
+	}
+
+	void EvolutionStrategy::collectBlocks(){
+		blocks.clear();
+		parameterCount = 0;
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				blocks.push_back(p);
+				parameterCount += p.size;
+			}
+		}
+	}
+
+	// The copies get the layers of nn through serialize / load, once. Afterwards only the weights are copied.
+	void EvolutionStrategy::prepareCopies(){
+		if(copies.size() == pool.size()) return;
+		std::string image = nn.serialize();
+		for(u32 i = 0;i < pool.size();i++){
+			NeuralNetwork * c = new NeuralNetwork();
+			if(!c->load(image)) vpanic("The network cannot be copied, every layer must implement describe()");
+			c->errorFunction = nn.errorFunction;
+			c->errorFunctionGradient = nn.errorFunctionGradient;
+			c->computationCoreCount = 1; // the copies already run in parallel.
+			copies.push_back(c);
+		}
+	}
+
+	float EvolutionStrategy::step(){
+		vassert(fitness);
+		collectBlocks();
+		prepareCopies();
+		const u32 pairs = (population + 1) / 2;
+		std::vector<Sample> samples(pairs);
+
+		pool.parallelFor(pairs,1,[&](u32 begin,u32 end,u32 worker){
+			NeuralNetwork& copy = *copies[worker];
+			std::vector<ParameterBlock> target;
+			for(Layer * l : copy.layers){
+				for(ParameterBlock& p : l->parameters()) target.push_back(p);
+			}
+			for(u32 m = begin;m < end;m++){
+				const u32 s = hashRandom(seed,generation * pairs + m);
+				samples[m].seed = s;
+				for(i32 sign = 1;sign >= -1;sign -= 2){
+					RandomStream noise(s);
+					for(u32 b = 0;b < blocks.size();b++){
+						const float * from = blocks[b].data;
+						float * to = target[b].data;
+						noise.fillGaussian(to,blocks[b].size,0,sign * sigma);
+						for(u32 i = 0;i < blocks[b].size;i++){
+							to[i] += from[i];
+						}
+					}
+					(sign > 0 ? samples[m].fitness : samples[m].mirroredFitness) = fitness(copy);
+				}
+			}
+		});
+
+		update(samples);
+		generation++;
+		lastSamples = samples;
+
+		double sum = 0;
+		for(const Sample& s : samples){
+			sum += s.fitness + s.mirroredFitness;
+		}
+		return sum / (2 * pairs);
+	}
+
+	void EvolutionStrategy::update(const std::vector<Sample>& samples){
+		collectBlocks();
+		const u32 pairs = samples.size();
+		if(pairs == 0) return;
+
+		// Fitness shaping: only the ranks matter, centered in [-0.5,0.5]. Makes the update independent of the scale of the fitness.
+		std::vector<u32> order(2 * pairs);
+		for(u32 i = 0;i < order.size();i++) order[i] = i;
+		auto value = [&](u32 i){ return i % 2 == 0 ? samples[i / 2].fitness : samples[i / 2].mirroredFitness; };
+		std::sort(order.begin(),order.end(),[&](u32 a,u32 b){ return value(a) < value(b); });
+		std::vector<float> rank(2 * pairs);
+		for(u32 i = 0;i < order.size();i++){
+			rank[order[i]] = order.size() == 1 ? 0 : (float)i / (order.size() - 1) - 0.5f;
+		}
+		std::vector<float> weight(pairs);
+		for(u32 m = 0;m < pairs;m++){
+			weight[m] = rank[2 * m] - rank[2 * m + 1]; // +noise and -noise
+		}
+
+		// gradient estimate = sum(weight * noise) / (population * sigma), every thread takes a range of parameters.
+		const float scale = learningRate / (2 * pairs * sigma);
+		const u32 grain = 4096;
+		pool.parallelFor((parameterCount + grain - 1) / grain,1,[&](u32 begin,u32 end,u32 worker){
+			const uint64_t first = (uint64_t)begin * grain;
+			const uint64_t last = std::min<uint64_t>((uint64_t)end * grain,parameterCount);
+			std::vector<float> g(last - first),noise(last - first);
+			uint64_t offset = 0;
+			for(ParameterBlock& p : blocks){
+				uint64_t from = std::max<uint64_t>(first,offset);
+				uint64_t to = std::min<uint64_t>(last,offset + p.size);
+				float * d = p.data + (from - offset);
+				offset += p.size;
+				if(from >= to) continue;
+				const u32 n = to - from;
+				std::fill(g.begin(),g.begin() + n,0.f);
+				for(u32 m = 0;m < pairs;m++){
+					RandomStream rng(samples[m].seed);
+					rng.seek(from);
+					rng.fillGaussian(noise.data(),n);
+					for(u32 i = 0;i < n;i++) g[i] += weight[m] * noise[i];
+				}
+				for(u32 i = 0;i < n;i++) d[i] += scale * g[i];
+			}
+		});
+	}
+
+	EpochStats EvolutionStrategy::train(std::vector<Vector>& in,std::vector<Vector>& out){
+		fitness = [&](NeuralNetwork& copy){ return -copy.loss(in,out); };
+		EpochStats stats;
+		stats.samples = in.size();
+		stats.loss = -step();
+		fitness = nullptr;
+		return stats;
+	}
+
+} /* namespace vio */
@@ -0,0 +1,82 @@
+/*
+ * EvolutionStrategy.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include "utils/ThreadPool.h"
+#include "NeuralNetwork.h"
+
+namespace vio {
+
+	/**
+	Training without gradients: evolution strategies (see https://arxiv.org/abs/1703.03864).
+
+	Every generation, population copies of the network are created by adding noise to every parameter
+	(the ParameterBlocks of every layer), in pairs: +noise and -noise. The copies are scored with the fitness function
+	and the weights move towards the noise of the copies that did well.
+
+	The noise of a copy is entirely defined by a seed: noise[i] = sigma * (the i-th gaussian of RandomStream(seed)). Nothing but the
+	(seed,fitness) pairs are needed to compute the update, the noise is recomputed from the seeds.
+	The copies are scored in parallel, every thread has its own copy of the network.
+
+	The fitness function can be anything, it does not need to be differentiable. Higher is better.
+	train() uses the opposite of the loss of the network on a dataset.
+
+	@code
+	EvolutionStrategy es(nn);
+	es.fitness = [](NeuralNetwork& n){ return playGame(n); };
+	for(u32 i = 0;i < 1000;i++){
+		float meanFitness = es.step();
+	}
+	@endcode
+	 */
+	class EvolutionStrategy{
+	public:
+		struct Sample{
+			u32 seed;
+			float fitness; // of the +noise copy
+			float mirroredFitness; // of the -noise copy
+		};
+	private:
+		NeuralNetwork& nn;
+		ThreadPool pool;
+		std::vector<NeuralNetwork*> copies; // one per thread of the pool
+		std::vector<ParameterBlock> blocks; // parameters of nn
+		uint64_t parameterCount = 0;
+		u32 generation = 0;
+
+		void collectBlocks();
+		void prepareCopies();
+	public:
+		// threadCount: the copies are scored by that many threads, every core by default (1 if it cannot be known).
+		EvolutionStrategy(NeuralNetwork& nn,u32 threadCount = std::thread::hardware_concurrency());
+		EvolutionStrategy(EvolutionStrategy& e) = delete;
+		EvolutionStrategy& operator=(const EvolutionStrategy& e) = delete;
+		~EvolutionStrategy();
+
+		u32 population = 64; // copies scored per generation, rounded up to an even number.
+		float sigma = 0.02; // deviation of the noise
+		float learningRate = 0.01;
+		u32 seed = 1; // the seeds of the copies depend on it and on the generation.
+
+		// Called with a noisy copy of the network, from several threads at the same time.
+		std::function<float(NeuralNetwork& copy)> fitness;
+		// The (seed,fitness) pairs of the last generation, update() on another copy of the network replays it.
+		std::vector<Sample> lastSamples;
+
+		// Scores a new generation and updates the network, returns the mean fitness of the generation.
+		float step();
+		// Moves the weights of nn using only the (seed,fitness) pairs of a generation.
+		void update(const std::vector<Sample>& samples);
+		// One generation with fitness = -loss over in / out. The loss returned is the mean over the noisy copies.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out);
+	};
+
+} /* namespace vio */
@@ -0,0 +1,168 @@
+/*
+ * GradientCompressor.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "GradientCompressor.h"
+
+namespace vio {
+
+	template<typename T>
+	static void append(std::vector<char>& out,const T * values,size_t count){
+		size_t position = out.size();
+		out.resize(position + count * sizeof(T));
+		memcpy(out.data() + position,values,count * sizeof(T));
+	}
+
+	GradientCompressor::~GradientCompressor(){
+
+	}
+
+	void GradientCompressor::compress(u32 bucket,float * data,u32 count,std::vector<char>& out){
+		if(!errorFeedback){
+			encode(data,count,out);
+			return;
+		}
+		if(residuals.size() <= bucket) residuals.resize(bucket + 1);
+		std::vector<float>& residual = residuals[bucket];
+		if(residual.size() != count) residual.assign(count,0);
+
+		for(u32 i = 0;i < count;i++){
+			data[i] += residual[i];
+		}
+		const size_t start = out.size();
+		encode(data,count,out);
+		// residual = data - decompress(compress(data))
+		std::fill(residual.begin(),residual.end(),0);
+		decompressAdd(out.data() + start,count,residual.data());
+		for(u32 i = 0;i < count;i++){
+			residual[i] = data[i] - residual[i];
+		}
+	}
+
+	bool GradientCompressor::compresses(u32 count,u32 workers){
+		// per worker, (n-1) payloads with their size against 2 (n-1) / n buckets of floats.
+		return (compressedSize(count) + sizeof(u32)) * workers < 2 * (size_t)count * sizeof(float);
+	}
+
+	TopKCompressor::TopKCompressor(float ratio){
+		this->ratio = ratio;
+	}
+	u32 TopKCompressor::kept(u32 count){
+		u32 k = (u32)(count * ratio);
+		if(k == 0) k = 1;
+		return k > count ? count : k;
+	}
+	size_t TopKCompressor::compressedSize(u32 count){
+		// at most: zeros are not sent.
+		return sizeof(u32) + kept(count) * (sizeof(u32) + sizeof(float));
+	}
+	void TopKCompressor::encode(const float * data,u32 count,std::vector<char>& out){
+		const u32 k = kept(count);
+
+		// threshold = k-th largest magnitude, found in linear time.
+		magnitudes.resize(count);
+		for(u32 i = 0;i < count;i++){
+			magnitudes[i] = std::abs(data[i]);
+		}
+		float threshold = 0;
+		if(count > 0){
+			std::nth_element(magnitudes.begin(),magnitudes.begin() + (count - k),magnitudes.end());
+			threshold = magnitudes[count - k];
+		}
+
+		indices.clear();
+		values.clear();
+		for(u32 i = 0;i < count && indices.size() < k;i++){
+			if(std::abs(data[i]) >= threshold && data[i] != 0){
+				indices.push_back(i);
+				values.push_back(data[i]);
+			}
+		}
+		u32 sent = indices.size();
+		append(out,&sent,1);
+		append(out,indices.data(),sent);
+		append(out,values.data(),sent);
+	}
+	size_t TopKCompressor::decompressAdd(const char * in,u32 count,float * data){
+		u32 sent;
+		memcpy(&sent,in,sizeof(u32));
+		const char * indices = in + sizeof(u32);
+		const char * values = indices + sent * sizeof(u32);
+		for(u32 i = 0;i < sent;i++){
+			u32 index;
+			float value;
+			memcpy(&index,indices + i * sizeof(u32),sizeof(u32));
+			memcpy(&value,values + i * sizeof(float),sizeof(float));
+			if(index < count) data[index] += value;
+		}
+		return sizeof(u32) + sent * (sizeof(u32) + sizeof(float));
+	}
+
+	void Int8Compressor::encode(const float * data,u32 count,std::vector<char>& out){
+		float largest = 0;
+		for(u32 i = 0;i < count;i++){
+			largest = std::max(largest,std::abs(data[i]));
+		}
+		const float scale = largest / 127;
+		const float inverse = scale == 0 ? 0 : 1 / scale;
+		append(out,&scale,1);
+		size_t position = out.size();
+		out.resize(position + count);
+		signed char * q = (signed char*)out.data() + position;
+		for(u32 i = 0;i < count;i++){
+			long v = std::lrint(data[i] * inverse);
+			q[i] = (signed char)(v > 127 ? 127 : (v < -127 ? -127 : v));
+		}
+	}
+	size_t Int8Compressor::decompressAdd(const char * in,u32 count,float * data){
+		float scale;
+		memcpy(&scale,in,sizeof(float));
+		const signed char * q = (const signed char*)in + sizeof(float);
+		for(u32 i = 0;i < count;i++){
+			data[i] += q[i] * scale;
+		}
+		return sizeof(float) + count;
+	}
+	size_t Int8Compressor::compressedSize(u32 count){
+		return sizeof(float) + count;
+	}
+
+	void SignCompressor::encode(const float * data,u32 count,std::vector<char>& out){
+		double sum = 0;
+		for(u32 i = 0;i < count;i++){
+			sum += std::abs(data[i]);
+		}
+		const float scale = count == 0 ? 0 : sum / count;
+		append(out,&scale,1);
+		size_t position = out.size();
+		out.resize(position + (count + 7) / 8);
+		unsigned char * bits = (unsigned char*)out.data() + position;
+		for(u32 i = 0;i < count;i += 8){
+			unsigned char byte = 0;
+			for(u32 b = 0;b < 8 && i + b < count;b++){
+				byte |= (data[i + b] < 0) << b; // 1 = negative
+			}
+			bits[i / 8] = byte;
+		}
+	}
+	size_t SignCompressor::decompressAdd(const char * in,u32 count,float * data){
+		float scale;
+		memcpy(&scale,in,sizeof(float));
+		const unsigned char * bits = (const unsigned char*)in + sizeof(float);
+		const float values[2] = {scale,-scale};
+		for(u32 i = 0;i < count;i++){
+			data[i] += values[(bits[i / 8] >> (i % 8)) & 1];
+		}
+		return sizeof(float) + (count + 7) / 8;
+	}
+	size_t SignCompressor::compressedSize(u32 count){
+		return sizeof(float) + (count + 7) / 8;
+	}
+
+} /* namespace vio */
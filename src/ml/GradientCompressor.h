@@ -0,0 +1,92 @@
+/*
+ * GradientCompressor.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include "utils/utils.h"
+
+namespace vio {
+
+	/**
+	Lossy compression of the gradients exchanged by DistributedTrainer.
+
+	With a compressor, every worker compresses its part of a bucket, the compressed buckets are passed around the ring
+	and every worker decompresses and sums all of them in the same order, so the workers still do the same update.
+
+	With errorFeedback (on by default), what the compression lost is remembered and added to the gradient of the next step,
+	so nothing is lost in the long run, it is only delayed. This is what makes aggressive compression (top 1%, 1 bit) converge.
+
+	A compressor has state (the errors of the previous step), every worker needs its own.
+
+	Every worker sends the n-1 compressed buckets of the others, while the ring all-reduce of the floats sends
+	about 2 buckets whatever n, so compression only pays when it divides the size by more than n / 2:
+	for 8 bits, not beyond 8 workers. DistributedTrainer asks compresses and sends the bucket uncompressed otherwise.
+	The time spent compressing is measured by the "compress" rows of the training bench.
+
+	@code
+	DistributedTrainer dt(nn,rank,workers);
+	TopKCompressor topk(0.01); // only send the 1% largest values
+	dt.compressor = &topk;
+	@endcode
+	 */
+	class GradientCompressor{
+	private:
+		std::vector<std::vector<float>> residuals; // error feedback, per bucket
+	protected:
+		// appends the compressed form of data[0,count) to out.
+		virtual void encode(const float * data,u32 count,std::vector<char>& out) = 0;
+	public:
+		bool errorFeedback = true;
+
+		virtual ~GradientCompressor();
+
+		// Appends the compressed form of data[0,count) to out. bucket identifies the part of the gradient, for error feedback.
+		// data is modified (the error of the previous step is added to it).
+		void compress(u32 bucket,float * data,u32 count,std::vector<char>& out);
+		// Adds the values of a compressed block of count values to data. Returns the number of bytes read from in.
+		virtual size_t decompressAdd(const char * in,u32 count,float * data) = 0;
+		// Upper bound of the bytes appended by compress for count values, the same on every worker.
+		virtual size_t compressedSize(u32 count) = 0;
+		// True when the all-gather of the compressed buckets of workers workers sends less than the all-reduce of count floats.
+		bool compresses(u32 count,u32 workers);
+	};
+
+	// Sends the k = ratio * count values with the largest magnitude, as (index,value) pairs.
+	class TopKCompressor : public GradientCompressor{
+	private:
+		std::vector<float> magnitudes;
+		std::vector<u32> indices;
+		std::vector<float> values;
+		u32 kept(u32 count);
+		void encode(const float * data,u32 count,std::vector<char>& out);
+	public:
+		float ratio;
+		TopKCompressor(float ratio = 0.01);
+		size_t decompressAdd(const char * in,u32 count,float * data);
+		size_t compressedSize(u32 count);
+	};
+
+	// 8 bits per value: value = q * scale with q in [-127,127] and one scale per bucket.
+	class Int8Compressor : public GradientCompressor{
+	private:
+		void encode(const float * data,u32 count,std::vector<char>& out);
+	public:
+		size_t decompressAdd(const char * in,u32 count,float * data);
+		size_t compressedSize(u32 count);
+	};
+
+	// 1 bit per value: value = +scale or -scale, scale = mean of the magnitudes of the bucket (signSGD).
+	class SignCompressor : public GradientCompressor{
+	private:
+		void encode(const float * data,u32 count,std::vector<char>& out);
+	public:
+		size_t decompressAdd(const char * in,u32 count,float * data);
+		size_t compressedSize(u32 count);
+	};
+
+} /* namespace vio */
@@ -0,0 +1,343 @@
+/*
+ * GraphNetwork.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "GraphNetwork.h"
+
+#include <cstring>
+
+#include "utils/ThreadPool.h" // before math.h and its max macro
+#include "math/math.h"
+
+namespace vio {
+
+	// Samples per task of the thread pool when evaluating the loss.
+	static constexpr u32 LOSS_GRAIN = 16;
+
+	GraphNetwork::GraphNetwork(){
+
+	}
+	GraphNetwork::~GraphNetwork(){
+		delete pool;
+	}
+
+	bool GraphNetwork::existing(const std::vector<u32>& ids) const{
+		for(u32 i : ids){
+			if(i >= nodes.size()) return false;
+		}
+		return true;
+	}
+	bool GraphNetwork::sameSize(const std::vector<u32>& ids) const{
+		for(u32 i : ids){
+			if(nodes[i].size != nodes[ids[0]].size) return false;
+		}
+		return true;
+	}
+	bool GraphNetwork::hasNode(NodeType type) const{
+		for(const Node& n : nodes){
+			if(n.type == type) return true;
+		}
+		return false;
+	}
+	bool GraphNetwork::usesLayer(const Layer * l) const{
+		for(const Node& n : nodes){
+			if(n.layer == l) return true;
+		}
+		return false;
+	}
+
+	u32 GraphNetwork::addNode(NodeType type,Layer * layer,const std::vector<u32>& inputs,u32 size,u32 begin){
+		vassert(existing(inputs));
+		isReady = false;
+		nodes.push_back({type,layer,inputs,size,begin});
+		return nodes.size() - 1;
+	}
+
+	u32 GraphNetwork::input(u32 size){
+		vassert(!hasNode(NODE_INPUT)); // only one input
+		inputNode = nodes.size();
+		return addNode(NODE_INPUT,0,{},size,0);
+	}
+	u32 GraphNetwork::layer(Layer * l,u32 in){
+		vassert(!usesLayer(l)); // the weights would be updated twice per sample
+		return addNode(NODE_LAYER,l,{in},l->outputSize(),0);
+	}
+	u32 GraphNetwork::split(u32 in,u32 begin,u32 size){
+		vassert(in < nodes.size() && begin + size <= nodes[in].size);
+		return addNode(NODE_SPLIT,0,{in},size,begin);
+	}
+	u32 GraphNetwork::concat(const std::vector<u32>& in){
+		u32 size = 0;
+		for(u32 i : in){
+			vassert(i < nodes.size());
+			size += nodes[i].size;
+		}
+		return addNode(NODE_CONCAT,0,in,size,0);
+	}
+	u32 GraphNetwork::add(const std::vector<u32>& in){
+		vassert(in.size() > 0 && existing(in) && sameSize(in));
+		return addNode(NODE_ADD,0,in,nodes[in[0]].size,0);
+	}
+
+	u32 GraphNetwork::nodeCount(){
+		return nodes.size();
+	}
+	GraphNetwork::NodeType GraphNetwork::nodeType(u32 node){
+		return nodes[node].type;
+	}
+	u32 GraphNetwork::nodeSize(u32 node){
+		return nodes[node].size;
+	}
+	u32 GraphNetwork::depth(){
+		return levels.size();
+	}
+
+	void GraphNetwork::prepare(){
+		if(nodes.size() == 0 || nodes[inputNode].type != NODE_INPUT){
+			vpanic("The graph has no input node!");
+		}
+		for(u32 i = 0;i < nodes.size();i++){
+			const Node& n = nodes[i];
+			if(n.type == NODE_LAYER && n.layer->inputSize() != nodes[n.inputs[0]].size){
+				vpanic("Node %i is misshaped, its layer has inputSize %i but its input has size %i !",
+					i,n.layer->inputSize(),nodes[n.inputs[0]].size);
+			}
+		}
+
+		// The inputs of a node are always created before it, so the ids are already a topological order.
+		// depth = length of the longest path from the input, the nodes of the same depth are independent.
+		std::vector<u32> depthOf(nodes.size(),0);
+		uses.assign(nodes.size(),{});
+		reachesLearnable.assign(nodes.size(),false);
+		levels.clear();
+		for(u32 i = 0;i < nodes.size();i++){
+			const Node& n = nodes[i];
+			if(n.type == NODE_INPUT){
+				depthOf[i] = 0;
+			}else if(n.inputs.size() == 0){
+				vpanic("Node %i has no input!",i);
+			}else{
+				for(u32 j = 0;j < n.inputs.size();j++){
+					depthOf[i] = max(depthOf[i],depthOf[n.inputs[j]] + 1);
+					uses[n.inputs[j]].push_back({i,j});
+					if(reachesLearnable[n.inputs[j]]) reachesLearnable[i] = true;
+				}
+			}
+			if(n.type == NODE_LAYER && n.layer->isLearnable()) reachesLearnable[i] = true;
+			if(depthOf[i] >= levels.size()) levels.resize(depthOf[i] + 1);
+			levels[depthOf[i]].push_back(i);
+		}
+
+		if(pool == 0 || pool->size() != computationCoreCount){
+			delete pool;
+			pool = new ThreadPool(computationCoreCount);
+		}
+		isReady = true;
+	}
+
+	void GraphNetwork::forEachNode(const std::vector<u32>& level,const std::function<void(u32 node)>& fn){
+		if(level.size() == 1){
+			fn(level[0]); // the layer can use the threads of the pool itself (see DenseLayer::shard)
+			return;
+		}
+		pool->parallelFor(level.size(),1,[&](u32 begin,u32 end,u32 worker){
+			for(u32 i = begin;i < end;i++){
+				fn(level[i]);
+			}
+		});
+	}
+
+	Vector GraphNetwork::nodeValue(u32 node,const std::vector<Vector>& values){
+		const Node& n = nodes[node];
+		switch(n.type){
+		case NODE_LAYER:
+			return n.layer->apply(values[n.inputs[0]]);
+		case NODE_SPLIT:{
+			Vector r(n.size);
+			std::memcpy(r.raw(),values[n.inputs[0]].raw() + n.begin,n.size * sizeof(float));
+			return r;
+		}
+		case NODE_CONCAT:{
+			Vector r(n.size);
+			u32 offset = 0;
+			for(u32 i : n.inputs){
+				std::memcpy(r.raw() + offset,values[i].raw(),values[i].size() * sizeof(float));
+				offset += values[i].size();
+			}
+			return r;
+		}
+		case NODE_ADD:{
+			Vector r(values[n.inputs[0]]);
+			for(u32 j = 1;j < n.inputs.size();j++){
+				r += values[n.inputs[j]];
+			}
+			return r;
+		}
+		default:
+			vpanic("Unknown node type %i",n.type);
+			return Vector(0);
+		}
+	}
+
+	void GraphNetwork::forward(const Vector& in,std::vector<Vector>& values){
+		vassert(in.size() == nodes[inputNode].size);
+		values.assign(nodes.size(),Vector(0));
+		values[inputNode] = in;
+		for(u32 d = 1;d < levels.size();d++){
+			forEachNode(levels[d],[&](u32 node){
+				values[node] = nodeValue(node,values);
+			});
+		}
+	}
+
+	void GraphNetwork::nodeGradient(u32 node,const Vector& gradient,const std::vector<Vector>& values,std::vector<Vector>& inputGradients,float learningRate){
+		const Node& n = nodes[node];
+		inputGradients.assign(n.inputs.size(),Vector(0));
+		switch(n.type){
+		case NODE_LAYER:{
+			const u32 p = n.inputs[0];
+			// propagate before the update, with the weights used for the forward pass.
+			if(reachesLearnable[p]){
+				const Node& previous = nodes[p];
+				const Vector empty(0);
+				inputGradients[0] = n.layer->applyGradient(gradient,values[p],previous.inputs.size() > 0 ? values[previous.inputs[0]] : empty);
+			}
+			if(n.layer->isLearnable()){
+				Matrix totalGradient = Vector::crossNorm(gradient,values[p]);
+				totalGradient *= learningRate;
+				n.layer->updateMatrix(totalGradient);
+				if(n.layer->isBias()){
+					Vector b(gradient);
+					b *= learningRate;
+					n.layer->updateBias(b);
+				}
+			}
+			break;
+		}
+		case NODE_SPLIT:{
+			if(!reachesLearnable[n.inputs[0]]) break;
+			Vector g(nodes[n.inputs[0]].size);
+			g.fill(0);
+			std::memcpy(g.raw() + n.begin,gradient.raw(),n.size * sizeof(float));
+			inputGradients[0] = std::move(g);
+			break;
+		}
+		case NODE_CONCAT:{
+			u32 offset = 0;
+			for(u32 j = 0;j < n.inputs.size();j++){
+				const u32 s = nodes[n.inputs[j]].size;
+				if(reachesLearnable[n.inputs[j]]){
+					Vector g(s);
+					std::memcpy(g.raw(),gradient.raw() + offset,s * sizeof(float));
+					inputGradients[j] = std::move(g);
+				}
+				offset += s;
+			}
+			break;
+		}
+		case NODE_ADD:
+			for(u32 j = 0;j < n.inputs.size();j++){
+				if(reachesLearnable[n.inputs[j]]) inputGradients[j] = gradient;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	Vector GraphNetwork::apply(const Vector& in){
+		if(!isReady) prepare();
+		std::vector<Vector> values;
+		forward(in,values);
+		return values.back();
+	}
+
+	float GraphNetwork::loss(std::vector<Vector>& in,std::vector<Vector>& out){
+		vassert(in.size() == out.size());
+		if(in.size() == 0) return 0;
+		if(!isReady) prepare();
+		if(lossValues.size() < in.size()) lossValues.resize(in.size());
+		float * lv = lossValues.data();
+		// one sample per task, the levels of every sample run serially (nested parallelFor).
+		pool->parallelFor(in.size(),LOSS_GRAIN,[&](u32 begin,u32 end,u32 worker){
+			std::vector<Vector> values;
+			for(u32 i = begin;i < end;i++){
+				forward(in[i],values);
+				lv[i] = this->errorFunction(values.back(),out[i]);
+			}
+		});
+		return pairwiseSum(lv,in.size()) / in.size();
+	}
+
+	EpochStats GraphNetwork::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		if(!isReady){
+			vpanic("The graph network is not ready! Call prepare() first!");
+		}
+		vassert(in.size() == out.size());
+
+		EpochStats stats;
+		stats.samples = in.size();
+		if(in.size() == 0) return stats;
+		if(lossValues.size() < in.size()) lossValues.resize(in.size());
+		u32 correct = 0;
+
+		// same shuffle as NeuralNetwork::train
+		std::vector<u32> permutation = NeuralNetwork::shuffledIndices(in.size());
+
+		const u32 output = nodes.size() - 1;
+		std::vector<Vector> values;
+		// inputGradients[i][j] = gradient with respect to the j-th input of node i, written by node i and read by that input.
+		std::vector<std::vector<Vector>> inputGradients(nodes.size());
+
+		for(u32 train_index = 0;train_index < in.size();train_index++){
+			const u32 real_index = permutation[train_index];
+			forward(in[real_index],values);
+
+			lossValues[train_index] = this->errorFunction(values[output],out[real_index]);
+			if(computeAccuracy && NeuralNetwork::argmax(values[output]) == NeuralNetwork::argmax(out[real_index])){
+				correct++;
+			}
+
+			const Vector outputGradient = this->errorFunctionGradient(values[output],out[real_index]);
+			if(outputGradient.normSquared() == 0.00) continue;
+			for(std::vector<Vector>& g : inputGradients){
+				g.clear();
+			}
+
+			// Every user of a node has a larger depth, so its gradient is complete when the level of the node is reached.
+			for(u32 d = levels.size() - 1;d >= 1;d--){
+				forEachNode(levels[d],[&](u32 node){
+					if(node == output){
+						nodeGradient(node,outputGradient,values,inputGradients[node],learningRate);
+						return;
+					}
+					if(!reachesLearnable[node]) return;
+					// sum the gradients of the users, in a fixed order so the result does not depend on the threads.
+					Vector gradient(0);
+					for(const Use& u : uses[node]){
+						if(inputGradients[u.node].size() == 0) continue; // the user was not reached by the gradient
+						const Vector& g = inputGradients[u.node][u.slot];
+						if(g.size() == 0) continue;
+						if(gradient.size() == 0){
+							gradient = g;
+						}else{
+							gradient += g;
+						}
+					}
+					if(gradient.size() == 0) return; // not used by the output
+					nodeGradient(node,gradient,values,inputGradients[node],learningRate);
+				});
+			}
+		}
+
+		stats.loss = pairwiseSum(lossValues.data(),in.size()) / in.size();
+		if(computeAccuracy){
+			stats.accuracy = (float)correct / in.size();
+		}
+		return stats;
+	}
+
+} /* namespace vio */
@@ -0,0 +1,121 @@
+/*
+ * GraphNetwork.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "NeuralNetwork.h"
+
+namespace vio {
+
+	class ThreadPool;
+
+	/**
+	A network where the layers form a directed acyclic graph instead of a list ("layer branches").
+
+	Every call that adds something returns the id of a node, the ids are used as the inputs of the next nodes.
+	A node can be used as the input of several nodes, the gradients coming from all of them are summed.
+	- input: the vector given to apply / train. There is exactly one.
+	- layer: a Layer applied to a node. A layer can only appear once in the graph, the graph does not own it.
+	- split: a slice [begin,begin+size) of a node, to send different parts of a vector to different branches.
+	- concat: the concatenation of several nodes, in order.
+	- add: the element wise sum of several nodes of the same size (for residual connections).
+	The last node added is the output of the network.
+
+	prepare() sorts the nodes by depth: the nodes of the same depth do not depend on each other, so they are evaluated
+	at the same time on computationCoreCount threads, in the forward and in the backward pass.
+	The result does not depend on the number of threads.
+	A graph that is a simple chain of layers trains exactly like a NeuralNetwork with the same layers.
+
+	@code
+	GraphNetwork g;
+	u32 in = g.input(64);
+	u32 left = g.layer(&denseA,g.split(in,0,32)); // 32 -> 16
+	u32 right = g.layer(&denseB,g.split(in,32,32)); // 32 -> 16
+	g.layer(&denseC,g.concat({left,right})); // 32 -> 10, output
+	g.prepare();
+	EpochStats stats = g.train(trainingInputs,trainingOutputs,0.01);
+	@endcode
+	 */
+	class GraphNetwork{
+	public:
+		enum NodeType{
+			NODE_INPUT,
+			NODE_LAYER,
+			NODE_SPLIT,
+			NODE_CONCAT,
+			NODE_ADD
+		};
+	private:
+		struct Node{
+			NodeType type;
+			Layer * layer; // NODE_LAYER only
+			std::vector<u32> inputs;
+			u32 size; // size of the value of the node
+			u32 begin; // NODE_SPLIT only, first element of the slice
+		};
+		struct Use{
+			u32 node; // the node using the value
+			u32 slot; // index in node.inputs
+		};
+
+		std::vector<Node> nodes;
+		std::vector<std::vector<Use>> uses; // uses[i] = where the value of node i goes
+		std::vector<std::vector<u32>> levels; // levels[d] = nodes of depth d, levels[0] is the input
+		std::vector<bool> reachesLearnable; // a learnable layer is this node or before it, so the gradient has to go there.
+		u32 inputNode = 0;
+		bool isReady = false;
+
+		ThreadPool * pool = 0; // computationCoreCount threads, created by prepare.
+		std::vector<float> lossValues;
+
+		u32 addNode(NodeType type,Layer * layer,const std::vector<u32>& inputs,u32 size,u32 begin);
+		// checks of the functions building the graph.
+		bool existing(const std::vector<u32>& ids) const; // every id is a node
+		bool sameSize(const std::vector<u32>& ids) const;
+		bool hasNode(NodeType type) const;
+		bool usesLayer(const Layer * l) const;
+		// Runs fn on every node of the level, in parallel.
+		void forEachNode(const std::vector<u32>& level,const std::function<void(u32 node)>& fn);
+		void forward(const Vector& in,std::vector<Vector>& values);
+		Vector nodeValue(u32 node,const std::vector<Vector>& values);
+		// Gradient of the loss with respect to every input of the node, given the one with respect to its value.
+		void nodeGradient(u32 node,const Vector& gradient,const std::vector<Vector>& values,std::vector<Vector>& inputGradients,float learningRate);
+	public:
+		GraphNetwork();
+		GraphNetwork(GraphNetwork& g) = delete;
+		GraphNetwork& operator=(const GraphNetwork& g) = delete;
+		~GraphNetwork();
+
+		u32 input(u32 size);
+		u32 layer(Layer * l,u32 in);
+		u32 split(u32 in,u32 begin,u32 size);
+		u32 concat(const std::vector<u32>& in);
+		u32 add(const std::vector<u32>& in);
+
+		u32 nodeCount();
+		NodeType nodeType(u32 node);
+		u32 nodeSize(u32 node);
+		u32 depth(); // number of levels, the length of the longest path from the input to the output + 1.
+
+		u32 computationCoreCount = 4;
+		bool computeAccuracy = false; // for classifiers, see EpochStats
+
+		// Same meaning as in NeuralNetwork.
+		float (*errorFunction)(const Vector& input,const Vector& expected) = L2errorFn;
+		Vector (*errorFunctionGradient)(const Vector& input,const Vector& expected) = L2errorDerivativeFn;
+
+		void prepare(); // checks the shapes and orders the nodes. Call it again after adding nodes or changing computationCoreCount.
+
+		Vector apply(const Vector& in);
+		// Per sample gradient descent over a shuffled dataset, like NeuralNetwork::train.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate = 0.01);
+		float loss(std::vector<Vector>& in,std::vector<Vector>& out);
+	};
+
+} /* namespace vio */
@@ -1,37 +1,74 @@
-/*
- * Layera.cpp
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#include "Layer.h"
-
-namespace vio {
-
-// Layer implementation
-Layer::Layer(u32 inputSize,u32 outputSize){
-	this->inS = inputSize;
-	this->outS = outputSize;
-}
-Layer::~Layer(){}
-
-bool Layer::isLearnable(){
-	return learnable;
-}
-bool Layer::isBias(){
-	return bias;
-}
-void Layer::updateMatrix(const Matrix& m){}
-void Layer::updateBias(const Vector& v){}
-u32 Layer::inputSize(){
-	return inS;
-}
-u32 Layer::outputSize(){
-	return outS;
-}
-void Layer::print(){
-	debug("Layer %i x %i (unknown type)",this->inS,this->outS);
-}
-
-} /* namespace vio */
+/*
+ * Layera.cpp
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#include "Layer.h"
+
+namespace vio {
+
+// Layer implementation
+Layer::Layer(u32 inputSize,u32 outputSize){
+	this->inS = inputSize;
+	this->outS = outputSize;
+}
+Layer::~Layer(){}
+
+bool Layer::isLearnable(){
+	return learnable;
+}
+bool Layer::isBias(){
+	return bias;
+}
+void Layer::applyInto(const Vector& in,Vector& out){
+	Vector r = apply(in);
+	vassert(r.size() == out.size());
+	for(u32 i = 0;i < r.size();i++){
+		out.at(i) = r.get(i);
+	}
+}
+void Layer::applyGradientInto(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition,Vector& out){
+	Vector r = applyGradient(in,evaluationPosition,previousEvaluationPosition);
+	vassert(r.size() == out.size());
+	for(u32 i = 0;i < r.size();i++){
+		out.at(i) = r.get(i);
+	}
+}
+void Layer::updateMatrix(const Matrix& m){}
+void Layer::updateBias(const Vector& v){}
+double Layer::applyFlops(){
+	return 0;
+}
+double Layer::gradientFlops(){
+	return 0;
+}
+double Layer::updateFlops(){
+	if(!learnable) return 0;
+	return 3.0 * inS * outS + (bias ? 2.0 * outS : 0);
+}
+u32 Layer::inputSize(){
+	return inS;
+}
+u32 Layer::outputSize(){
+	return outS;
+}
+LayerDescriptor Layer::describe(){
+	LayerDescriptor d;
+	d.type = LAYER_UNKNOWN;
+	d.inputSize = inS;
+	d.outputSize = outS;
+	return d;
+}
+std::vector<ParameterBlock> Layer::parameters(){
+	return std::vector<ParameterBlock>();
+}
+void Layer::bindParameters(const std::vector<float*>& blocks){
+	vassert(blocks.size() == 0);
+}
+void Layer::print(){
+	debug("Layer %i x %i (unknown type)",this->inS,this->outS);
+}
+
+} /* namespace vio */
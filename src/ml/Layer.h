@@ -1,76 +1,124 @@
-/*
- * Layer.h
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#pragma once
-
-#include "math/vector.h"
-#include "utils/utils.h"
-
-namespace vio {
-
-/**
-Layer is an abstract class (interface) representing a Layer of a neural network.
-
-Implementations of Layer include:
-	- DenseLayer for "classic" layers performing a linear transformation and applying an activation function
-	- ConvLayer for convolutions
-	- BatchNormLayer for normalizations
-	- SoftMaxLayer for applying softmax
-	- etc ...
-
-You can implement your own layer, you just need to implement the following methods:
-@code
-
-YourLayer(); // constructor that sets inputSize, outputSize, learnable and bias
-void print(); // used for debug, display your layer to stdout
-Vector apply(const Vector& in); // evaluates the layer
-Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition); // gradient computation
-
-void updateMatrix(const Matrix& m); // update the weights, not needed if learable = false, in this case, vassert(false) in this.
-void updateBias(const Vector& v); // update the bias, not needed if bias = false, in this case, vassert(false) in this.
-
-@endcode
- */
-
-class Layer{
-	protected:
-		u32 inS;
-		u32 outS;
-
-		// set to false to set the weights
-		// useful for finetuning.
-		bool learnable = false;
-		bool bias = false;
-	public:
-		Layer() = delete;
-		Layer(u32 inputSize,u32 outputSize);
-		virtual ~Layer();
-
-		bool isLearnable();
-		bool isBias();
-
-		u32 inputSize();
-		u32 outputSize();
-
-		virtual void print(); // for debug
-
-		// virtual std::string serialize();
-
-		virtual Vector apply(const Vector& in) = 0;
-
-		// same as apply but in the other direction.
-		// used for backprop, usually implemented with m.applyTranspose
-		// This is the gradient of the network at a given position.
-		virtual Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition) = 0;
-
-		// usually does this->m -= m.
-		// not always thou (for example, in conv layers, this is not the case.)
-		virtual void updateMatrix(const Matrix& m);
-		virtual void updateBias(const Vector& v);
-	};
-
-}
+/*
+ * Layer.h
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include "math/vector.h"
+#include "utils/utils.h"
+#include <vector>
+
+namespace vio {
+
+// Identifiers of the layer types, stored in model files. Never reuse a value.
+enum LayerType : u32{
+	LAYER_UNKNOWN = 0,
+	LAYER_DENSE = 1,
+	LAYER_CONV = 2,
+	LAYER_BATCHNORM = 3,
+	LAYER_SOFTMAX = 4
+};
+
+// Everything needed to rebuild a layer, except its weights.
+// The meaning of args depends on the type (activation function for dense layers, kernel size for convolutions, ...)
+struct LayerDescriptor{
+	u32 type = LAYER_UNKNOWN;
+	u32 inputSize = 0;
+	u32 outputSize = 0;
+	u32 args[5] = {0,0,0,0,0};
+};
+
+// A contiguous array of learnable floats of a layer (a weight matrix, a bias vector, a kernel ...)
+struct ParameterBlock{
+	float * data;
+	u32 size;
+};
+
+/**
+Layer is an abstract class (interface) representing a Layer of a neural network.
+
+Implementations of Layer include:
+	- DenseLayer for "classic" layers performing a linear transformation and applying an activation function
+	- ConvLayer for convolutions
+	- BatchNormLayer for normalizations
+	- SoftMaxLayer for applying softmax
+	- etc ...
+
+You can implement your own layer, you just need to implement the following methods:
+@code
+
+YourLayer(); // constructor that sets inputSize, outputSize, learnable and bias
+void print(); // used for debug, display your layer to stdout
+Vector apply(const Vector& in); // evaluates the layer
+void applyInto(const Vector& in,Vector& out); // optional, evaluates the layer without allocating
+Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition); // gradient computation
+void applyGradientInto(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition,Vector& out); // optional, same without allocating
+
+void updateMatrix(const Matrix& m); // update the weights, not needed if learable = false, in this case, vassert(false) in this.
+void updateBias(const Vector& v); // update the bias, not needed if bias = false, in this case, vassert(false) in this.
+
+@endcode
+
+To be saved with NeuralNetwork::serialize, a layer also needs to implement describe, parameters and bindParameters.
+ */
+
+class Layer{
+	protected:
+		u32 inS;
+		u32 outS;
+
+		// set to false to set the weights
+		// useful for finetuning.
+		bool learnable = false;
+		bool bias = false;
+	public:
+		Layer() = delete;
+		Layer(u32 inputSize,u32 outputSize);
+		virtual ~Layer();
+
+		bool isLearnable();
+		bool isBias();
+
+		u32 inputSize();
+		u32 outputSize();
+
+		virtual void print(); // for debug
+
+		// Serialization support. The default implementation describes a layer without weights of unknown type.
+		virtual LayerDescriptor describe();
+		// Blocks are always returned in the same order.
+		virtual std::vector<ParameterBlock> parameters();
+		// Make the parameters point to external memory (one pointer per block, in the order of parameters()), nothing is copied.
+		// The memory must outlive the layer. Used to load mapped models in place.
+		virtual void bindParameters(const std::vector<float*>& blocks);
+
+		virtual Vector apply(const Vector& in) = 0;
+		// same as apply, but writes to out (of size outputSize()) instead of allocating a new vector.
+		// Must not modify the layer, it is called from many threads at once.
+		// The default implementation calls apply and copies the result.
+		virtual void applyInto(const Vector& in,Vector& out);
+
+		// same as apply but in the other direction.
+		// used for backprop, usually implemented with m.applyTranspose
+		// This is the gradient of the network at a given position.
+		virtual Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition) = 0;
+		// same as applyGradient, but writes to out (of size inputSize()). Used by NeuralNetwork::train to keep the gradients in its arena.
+		// The default implementation calls applyGradient and copies the result.
+		virtual void applyGradientInto(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition,Vector& out);
+
+		// usually does this->m -= m.
+		// not always thou (for example, in conv layers, this is not the case.)
+		virtual void updateMatrix(const Matrix& m);
+		virtual void updateBias(const Vector& v);
+
+		// Rough number of floating point operations of one call, reported by the Profiler. 0 when unknown.
+		// The default update cost is the one of NeuralNetwork::train for a dense matrix: gradient, scaling and subtraction.
+		virtual double applyFlops();
+		virtual double gradientFlops();
+		virtual double updateFlops();
+	};
+
+}
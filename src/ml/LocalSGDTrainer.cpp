@@ -0,0 +1,205 @@
+/*
+ * LocalSGDTrainer.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <new>
+#include "LocalSGDTrainer.h"
+
+namespace vio {
+
+	static constexpr u32 SHARED_MAGIC = 0x44475356; // "VSGD"
+	static_assert(std::atomic<u32>::is_always_lock_free,"the barrier needs lock free atomics to work between processes");
+
+	// floats of a slot, rounded up to a cache line.
+	static uint64_t slotSize(uint64_t parameterCount){
+		return (parameterCount + 15) / 16 * 16;
+	}
+
+	LocalSGDTrainer::LocalSGDTrainer(NeuralNetwork& nn,const std::string& name,u32 rank,u32 processCount) : nn(nn){
+		vassert(rank < processCount);
+		this->name = name;
+		this->rank = rank;
+		this->processCount = processCount;
+	}
+	LocalSGDTrainer::~LocalSGDTrainer(){
+		delete memory;
+	}
+
+	LocalSGDTrainer::Header * LocalSGDTrainer::header(){
+		return (Header*)memory->data();
+	}
+	float * LocalSGDTrainer::slot(u32 process){
+		return (float*)(memory->data() + sizeof(Header)) + slotSize(parameterCount) * process;
+	}
+	float * LocalSGDTrainer::averaged(){
+		return slot(processCount);
+	}
+
+	void LocalSGDTrainer::collectBlocks(){
+		blocks.clear();
+		parameterCount = 0;
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				blocks.push_back(p);
+				parameterCount += p.size;
+			}
+		}
+	}
+	void LocalSGDTrainer::copyWeights(float * flat,bool fromNetwork){
+		for(ParameterBlock& p : blocks){
+			if(fromNetwork){
+				memcpy(flat,p.data,p.size * sizeof(float));
+			}else{
+				memcpy(p.data,flat,p.size * sizeof(float));
+			}
+			flat += p.size;
+		}
+	}
+
+	bool LocalSGDTrainer::isCurrentRun(uint64_t run){
+		SharedMemory probe(name,sizeof(Header),false);
+		if(!probe.isLoaded()) return true;
+		const Header * h = (const Header*)probe.data();
+		return h->ready.load(std::memory_order_acquire) != SHARED_MAGIC || h->run == run;
+	}
+
+	bool LocalSGDTrainer::open(){
+		collectBlocks();
+		const uint64_t size = sizeof(Header) + slotSize(parameterCount) * (processCount + 1) * sizeof(float);
+		const auto start = std::chrono::steady_clock::now();
+		auto timedOut = [&](){ return std::chrono::steady_clock::now() - start > std::chrono::milliseconds(openTimeout); };
+
+		if(rank == 0){
+			memory = new SharedMemory(name,size,true);
+			if(!memory->isLoaded()) return false;
+			Header * h = new (memory->data()) Header();
+			h->parameterCount = parameterCount;
+			h->processCount = processCount;
+			h->run = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+			h->arrived.store(0);
+			h->sense.store(0);
+			h->joined.store(0);
+			h->started.store(0);
+			copyWeights(averaged(),true);
+			h->ready.store(SHARED_MAGIC,std::memory_order_release);
+			while(h->joined.load(std::memory_order_acquire) < processCount - 1){
+				if(timedOut()) return false;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			h->started.store(1,std::memory_order_release);
+			return true;
+		}
+
+		while(true){
+			delete memory;
+			memory = 0;
+			if(timedOut()) return false;
+			memory = new SharedMemory(name,size,false);
+			if(!memory->isLoaded() || header()->ready.load(std::memory_order_acquire) != SHARED_MAGIC){
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+			Header * h = header();
+			const uint64_t run = h->run;
+			if(h->joined.fetch_add(1,std::memory_order_acq_rel) >= processCount - 1){
+				// every rank of that run already joined: a run that crashed after starting.
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+			// A run that crashed while starting never starts. Look at the name from time to time: once rank 0 created
+			// the memory of the new run, this one is stale.
+			u32 waited = 0;
+			while(h->started.load(std::memory_order_acquire) == 0 && !timedOut()){
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				if(++waited % 100 == 0 && !isCurrentRun(run)) break;
+			}
+			if(h->started.load(std::memory_order_acquire) == 0){
+				if(timedOut()) return false;
+				continue;
+			}
+			break;
+		}
+		if(header()->parameterCount != parameterCount || header()->processCount != processCount) return false; // not the same network
+		copyWeights(averaged(),false);
+		return true;
+	}
+
+	void LocalSGDTrainer::barrier(){
+		Header * h = header();
+		localSense ^= 1;
+		if(h->arrived.fetch_add(1,std::memory_order_acq_rel) + 1 == processCount){
+			// last one: reset the counter for the next barrier and release everybody.
+			h->arrived.store(0,std::memory_order_relaxed);
+			h->sense.store(localSense,std::memory_order_release);
+			return;
+		}
+		u32 spins = 0;
+		while(h->sense.load(std::memory_order_acquire) != localSense){
+			if(++spins > 1000) std::this_thread::yield(); // more processes than cores
+		}
+	}
+
+	void LocalSGDTrainer::average(){
+		vassert(memory != 0);
+		copyWeights(slot(rank),true);
+		barrier();
+		// every process averages its part, always in the same order.
+		const uint64_t begin = parameterCount * rank / processCount;
+		const uint64_t end = parameterCount * (rank + 1) / processCount;
+		float * result = averaged();
+		const float inverse = 1.0f / processCount;
+		for(uint64_t i = begin;i < end;i++){
+			float sum = 0;
+			for(u32 p = 0;p < processCount;p++){
+				sum += slot(p)[i];
+			}
+			result[i] = sum * inverse;
+		}
+		barrier();
+		copyWeights(result,false);
+	}
+
+	EpochStats LocalSGDTrainer::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		vassert(in.size() == out.size());
+		vassert(averagingInterval > 0);
+		EpochStats stats;
+		stats.samples = in.size();
+		double lossSum = 0;
+		double correct = 0;
+
+		// the whole shard is shuffled, so the chunks are different at every epoch.
+		std::vector<u32> permutation = NeuralNetwork::shuffledIndices(in.size());
+		std::vector<Vector> chunkIn;
+		std::vector<Vector> chunkOut;
+		for(u32 start = 0;start < in.size();start += averagingInterval){
+			const u32 count = in.size() - start < averagingInterval ? in.size() - start : averagingInterval;
+			// views over the samples, nothing is copied.
+			chunkIn.clear();
+			chunkOut.clear();
+			chunkIn.reserve(count);
+			chunkOut.reserve(count);
+			for(u32 i = start;i < start + count;i++){
+				const u32 index = permutation[i];
+				chunkIn.emplace_back(in[index].size(),in[index].raw());
+				chunkOut.emplace_back(out[index].size(),out[index].raw());
+			}
+			EpochStats s = nn.train(chunkIn,chunkOut,learningRate);
+			lossSum += (double)s.loss * count;
+			if(s.accuracy >= 0) correct += (double)s.accuracy * count;
+			average();
+		}
+
+		if(in.size() > 0) stats.loss = lossSum / in.size();
+		if(nn.computeAccuracy && in.size() > 0){
+			stats.accuracy = correct / in.size();
+		}
+		return stats;
+	}
+
+} /* namespace vio */
@@ -0,0 +1,87 @@
+/*
+ * LocalSGDTrainer.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include "NeuralNetwork.h"
+#include "file/SharedMemory.h"
+
+namespace vio {
+
+	/**
+	Training with several processes of the same machine (local SGD).
+
+	Every process trains its own copy of the network on its own part of the dataset with NeuralNetwork::train.
+	Every averagingInterval samples, the processes average their weights through a shared memory region:
+	every process writes its weights in its slot, averages 1/processCount of the parameters of every slot, and reads back the average.
+	The processes wait for each other with a sense reversing barrier made of two atomics in the shared memory,
+	no lock and no system call, so the communication runs at the speed of the memory.
+
+	Every process must have the same network, and the same number of samples (or at least the same number of averages per call to train).
+
+	@code
+	// in every process, rank = 0 .. 3
+	LocalSGDTrainer lt(nn,"vlearn_job",rank,4);
+	if(!lt.open()) vpanic("Unable to open the shared memory");
+	for(u32 i = 0;i < 100;i++){
+		lt.train(myInputs,myOutputs,0.01);
+	}
+	@endcode
+	 */
+	class LocalSGDTrainer{
+	private:
+		// Start of the shared memory. Every atomic has its own cache line.
+		struct Header{
+			alignas(64) uint64_t parameterCount;
+			u32 processCount;
+			uint64_t run; // chosen by rank 0, tells the memory of this run from the one left by a crashed run
+			alignas(64) std::atomic<u32> arrived; // processes that reached the barrier
+			alignas(64) std::atomic<u32> sense; // flipped by the last process to reach the barrier
+			alignas(64) std::atomic<u32> ready; // set by rank 0 once the memory is initialized
+			alignas(64) std::atomic<u32> joined; // other ranks that opened the memory
+			alignas(64) std::atomic<u32> started; // set by rank 0 once every rank joined
+		};
+
+		NeuralNetwork& nn;
+		std::string name;
+		u32 rank;
+		u32 processCount;
+		SharedMemory * memory = 0;
+		u32 localSense = 0;
+		uint64_t parameterCount = 0;
+		std::vector<ParameterBlock> blocks;
+
+		Header * header();
+		float * slot(u32 process); // weights written by a process
+		float * averaged(); // average of the slots
+		void collectBlocks();
+		void copyWeights(float * flat,bool fromNetwork);
+		void barrier();
+		bool isCurrentRun(uint64_t run); // false if the name now points to the memory of another run
+	public:
+		// name identifies the training job, it must be the same for every process.
+		LocalSGDTrainer(NeuralNetwork& nn,const std::string& name,u32 rank,u32 processCount);
+		LocalSGDTrainer(LocalSGDTrainer& l) = delete;
+		LocalSGDTrainer& operator=(const LocalSGDTrainer& l) = delete;
+		~LocalSGDTrainer();
+
+		u32 averagingInterval = 256; // samples trained by every process between two averages
+		u32 openTimeout = 30000; // in ms, time given to rank 0 to create the memory.
+
+		// Rank 0 creates the memory with its weights, the others wait for it and copy them. Returns false on timeout.
+		// The memory left by a crashed run with the same name is ignored: rank 0 only starts once every rank joined its run.
+		bool open();
+		// Sets the weights of every process to the average of their weights. Every process has to call it.
+		void average();
+		// One pass over in / out, the part of the dataset of this process. The stats are the ones of this process.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate = 0.01);
+	};
+
+} /* namespace vio */
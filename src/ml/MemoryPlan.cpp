@@ -0,0 +1,95 @@
+/*
+ * MemoryPlan.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "MemoryPlan.h"
+
+#include <algorithm>
+
+namespace vio {
+
+	u32 MemoryPlan::add(size_t size,u32 step){
+		buffers.push_back({size,step,step,0});
+		return buffers.size() - 1;
+	}
+	void MemoryPlan::extend(u32 buffer,u32 step){
+		vassert(buffer < buffers.size());
+		Buffer& b = buffers[buffer];
+		if(step < b.first) b.first = step;
+		if(step > b.last) b.last = step;
+	}
+	void MemoryPlan::clear(){
+		buffers.clear();
+		arenaSize = 0;
+	}
+
+	void MemoryPlan::solve(){
+		std::vector<u32> order(buffers.size());
+		for(u32 i = 0;i < order.size();i++) order[i] = i;
+		std::stable_sort(order.begin(),order.end(),[this](u32 a,u32 b){
+			return buffers[a].size > buffers[b].size;
+		});
+
+		arenaSize = 0;
+		std::vector<u32> placed;
+		std::vector<u32> conflicts; // placed buffers alive at the same time as the current one, by offset
+		for(u32 id : order){
+			Buffer& b = buffers[id];
+			conflicts.clear();
+			for(u32 p : placed){
+				if(buffers[p].first <= b.last && b.first <= buffers[p].last) conflicts.push_back(p);
+			}
+			std::sort(conflicts.begin(),conflicts.end(),[this](u32 x,u32 y){
+				return buffers[x].offset < buffers[y].offset;
+			});
+			// first gap big enough between the conflicting buffers
+			size_t offset = 0;
+			for(u32 c : conflicts){
+				if(buffers[c].offset >= offset + b.size) break;
+				offset = std::max(offset,buffers[c].offset + buffers[c].size);
+			}
+			b.offset = offset;
+			arenaSize = std::max(arenaSize,offset + b.size);
+			placed.push_back(id);
+		}
+	}
+
+	u32 MemoryPlan::count(){
+		return buffers.size();
+	}
+	size_t MemoryPlan::offset(u32 buffer){
+		return buffers[buffer].offset;
+	}
+	size_t MemoryPlan::size(u32 buffer){
+		return buffers[buffer].size;
+	}
+	size_t MemoryPlan::peak(){
+		return arenaSize;
+	}
+	size_t MemoryPlan::lowerBound(){
+		u32 steps = 0;
+		for(const Buffer& b : buffers){
+			steps = std::max(steps,b.last + 1);
+		}
+		std::vector<size_t> alive(steps,0);
+		for(const Buffer& b : buffers){
+			for(u32 t = b.first;t <= b.last;t++) alive[t] += b.size;
+		}
+		size_t bound = 0;
+		for(size_t a : alive){
+			bound = std::max(bound,a);
+		}
+		return bound;
+	}
+	size_t MemoryPlan::unshared(){
+		size_t total = 0;
+		for(const Buffer& b : buffers){
+			total += b.size;
+		}
+		return total;
+	}
+
+} /* namespace vio */
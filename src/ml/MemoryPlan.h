@@ -0,0 +1,60 @@
+/*
+ * MemoryPlan.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "utils/utils.h"
+
+namespace vio {
+
+	/**
+	Places buffers with known lifetimes inside one arena, so that buffers that are never alive at the same time share memory.
+
+	The computation is cut in steps (numbered from 0). A buffer is alive from the step that writes it to the last step that reads it,
+	both included. Two buffers alive during the same step never overlap in the arena.
+	The placement is the "greedy by size" heuristic: the biggest buffers are placed first, at the lowest offset that fits.
+	It is not always optimal, but it is never below lowerBound() and usually equal to it for chains of layers.
+
+	@code
+	MemoryPlan plan;
+	u32 a = plan.add(1000,0); // written at step 0
+	u32 b = plan.add(500,1);
+	plan.extend(a,1); // a is read at step 1
+	u32 c = plan.add(1000,2); // can reuse the memory of a
+	plan.solve();
+	float * arena = new float[plan.peak()];
+	float * pc = arena + plan.offset(c);
+	@endcode
+	 */
+	class MemoryPlan{
+	private:
+		struct Buffer{
+			size_t size;
+			u32 first;
+			u32 last;
+			size_t offset;
+		};
+		std::vector<Buffer> buffers;
+		size_t arenaSize = 0;
+	public:
+		u32 add(size_t size,u32 step); // a buffer of size elements written at step, returns its id.
+		void extend(u32 buffer,u32 step); // the buffer is read at step.
+		void clear();
+
+		void solve(); // computes the offsets, call it after adding every buffer.
+
+		u32 count();
+		size_t offset(u32 buffer);
+		size_t size(u32 buffer);
+		size_t peak(); // size of the arena, in elements
+		size_t lowerBound(); // max over the steps of the total size of the buffers alive during that step
+		size_t unshared(); // sum of the sizes, the memory needed if every buffer had its own storage
+	};
+
+} /* namespace vio */
@@ -0,0 +1,175 @@
+/*
+ * ModelFormat.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "ModelFormat.h"
+#include "DenseLayer.h"
+#include "ConvLayer.h"
+#include "BatchNormLayer.h"
+#include "SoftMaxLayer.h"
+
+#include <cstring>
+#include <cstdio>
+
+#ifdef WIN32
+#include <codecvt>
+#include <locale>
+#endif
+
+namespace vio {
+
+	static uint64_t alignUp(uint64_t v){
+		return (v + MODEL_ALIGNMENT - 1) / MODEL_ALIGNMENT * MODEL_ALIGNMENT;
+	}
+
+	ModelLayout computeModelLayout(std::vector<Layer*>& layers,const std::vector<ParameterBlock>& extra){
+		ModelLayout layout;
+		for(u32 i = 0;i < layers.size();i++){
+			ModelLayerRecord lr;
+			lr.descriptor = layers[i]->describe();
+			if(lr.descriptor.type == LAYER_UNKNOWN){
+				vpanic("Layer %i cannot be serialized, it does not implement describe()",i);
+			}
+			std::vector<ParameterBlock> params = layers[i]->parameters();
+			lr.firstBlock = layout.blocks.size();
+			lr.blockCount = params.size();
+			layout.layers.push_back(lr);
+			for(const ParameterBlock& p : params){
+				layout.blocks.push_back({0,p.size,i});
+			}
+		}
+		for(const ParameterBlock& p : extra){
+			layout.blocks.push_back({0,p.size,MODEL_NO_LAYER});
+		}
+
+		uint64_t offset = sizeof(ModelHeader) + layout.layers.size() * sizeof(ModelLayerRecord) + layout.blocks.size() * sizeof(ModelBlockRecord);
+		for(ModelBlockRecord& b : layout.blocks){
+			offset = alignUp(offset);
+			b.offset = offset;
+			offset += (uint64_t)b.size * sizeof(float);
+		}
+		layout.size = alignUp(offset);
+		return layout;
+	}
+
+	void writeModelHeader(const ModelLayout& layout,u32 lossFunction,char * image){
+		ModelHeader h;
+		memset(&h,0,sizeof(h));
+		h.magic = MODEL_MAGIC;
+		h.version = MODEL_VERSION;
+		h.layerCount = layout.layers.size();
+		h.blockCount = layout.blocks.size();
+		h.lossFunction = lossFunction;
+		h.fileSize = layout.size;
+		h.layerTableOffset = sizeof(ModelHeader);
+		h.blockTableOffset = h.layerTableOffset + layout.layers.size() * sizeof(ModelLayerRecord);
+
+		// zero everything first so that the padding is deterministic.
+		memset(image,0,layout.blocks.size() > 0 ? layout.blocks[0].offset : layout.size);
+		memcpy(image,&h,sizeof(h));
+		if(layout.layers.size() > 0){
+			memcpy(image + h.layerTableOffset,layout.layers.data(),layout.layers.size() * sizeof(ModelLayerRecord));
+		}
+		if(layout.blocks.size() > 0){
+			memcpy(image + h.blockTableOffset,layout.blocks.data(),layout.blocks.size() * sizeof(ModelBlockRecord));
+		}
+	}
+
+	void writeModelWeights(const ModelLayout& layout,std::vector<Layer*>& layers,const std::vector<ParameterBlock>& extra,char * image){
+		vassert(layout.layers.size() == layers.size());
+		u32 blockIndex = 0;
+		// the block, then zeros up to the next one, so that the same weights always give the same bytes.
+		auto write = [&](const ParameterBlock& p){
+			const ModelBlockRecord& b = layout.blocks[blockIndex];
+			vassert(b.size == p.size);
+			const uint64_t end = b.offset + (uint64_t)p.size * sizeof(float);
+			const uint64_t next = blockIndex + 1 < layout.blocks.size() ? layout.blocks[blockIndex + 1].offset : layout.size;
+			memcpy(image + b.offset,p.data,(size_t)p.size * sizeof(float));
+			memset(image + end,0,next - end);
+			blockIndex++;
+		};
+		for(u32 i = 0;i < layers.size();i++){
+			for(const ParameterBlock& p : layers[i]->parameters()){
+				write(p);
+			}
+		}
+		for(const ParameterBlock& p : extra){
+			write(p);
+		}
+		vassert(blockIndex == layout.blocks.size());
+	}
+
+	// true if count items of itemSize bytes starting at offset fit in size bytes. Never overflows, whatever the values read from the file.
+	static bool fitsIn(uint64_t offset,uint64_t count,uint64_t itemSize,uint64_t size){
+		return offset <= size && count <= (size - offset) / itemSize;
+	}
+
+	const char * validateModel(const char * image,uint64_t size){
+		if(size < sizeof(ModelHeader)) return "file too small to be a model";
+		const ModelHeader * h = (const ModelHeader*)image;
+		if(h->magic != MODEL_MAGIC) return "not a vlearn model (bad magic number)";
+		if(h->version != MODEL_VERSION) return "unsupported model version";
+		if(h->fileSize > size) return "truncated model";
+		if(!fitsIn(h->layerTableOffset,h->layerCount,sizeof(ModelLayerRecord),size)) return "layer table out of bounds";
+		if(!fitsIn(h->blockTableOffset,h->blockCount,sizeof(ModelBlockRecord),size)) return "block table out of bounds";
+		if(h->layerTableOffset % alignof(ModelLayerRecord) != 0 || h->blockTableOffset % alignof(ModelBlockRecord) != 0){
+			return "misaligned tables";
+		}
+
+		const ModelLayerRecord * lr = (const ModelLayerRecord*)(image + h->layerTableOffset);
+		const ModelBlockRecord * br = (const ModelBlockRecord*)(image + h->blockTableOffset);
+		for(u32 i = 0;i < h->layerCount;i++){
+			if((uint64_t)lr[i].firstBlock + lr[i].blockCount > h->blockCount) return "layer references missing blocks";
+		}
+		for(u32 i = 0;i < h->blockCount;i++){
+			if(br[i].offset % MODEL_ALIGNMENT != 0) return "misaligned weight section";
+			if(!fitsIn(br[i].offset,br[i].size,sizeof(float),size)) return "weight section out of bounds";
+		}
+		return 0;
+	}
+
+	Layer * createLayer(const LayerDescriptor& d){
+		Layer * l = 0;
+		switch(d.type){
+			case LAYER_DENSE:
+				l = new DenseLayer(d.inputSize,d.outputSize,DenseLayer::activatorName(d.args[0]));
+				break;
+			case LAYER_CONV:
+				if(d.args[0] == 0) return 0;
+				l = new ConvLayer(d.inputSize,d.args[0],d.args[1],d.args[2]);
+				break;
+			case LAYER_BATCHNORM:
+				l = new BatchNormLayer(d.inputSize);
+				break;
+			case LAYER_SOFTMAX:
+				l = new SoftMaxLayer(d.inputSize);
+				break;
+			default:
+				return 0;
+		}
+		if(l->outputSize() != d.outputSize){
+			delete l;
+			return 0;
+		}
+		return l;
+	}
+
+	bool writeBinaryFile(const std::string& path,const char * data,uint64_t size){
+		FILE * f = 0;
+#ifdef WIN32
+		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+		std::wstring wpath = convert.from_bytes(path.c_str());
+		_wfopen_s(&f,wpath.c_str(),L"wb");
+#else
+		f = fopen(path.c_str(),"wb");
+#endif
+		if(f == 0) return false;
+		bool ok = fwrite(data,1,size,f) == size;
+		ok = (fclose(f) == 0) && ok;
+		return ok;
+	}
+
+} /* namespace vio */
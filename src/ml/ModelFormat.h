@@ -0,0 +1,92 @@
+/*
+ * ModelFormat.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Layer.h"
+
+namespace vio {
+
+/**
+@notitle
+	ModelFormat describes the binary files produced by NeuralNetwork::serialize (version 1).
+	Integers are stored in the byte order of the machine (little endian on x86).
+
+	@code
+	offset 0          ModelHeader (64 bytes)
+	layerTableOffset  ModelLayerRecord * layerCount
+	blockTableOffset  ModelBlockRecord * blockCount
+	blocks[i].offset  the floats of block i, every block starts on a 64 byte boundary
+	@endcode
+
+	Because the weights are stored exactly like they are in memory and aligned, a model can be mapped
+	and used in place without being parsed (see NeuralNetwork::loadMapped).
+	Blocks that do not belong to a layer (layer == MODEL_NO_LAYER) store extra state, like the moments of an optimizer.
+*/
+
+static constexpr u32 MODEL_MAGIC = 0x4e4e4c56; // "VLNN"
+static constexpr u32 MODEL_VERSION = 1;
+static constexpr u32 MODEL_ALIGNMENT = 64;
+static constexpr u32 MODEL_NO_LAYER = 0xffffffff;
+
+struct ModelHeader{
+	u32 magic;
+	u32 version;
+	u32 layerCount;
+	u32 blockCount;
+	u32 lossFunction; // see LossFunction in NeuralNetwork.h
+	u32 flags; // 0 for now
+	uint64_t fileSize;
+	uint64_t layerTableOffset;
+	uint64_t blockTableOffset;
+	u32 reserved[4];
+};
+static_assert(sizeof(ModelHeader) == 64,"The model header is part of the file format");
+
+struct ModelLayerRecord{
+	LayerDescriptor descriptor;
+	u32 firstBlock;
+	u32 blockCount;
+};
+static_assert(sizeof(ModelLayerRecord) == 40,"Layer records are part of the file format");
+
+struct ModelBlockRecord{
+	uint64_t offset; // from the start of the file, multiple of MODEL_ALIGNMENT
+	u32 size; // in floats
+	u32 layer; // owning layer or MODEL_NO_LAYER
+};
+static_assert(sizeof(ModelBlockRecord) == 16,"Block records are part of the file format");
+
+// Where everything goes inside a model image. It only depends on the shape of the network,
+// so it can be computed once and reused for every checkpoint.
+struct ModelLayout{
+	std::vector<ModelLayerRecord> layers;
+	std::vector<ModelBlockRecord> blocks;
+	uint64_t size = 0; // total size of the image in bytes
+};
+
+ModelLayout computeModelLayout(std::vector<Layer*>& layers,const std::vector<ParameterBlock>& extra = {});
+
+// image must be at least layout.size bytes long.
+void writeModelHeader(const ModelLayout& layout,u32 lossFunction,char * image);
+// Copies the current weights (and the extra blocks) at their place in the image and zeroes the padding after each block.
+void writeModelWeights(const ModelLayout& layout,std::vector<Layer*>& layers,const std::vector<ParameterBlock>& extra,char * image);
+
+// Checks that an image is a well formed model (magic, version, every table and block inside the image and aligned).
+// Returns 0 if the image is valid, a description of the problem otherwise.
+const char * validateModel(const char * image,uint64_t size);
+
+// Creates a layer from its descriptor, with uninitialized weights. Returns 0 for unknown layer types.
+Layer * createLayer(const LayerDescriptor& descriptor);
+
+// Writes size bytes to path. Returns false on failure.
+bool writeBinaryFile(const std::string& path,const char * data,uint64_t size);
+
+} /* namespace vio */
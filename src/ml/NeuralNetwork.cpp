@@ -1,211 +1,758 @@
-#include "NeuralNetwork.h"
-
-#include "math/math.h"
-#include "utils/utils.h"
-
-namespace vio{
-
-
-	float L2errorFn(const Vector& in,const Vector& expected){
-		Vector r = Vector::sub(in,expected);
-		return r.norm();
-	}
-	Vector L2errorDerivativeFn(const Vector& in,const Vector& expected){
-		Vector r = Vector::sub(in,expected);
-		if(r.normSquared() < 0.00001){
-			r.fill(0);
-			return r;
-		}
-		r /= r.norm();
-		return r;
-	}
-
-	float crossEntropyErrorFn(const Vector& in,const Vector& expected){
-		// in=p, expected = q
-		// apply softmax to in.
-		float r = 0;
-		for(u32 i = 0;i < in.size();i++){
-			if(in.get(i) > 0){
-				r -= expected.get(i) * log2(in.get(i));
-			}else{
-				vpanic("Unable to evaluate the cross-entropy if the input is not a probability distribution."
-						" Did you forget a softmax layer at the end of your network ?");
-			}
-		}
-		return r;
-	}
-	Vector crossEntropyErrorDerivative(const Vector& in,const Vector& expected){
-		return Vector::sub(in,expected);
-	}
-
-
-	NeuralNetwork::NeuralNetwork(){
-		this->errorFunction = L2errorFn;
-		this->errorFunctionGradient = L2errorDerivativeFn;
-		computationFunction = 0;
-	}
-	NeuralNetwork::~NeuralNetwork(){}
-
-	Vector NeuralNetwork::apply(const Vector& v){
-		Vector res(v);
-		u32 i = 0;
-		for(Layer* l : layers){
-			i++;
-			res = std::move(l->apply(res));
-		}
-		return res;
-	}
-
-
-	float NeuralNetwork::loss(std::vector<Vector>& in,std::vector<Vector>& out){
-		vassert(in.size() == out.size());
-		float t = 0;
-		for(u32 i = 0;i < in.size();i++){
-			t += this->errorFunction(apply(in[i]),out[i]);
-		}
-		return t / in.size(); // avg error
-	}
-
-	void NeuralNetwork::prepare(){
-		// TODO allocate memory for the training
-		isReady = true;
-		for(u32 i = 0;i < layers.size()-1;i++){
-			if(layers[i]->outputSize() != layers[i+1]->inputSize()){
-				vpanic("Layers are misshaped, layer %i has outputSize %i but layer %i has inputSize %i !",
-					i,layers[i]->outputSize(),i+1,layers[i+1]->inputSize());
-			}
-		}
-	}
-
-	// a classic implementation of the computation function for a CPU backend.
-	// this function is (almost) pure and can be run on many thread by changing the start and end indices.
-	UpdatePair cpuComputationFunction(NeuralNetwork& ref,u32 layerIndex,u32 tstart,u32 tend,std::vector<Vector>& in,std::vector<Vector>& out,const std::vector<u32> permutationTable){
-		vassert(tend > tstart);
-		vassert(ref.layers[layerIndex]->isLearnable());
-
-		Matrix updateM(ref.layers[layerIndex]->inputSize(),ref.layers[layerIndex]->outputSize());
-		const int updateVSize = ref.layers[layerIndex]->isBias() ? ref.layers[layerIndex]->outputSize() : 0;
-		Vector updateV(updateVSize); // size is 0 if there is not bias to learn.
-
-		updateM.fill(0);
-		updateV.fill(0);
-
-		for(u32 train_index = tstart;train_index < tend;train_index++){
-			u32 real_index = permutationTable[train_index];
-			// Evaluate the intermediate results for every layer.
-			// intermediate.size == layer.size + 1
-			std::vector<Vector> intermediate{ in[real_index] };
-			for(u32 j = 0;j < ref.layers.size();j++){
-				intermediate.push_back(ref.layers[j]->apply(intermediate[intermediate.size() - 1]));
-			}
-
-			if(!ref.layers[layerIndex]->isLearnable()) continue;
-
-			// Gradient computation is here.
-			// J/dx * dx/dm = J/dm (the thing we wanna compute). We know that dx/dm = transpose(v)
-			// Let's compute v2 = J/dx (it's a vector)
-
-			Vector v2 = ref.errorFunctionGradient(intermediate[intermediate.size() - 1 ],out[real_index]);
-			if(v2.normSquared() == 0.00){
-				continue;
-			}
-
-			for(i32 j = ref.layers.size()-1;j > (i32)layerIndex;j--){ // j in [ 1;layer.size() ]
-				v2 = std::move(ref.layers[j]->applyGradient(v2,intermediate[j],intermediate[j-1]));
-			}
-
-
-			updateM += Vector::crossNorm(v2,intermediate[layerIndex]); // J/dx * dx/dm = J/dm
-			if(ref.layers[layerIndex]->isBias()){
-				updateV += v2;
-			}
-
-		}
-
-		updateM /= (tend - tstart);
-		updateV /= (tend - tstart);
-
-		UpdatePair upair{updateM,updateV};
-
-		return upair;
-	}
-
-	void NeuralNetwork::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
-		if(!isReady){
-			vpanic("The neural network is not ready! Call neuralnetwork.prepare() first!");
-		}
-		vassert(in.size() == out.size());
-
-		// TODO The amount of memory allocated by train for all the vectors and stuff is crazy.
-		// We need to use a custom allocator that would call free and new only once during the whole training session.
-		// Indeed the amount of memory needed to run this function is deterministic and depends only on the dimensions of the network,
-		// not on the values it contains.
-
-		// TODO save a model
-
-		// TODO Abstract Parallelism : an interface to represent ML tasks
-
-		// shuffle in and out using a permutation.
-		std::vector<u32> permutation;
-		for(u32 i = 0;i < in.size();i++){
-			permutation.push_back(i);
-		}
-		for(u32 i = 0;i < in.size();i++){
-			// do the swaps.
-			u32 temp = permutation[i];
-			u32 swap_index = randomU32(in.size()-1);
-			permutation[i] = permutation[swap_index];
-			permutation[swap_index] = temp;
-		}
-
-		// u32 batchSize = in.size() / computationCoreCount;
-
-		for(u32 train_index = 0;train_index < in.size();train_index++){
-			u32 real_index = permutation[train_index];
-			// Evaluate the intermediate results for every layer.
-			// intermediate.size == layer.size + 1
-			std::vector<Vector> intermediate{ in[real_index] };
-			for(u32 j = 0;j < layers.size();j++){
-				intermediate.push_back(layers[j]->apply(intermediate[intermediate.size() - 1]));
-			}
-
-
-			for(u32 i = 0;i < layers.size();i++){
-				if(!layers[i]->isLearnable()) continue;
-
-				// Gradient computation starts here:
-
-				// J/dx * dx/dm = J/dm (the thing we wanna compute). We know that dx/dm = transpose(v)
-				
-				// Let's compute v2 = J/dx (it's a vector)
-				Vector v2 = this->errorFunctionGradient(intermediate[intermediate.size() - 1 ],out[real_index]);
-				if(v2.normSquared() == 0.00){
-					continue;
-				}
-
-				for(i32 j = layers.size()-1;j > (i32)i;j--){ // j in [ 1;layer.size() ]
-					v2 = std::move(layers[j]->applyGradient(v2,intermediate[j],intermediate[j-1]));
-				}
-
-				// Matrix totalGradient(layers[i]->inputSize(),layers[i]->outputSize());
-				Matrix totalGradient = Vector::crossNorm(v2,intermediate[i]); // J/dx * dx/dm = J/dm
-
-				totalGradient *= learningRate;
-
-				// adam implementation
-				// adam requests us to store the gradients from the previous steps inside moment vectors.
-				// this would triple the RAM usage.
-				// how to deal with this ?
-
-				layers[i]->updateMatrix(totalGradient); // adjuste the layer based on the average gradient.
-
-				if(layers[i]->isBias()){
-					v2 *= learningRate;
-					layers[i]->updateBias(v2);
-				}
-			}
-		}
-
-	}
-
-}
+#include "NeuralNetwork.h"
+#include "ModelFormat.h"
+#include "Checkpointer.h"
+#include "Profiler.h"
+
+#include <cstring>
+
+#include "utils/ThreadPool.h" // before math.h and its max macro
+#include "math/RandomStream.h"
+#include "math/math.h"
+#include "utils/utils.h"
+#include "file/MappedFile.h"
+
+namespace vio{
+
+
+	float L2errorFn(const Vector& in,const Vector& expected){
+		// norm(in - expected), without allocating the difference.
+		vassert(in.size() == expected.size());
+		float n = 0;
+		for(u32 i = 0;i < in.size();i++){
+			float d = in.get(i) - expected.get(i);
+			n += d * d;
+		}
+		return std::sqrt(n);
+	}
+	Vector L2errorDerivativeFn(const Vector& in,const Vector& expected){
+		Vector r = Vector::sub(in,expected);
+		if(r.normSquared() < 0.00001){
+			r.fill(0);
+			return r;
+		}
+		r /= r.norm();
+		return r;
+	}
+
+	float crossEntropyErrorFn(const Vector& in,const Vector& expected){
+		// in=p, expected = q
+		// apply softmax to in.
+		float r = 0;
+		for(u32 i = 0;i < in.size();i++){
+			if(in.get(i) > 0){
+				r -= expected.get(i) * log2(in.get(i));
+			}else{
+				vpanic("Unable to evaluate the cross-entropy if the input is not a probability distribution."
+						" Did you forget a softmax layer at the end of your network ?");
+			}
+		}
+		return r;
+	}
+	Vector crossEntropyErrorDerivative(const Vector& in,const Vector& expected){
+		return Vector::sub(in,expected);
+	}
+
+
+	NeuralNetwork::NeuralNetwork(){
+		this->errorFunction = L2errorFn;
+		this->errorFunctionGradient = L2errorDerivativeFn;
+		computationFunction = 0;
+	}
+	NeuralNetwork::~NeuralNetwork(){
+		ready();
+		releaseLoadedLayers();
+	}
+
+	Vector NeuralNetwork::apply(const Vector& v){
+		Vector res(v);
+		for(u32 i = 0;i < layers.size();i++){
+			Profiler::Scope scope(profiler,i,layers[i],Profiler::FORWARD);
+			res = std::move(layers[i]->apply(res));
+		}
+		return res;
+	}
+
+
+	const float * NeuralNetwork::forwardScratch(const Vector& in,float * arena){
+		float * src = (float*)in.raw();
+		for(u32 j = 0;j < layers.size();j++){
+			float * dst = arena + inferencePlan.offset(inferenceBuffer[j]);
+			Vector vin(layers[j]->inputSize(),src);
+			Vector vout(layers[j]->outputSize(),dst);
+			Profiler::Scope scope(profiler,j,layers[j],Profiler::FORWARD);
+			layers[j]->applyInto(vin,vout);
+			src = dst;
+		}
+		return src;
+	}
+
+	// Samples per task of the thread pool when evaluating the loss.
+	static constexpr u32 LOSS_GRAIN = 64;
+
+	float NeuralNetwork::loss(std::vector<Vector>& in,std::vector<Vector>& out){
+		vassert(in.size() == out.size());
+		if(in.size() == 0) return 0;
+		if(!isReady) prepare();
+
+		// The error of every sample is stored and summed pairwise at the end:
+		// the result does not depend on the number of threads or on the scheduling.
+		if(lossValues.size() < in.size()) lossValues.resize(in.size());
+		float * values = lossValues.data();
+		float * scratch = (float*)memory;
+		const size_t width = inferencePlan.peak();
+		const u32 outS = layers.size() > 0 ? layers.back()->outputSize() : 0;
+
+		pool->parallelFor(in.size(),LOSS_GRAIN,[&](u32 begin,u32 end,u32 worker){
+			float * arena = scratch + worker * width;
+			for(u32 i = begin;i < end;i++){
+				if(layers.size() == 0){
+					values[i] = this->errorFunction(in[i],out[i]);
+					continue;
+				}
+				Vector result(outS,(float*)forwardScratch(in[i],arena));
+				values[i] = this->errorFunction(result,out[i]);
+			}
+		});
+		return pairwiseSum(values,in.size()) / in.size(); // avg error
+	}
+
+	void NeuralNetwork::prepare(){
+		isReady = true;
+		for(u32 i = 0;i + 1 < layers.size();i++){
+			if(layers[i]->outputSize() != layers[i+1]->inputSize()){
+				vpanic("Layers are misshaped, layer %i has outputSize %i but layer %i has inputSize %i !",
+					i,layers[i]->outputSize(),i+1,layers[i+1]->inputSize());
+			}
+		}
+
+		if(pool == 0 || pool->size() != computationCoreCount){
+			delete pool;
+			pool = new ThreadPool(computationCoreCount);
+		}
+
+		gradientBlocks.clear();
+		workerActivations.clear();
+		workerGradients.clear();
+		planMemory();
+	}
+
+	static constexpr u32 NO_BUFFER = ~0u;
+
+	void NeuralNetwork::planMemory(){
+		const u32 L = layers.size();
+
+		// Inference: the output of layer j is written at step j and read at step j+1, by the next layer or the error function.
+		inferencePlan.clear();
+		inferenceBuffer.clear();
+		for(u32 j = 0;j < L;j++){
+			inferenceBuffer.push_back(inferencePlan.add(layers[j]->outputSize(),j));
+			inferencePlan.extend(inferenceBuffer[j],j+1);
+		}
+		inferencePlan.solve();
+
+		// Training: replays the steps of train for one sample, the same way it keeps, releases and recomputes the activations.
+		const u32 k = activationCheckpointInterval > 0 ? activationCheckpointInterval : 1;
+		plannedInterval = k;
+		u32 firstLearnable = L;
+		for(u32 i = 0;i < L;i++){
+			if(layers[i]->isLearnable()){
+				firstLearnable = i;
+				break;
+			}
+		}
+		auto keep = [L,k](u32 i){ return i == 0 || i == L || (i+1) % k == 0; };
+
+		trainingPlan.clear();
+		activationBuffer.assign(L + 1,NO_BUFFER);
+		recomputeBuffer.assign(L + 1,NO_BUFFER);
+		weightGradientBuffer.assign(L,NO_BUFFER);
+		gradientBuffer.assign(L + 1,NO_BUFFER);
+		std::vector<u32> live(L + 1,NO_BUFFER); // buffer holding intermediate[i] at the current step (the input is not planned)
+		u32 t = 0;
+		auto read = [&](u32 i){
+			if(live[i] != NO_BUFFER) trainingPlan.extend(live[i],t);
+		};
+
+		for(u32 j = 0;j < L;j++,t++){
+			read(j);
+			live[j+1] = activationBuffer[j+1] = trainingPlan.add(layers[j]->outputSize(),t);
+			if(!keep(j)) live[j] = NO_BUFFER;
+		}
+		// error function and its gradient
+		read(L);
+		u32 gradient = gradientBuffer[L] = trainingPlan.add(firstLearnable < L ? layers[L-1]->outputSize() : 0,t);
+		if(k > 1) live[L] = NO_BUFFER;
+		t++;
+
+		u32 segmentEnd = L;
+		while(segmentEnd > firstLearnable){
+			const u32 segmentStart = (segmentEnd - 1) / k * k;
+			const u32 base = segmentStart == 0 ? 0 : segmentStart - 1;
+			for(u32 i = base + 1;i < segmentEnd;i++){
+				if(live[i] == NO_BUFFER){
+					read(i-1);
+					live[i] = recomputeBuffer[i] = trainingPlan.add(layers[i-1]->outputSize(),t);
+					t++;
+				}
+			}
+			for(i32 j = segmentEnd - 1;j >= (i32)segmentStart && j >= (i32)firstLearnable;j--,t++){
+				trainingPlan.extend(gradient,t);
+				read(j);
+				u32 next = NO_BUFFER;
+				if(j > (i32)firstLearnable){
+					read(j-1);
+					next = gradientBuffer[j] = trainingPlan.add(layers[j]->inputSize(),t);
+				}
+				if(layers[j]->isLearnable()){
+					weightGradientBuffer[j] = trainingPlan.add((size_t)layers[j]->inputSize() * layers[j]->outputSize(),t);
+				}
+				if(next != NO_BUFFER) gradient = next;
+			}
+			for(u32 i = base + 1;i < segmentEnd;i++){
+				if(!keep(i)) live[i] = NO_BUFFER;
+			}
+			segmentEnd = segmentStart;
+		}
+		trainingPlan.solve();
+
+		delete[] (float*)memory;
+		const size_t inferenceSize = (size_t)pool->size() * inferencePlan.peak();
+		memory = new float[inferenceSize + trainingPlan.peak()];
+		trainingArena = (float*)memory + inferenceSize;
+	}
+
+	MemoryFootprint NeuralNetwork::memoryFootprint(){
+		if(!isReady) prepare();
+		MemoryFootprint f;
+		for(Layer * l : layers){
+			for(const ParameterBlock& b : l->parameters()){
+				f.parameters += (size_t)b.size * sizeof(float);
+			}
+		}
+		f.inference = inferencePlan.peak() * sizeof(float);
+		f.training = trainingPlan.peak() * sizeof(float);
+		f.trainingUnshared = trainingPlan.unshared() * sizeof(float);
+
+		// what batchGradient allocates for a batch large enough to use every block.
+		size_t block = 0,worker = 0,widest = 0;
+		for(Layer * l : layers){
+			if(l->isLearnable()) block += (size_t)l->inputSize() * l->outputSize() + (l->isBias() ? l->outputSize() : 0);
+			worker += l->outputSize();
+			widest = max(widest,(size_t)l->inputSize());
+		}
+		if(layers.size() > 0) worker += layers[0]->inputSize(); // the input with noise
+		worker += 2 * widest;
+		const size_t blocks = deterministic ? max(1u,deterministicBlocks) : pool->size();
+		f.batch = (blocks * block + pool->size() * worker) * sizeof(float);
+		return f;
+	}
+
+	void NeuralNetwork::ready(){
+		delete[] (float*)memory;
+		memory = 0;
+		trainingArena = 0;
+		delete pool;
+		pool = 0;
+		lossValues = std::vector<float>();
+		isReady = false;
+	}
+
+	// a classic implementation of the computation function for a CPU backend.
+	// this function is (almost) pure and can be run on many thread by changing the start and end indices.
+	UpdatePair cpuComputationFunction(NeuralNetwork& ref,u32 layerIndex,u32 tstart,u32 tend,std::vector<Vector>& in,std::vector<Vector>& out,const std::vector<u32> permutationTable){
+		vassert(tend > tstart);
+		vassert(ref.layers[layerIndex]->isLearnable());
+
+		Matrix updateM(ref.layers[layerIndex]->inputSize(),ref.layers[layerIndex]->outputSize());
+		const int updateVSize = ref.layers[layerIndex]->isBias() ? ref.layers[layerIndex]->outputSize() : 0;
+		Vector updateV(updateVSize); // size is 0 if there is not bias to learn.
+
+		updateM.fill(0);
+		updateV.fill(0);
+
+		for(u32 train_index = tstart;train_index < tend;train_index++){
+			u32 real_index = permutationTable[train_index];
+			// Evaluate the intermediate results for every layer.
+			// intermediate.size == layer.size + 1
+			std::vector<Vector> intermediate{ in[real_index] };
+			for(u32 j = 0;j < ref.layers.size();j++){
+				intermediate.push_back(ref.layers[j]->apply(intermediate[intermediate.size() - 1]));
+			}
+
+			if(!ref.layers[layerIndex]->isLearnable()) continue;
+
+			// Gradient computation is here.
+			// J/dx * dx/dm = J/dm (the thing we wanna compute). We know that dx/dm = transpose(v)
+			// Let's compute v2 = J/dx (it's a vector)
+
+			Vector v2 = ref.errorFunctionGradient(intermediate[intermediate.size() - 1 ],out[real_index]);
+			if(v2.normSquared() == 0.00){
+				continue;
+			}
+
+			for(i32 j = ref.layers.size()-1;j > (i32)layerIndex;j--){ // j in [ 1;layer.size() ]
+				v2 = std::move(ref.layers[j]->applyGradient(v2,intermediate[j],intermediate[j-1]));
+			}
+
+
+			updateM += Vector::crossNorm(v2,intermediate[layerIndex]); // J/dx * dx/dm = J/dm
+			if(ref.layers[layerIndex]->isBias()){
+				updateV += v2;
+			}
+
+		}
+
+		updateM /= (tend - tstart);
+		updateV /= (tend - tstart);
+
+		UpdatePair upair{updateM,updateV};
+
+		return upair;
+	}
+
+	u32 NeuralNetwork::argmax(const Vector& v){
+		u32 best = 0;
+		for(u32 i = 1;i < v.size();i++){
+			if(v.get(i) > v.get(best)) best = i;
+		}
+		return best;
+	}
+
+	std::vector<u32> NeuralNetwork::shuffledIndices(u32 n){
+		std::vector<u32> permutation;
+		for(u32 i = 0;i < n;i++){
+			permutation.push_back(i);
+		}
+		for(u32 i = 0;i < n;i++){
+			// do the swaps.
+			u32 temp = permutation[i];
+			u32 swap_index = randomU32(n-1);
+			permutation[i] = permutation[swap_index];
+			permutation[swap_index] = temp;
+		}
+		return permutation;
+	}
+
+	EpochStats NeuralNetwork::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		if(!isReady){
+			vpanic("The neural network is not ready! Call neuralnetwork.prepare() first!");
+		}
+		vassert(in.size() == out.size());
+
+		EpochStats stats;
+		stats.samples = in.size();
+		if(in.size() == 0) return stats;
+		if(lossValues.size() < in.size()) lossValues.resize(in.size());
+		u32 correct = 0;
+
+		// The activations and the gradients live in trainingArena, at the places chosen by planMemory.
+		if(plannedInterval != (activationCheckpointInterval > 0 ? activationCheckpointInterval : 1)) planMemory();
+		float * arena = trainingArena;
+
+		// TODO Abstract Parallelism : an interface to represent ML tasks
+
+		// shuffle in and out using a permutation.
+		std::vector<u32> permutation = shuffledIndices(in.size());
+
+		// u32 batchSize = in.size() / computationCoreCount;
+
+		const u32 L = layers.size();
+		const u32 k = activationCheckpointInterval > 0 ? activationCheckpointInterval : 1;
+		u32 firstLearnable = L; // nothing needs to be propagated below this layer.
+		for(u32 i = 0;i < L;i++){
+			if(layers[i]->isLearnable()){
+				firstLearnable = i;
+				break;
+			}
+		}
+		// intermediate[i] is kept during the whole step if this is true, otherwise it is recomputed when the backward pass needs it.
+		auto keep = [L,k](u32 i){ return i == 0 || i == L || (i+1) % k == 0; };
+
+		// intermediate.size == layer.size + 1, intermediate[i] is the input of layer i, a view over the arena.
+		// The activations that are not kept are released as soon as the next one is computed (size 0 = missing).
+		std::vector<Vector> intermediate(L + 1,Vector(0));
+
+		for(u32 train_index = 0;train_index < in.size();train_index++){
+			u32 real_index = permutation[train_index];
+			// Evaluate the intermediate results for every layer.
+			intermediate[0] = Vector(in[real_index].size(),in[real_index].raw());
+			for(u32 j = 0;j < L;j++){
+				intermediate[j+1] = Vector(layers[j]->outputSize(),arena + trainingPlan.offset(activationBuffer[j+1]));
+				Profiler::Scope scope(profiler,j,layers[j],Profiler::FORWARD);
+				layers[j]->applyInto(intermediate[j],intermediate[j+1]);
+				if(!keep(j)) intermediate[j] = Vector(0);
+			}
+
+			// The output is already there, the statistics are free.
+			lossValues[train_index] = this->errorFunction(intermediate[L],out[real_index]);
+			if(computeAccuracy && argmax(intermediate[L]) == argmax(out[real_index])){
+				correct++;
+			}
+
+			// Gradient computation starts here:
+			// J/dx * dx/dm = J/dm (the thing we wanna compute). We know that dx/dm = transpose(v)
+			// Let's compute v2 = J/dx (it's a vector), layer by layer, from the last one to the first learnable one.
+			// Every v2 lives in the arena, the result of errorFunctionGradient is copied there.
+			Vector v2(firstLearnable < L ? layers[L-1]->outputSize() : 0,arena + trainingPlan.offset(gradientBuffer[L]));
+			if(v2.size() > 0){
+				const Vector g = this->errorFunctionGradient(intermediate[L],out[real_index]);
+				vassert(g.size() == v2.size());
+				for(u32 i = 0;i < g.size();i++){
+					v2.at(i) = g.get(i);
+				}
+			}
+			if(k > 1) intermediate[L] = Vector(0); // not needed by the backward pass.
+
+			if(v2.normSquared() != 0.00){
+				// Segments of k layers, starting at multiples of k. The input of the segment (or the one just before it)
+				// is kept, the rest of the segment is recomputed from it.
+				u32 segmentEnd = L;
+				while(segmentEnd > firstLearnable){
+					const u32 segmentStart = (segmentEnd - 1) / k * k;
+					const u32 base = segmentStart == 0 ? 0 : segmentStart - 1;
+					for(u32 i = base + 1;i < segmentEnd;i++){
+						if(intermediate[i].size() == 0){
+							intermediate[i] = Vector(layers[i-1]->outputSize(),arena + trainingPlan.offset(recomputeBuffer[i]));
+							Profiler::Scope scope(profiler,i-1,layers[i-1],Profiler::FORWARD);
+							layers[i-1]->applyInto(intermediate[i-1],intermediate[i]);
+						}
+					}
+
+					for(i32 j = segmentEnd - 1;j >= (i32)segmentStart && j >= (i32)firstLearnable;j--){
+						// propagate through layer j before updating it, with the weights used for the forward pass.
+						const bool propagate = j > (i32)firstLearnable;
+						Vector next(0);
+						if(propagate){
+							next = Vector(layers[j]->inputSize(),arena + trainingPlan.offset(gradientBuffer[j]));
+							Profiler::Scope scope(profiler,j,layers[j],Profiler::BACKWARD);
+							layers[j]->applyGradientInto(v2,intermediate[j],intermediate[j-1],next);
+						}
+
+						if(layers[j]->isLearnable()){
+							Profiler::Scope scope(profiler,j,layers[j],Profiler::UPDATE);
+							Matrix totalGradient(layers[j]->inputSize(),layers[j]->outputSize(),arena + trainingPlan.offset(weightGradientBuffer[j]));
+							Vector::crossNorm(v2,intermediate[j],totalGradient); // J/dx * dx/dm = J/dm
+
+							totalGradient *= learningRate;
+
+							// adam implementation
+							// adam requests us to store the gradients from the previous steps inside moment vectors.
+							// this would triple the RAM usage.
+							// how to deal with this ?
+
+							layers[j]->updateMatrix(totalGradient); // adjuste the layer based on the average gradient.
+
+							if(layers[j]->isBias()){
+								v2 *= learningRate;
+								layers[j]->updateBias(v2);
+							}
+						}
+
+						if(propagate){
+							v2 = std::move(next);
+						}
+					}
+
+					for(u32 i = base + 1;i < segmentEnd;i++){
+						if(!keep(i)) intermediate[i] = Vector(0);
+					}
+					segmentEnd = segmentStart;
+				}
+			}
+
+			if(checkpointer != 0){
+				checkpointer->step(*this);
+			}
+		}
+
+		stats.loss = pairwiseSum(lossValues.data(),in.size()) / in.size();
+		if(computeAccuracy){
+			stats.accuracy = (float)correct / in.size();
+		}
+		return stats;
+
+	}
+
+	EpochStats NeuralNetwork::trainParallel(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate,u32 batchSize){
+		if(!isReady){
+			vpanic("The neural network is not ready! Call neuralnetwork.prepare() first!");
+		}
+		vassert(in.size() == out.size() && batchSize > 0);
+
+		EpochStats stats;
+		stats.samples = in.size();
+		if(in.size() == 0) return stats;
+		if(lossValues.size() < in.size()) lossValues.resize(in.size());
+
+		std::vector<u32> permutation = shuffledIndices(in.size());
+		const RandomStream noiseStreams = inputNoise > 0 ? RandomStream::fromGlobal() : RandomStream();
+		std::vector<char> correct(in.size(),0);
+
+		for(u32 start = 0;start < in.size();start += batchSize){
+			const u32 count = min(batchSize,(u32)in.size() - start);
+			batchGradient(in,out,permutation.data() + start,count,lossValues.data() + start,correct.data() + start,inputNoise > 0 ? &noiseStreams : 0);
+			applyBatchGradient(learningRate / count);
+			if(checkpointer != 0){
+				checkpointer->step(*this);
+			}
+		}
+
+		stats.loss = pairwiseSum(lossValues.data(),in.size()) / in.size();
+		if(computeAccuracy){
+			u32 c = 0;
+			for(char x : correct) c += x;
+			stats.accuracy = (float)c / in.size();
+		}
+		return stats;
+	}
+
+	// A block has at least this many samples, so that the final sum stays small compared to the batch.
+	static constexpr u32 MINIMUM_BLOCK_SAMPLES = 8;
+
+	void NeuralNetwork::batchGradient(std::vector<Vector>& in,std::vector<Vector>& out,const u32 * indices,u32 count,float * errors,char * hits,const RandomStream * noise){
+		if(!isReady) prepare();
+		const u32 L = layers.size();
+		u32 firstLearnable = L;
+		for(u32 i = 0;i < L;i++){
+			if(layers[i]->isLearnable()){
+				firstLearnable = i;
+				break;
+			}
+		}
+
+		// The gradient sums of every block. In deterministic mode, the blocks do not depend on the number of threads.
+		const u32 workers = pool->size();
+		const u32 blockCount = deterministic ? max(1u,deterministicBlocks) : workers;
+		const u32 used = max(1u,min(blockCount,count / MINIMUM_BLOCK_SAMPLES));
+		while(gradientBlocks.size() < used){
+			std::vector<UpdatePair> block;
+			for(Layer * l : layers){
+				const bool learnable = l->isLearnable();
+				block.push_back({Matrix(learnable ? l->inputSize() : 0,learnable ? l->outputSize() : 0),
+					Vector(learnable && l->isBias() ? l->outputSize() : 0)});
+			}
+			gradientBlocks.push_back(std::move(block));
+		}
+		if(workerActivations.size() < workers){
+			workerActivations.resize(workers);
+			for(std::vector<Vector>& act : workerActivations){
+				if(act.size() > 0) continue;
+				act.push_back(Vector(0));
+				for(Layer * l : layers){
+					act.push_back(Vector(l->outputSize()));
+				}
+				act.push_back(Vector(L > 0 ? layers[0]->inputSize() : 0));
+			}
+		}
+		if(workerGradients.size() < workers){
+			u32 widest = 0;
+			for(Layer * l : layers) widest = max(widest,l->inputSize());
+			workerGradients.resize(workers,std::vector<float>(2 * (size_t)widest));
+		}
+
+		// Adds the gradient of sample index (at position i of the batch) to g. The first sample of a block overwrites g.
+		// The propagated gradient of layer j goes to the half j % 2 of grad, so it never overwrites the one it is computed from.
+		auto accumulate = [&](u32 index,u32 i,std::vector<UpdatePair>& g,std::vector<Vector>& act,float * grad,bool first){
+			if(noise != 0){
+				// one stream per sample, whatever the thread doing it.
+				RandomStream stream = noise->split(index);
+				Vector& noisy = act[L+1];
+				noisy.fillGaussian(stream,inputNoise);
+				noisy += in[index];
+				act[0] = Vector(noisy.size(),noisy.raw());
+			}else{
+				act[0] = Vector(in[index].size(),in[index].raw());
+			}
+			for(u32 j = 0;j < L;j++){
+				layers[j]->applyInto(act[j],act[j+1]);
+			}
+			errors[i] = this->errorFunction(act[L],out[index]);
+			hits[i] = computeAccuracy && argmax(act[L]) == argmax(out[index]) ? 1 : 0;
+
+			Vector v2 = this->errorFunctionGradient(act[L],out[index]);
+			const bool zero = v2.normSquared() == 0.00;
+			for(i32 j = L - 1;j >= (i32)firstLearnable;j--){
+				Layer * l = layers[j];
+				if(zero){
+					if(first && l->isLearnable()){
+						g[j].m.fill(0);
+						g[j].v.fill(0);
+					}
+					continue;
+				}
+				Vector next(0);
+				if(j > (i32)firstLearnable){
+					next = Vector(l->inputSize(),grad + (j % 2) * workerGradients[0].size() / 2);
+					l->applyGradientInto(v2,act[j],act[j-1],next);
+				}
+				if(l->isLearnable()){
+					if(first){
+						Vector::crossNorm(v2,act[j],g[j].m);
+						if(l->isBias()) std::memcpy(g[j].v.raw(),v2.raw(),v2.size() * sizeof(float));
+					}else{
+						Vector::addCrossNorm(g[j].m,v2,act[j]);
+						if(l->isBias()) g[j].v += v2;
+					}
+				}
+				if(j > (i32)firstLearnable) v2 = std::move(next);
+			}
+		};
+
+		// block b sums the samples [count*b/used, count*(b+1)/used) in order.
+		pool->parallelFor(used,1,[&](u32 begin,u32 end,u32 worker){
+			for(u32 b = begin;b < end;b++){
+				const u32 first = (uint64_t)count * b / used;
+				const u32 last = (uint64_t)count * (b + 1) / used;
+				for(u32 s = first;s < last;s++){
+					accumulate(indices[s],s,gradientBlocks[b],workerActivations[worker],workerGradients[worker].data(),s == first);
+				}
+			}
+		});
+		// pairwise sum of the blocks, always in the same order.
+		for(u32 step = 1;step < used;step *= 2){
+			const u32 pairs = (used + 2 * step - 1) / (2 * step);
+			pool->parallelFor(pairs,1,[&](u32 begin,u32 end,u32 worker){
+				for(u32 p = begin;p < end;p++){
+					const u32 a = p * 2 * step,b = a + step;
+					if(b >= used) continue;
+					for(u32 j = firstLearnable;j < L;j++){
+						if(!layers[j]->isLearnable()) continue;
+						gradientBlocks[a][j].m += gradientBlocks[b][j].m;
+						gradientBlocks[a][j].v += gradientBlocks[b][j].v;
+					}
+				}
+			});
+		}
+	}
+
+	void NeuralNetwork::applyBatchGradient(float scale){
+		vassert(gradientBlocks.size() > 0);
+		for(u32 j = 0;j < layers.size();j++){
+			if(!layers[j]->isLearnable()) continue;
+			gradientBlocks[0][j].m *= scale;
+			layers[j]->updateMatrix(gradientBlocks[0][j].m);
+			if(layers[j]->isBias()){
+				gradientBlocks[0][j].v *= scale;
+				layers[j]->updateBias(gradientBlocks[0][j].v);
+			}
+		}
+	}
+
+	u32 NeuralNetwork::lossFunctionId(){
+		if(errorFunction == L2errorFn) return LOSS_L2;
+		if(errorFunction == crossEntropyErrorFn) return LOSS_CROSS_ENTROPY;
+		return LOSS_CUSTOM;
+	}
+	void NeuralNetwork::setLossFunction(u32 id){
+		if(id == LOSS_L2){
+			errorFunction = L2errorFn;
+			errorFunctionGradient = L2errorDerivativeFn;
+		}else if(id == LOSS_CROSS_ENTROPY){
+			errorFunction = crossEntropyErrorFn;
+			errorFunctionGradient = crossEntropyErrorDerivative;
+		}
+	}
+	void NeuralNetwork::releaseLoadedLayers(){
+		for(Layer * l : ownedLayers){
+			delete l;
+		}
+		ownedLayers.clear();
+		delete mapping; // after the layers, they might point inside.
+		mapping = 0;
+	}
+
+	std::string NeuralNetwork::serialize(){
+		ModelLayout layout = computeModelLayout(layers);
+		std::string image(layout.size,'\0');
+		writeModelHeader(layout,lossFunctionId(),&image[0]);
+		writeModelWeights(layout,layers,{},&image[0]);
+		return image;
+	}
+	bool NeuralNetwork::save(const std::string& path){
+		std::string image = serialize();
+		return writeBinaryFile(path,image.data(),image.size());
+	}
+
+	// Builds the layers described by a valid image. Returns false if a layer cannot be created.
+	// When inPlace is true, the layers use the weights of the image directly, otherwise they are copied.
+	static bool buildLayers(char * image,bool inPlace,std::vector<Layer*>& result){
+		const ModelHeader * h = (const ModelHeader*)image;
+		const ModelLayerRecord * lr = (const ModelLayerRecord*)(image + h->layerTableOffset);
+		const ModelBlockRecord * br = (const ModelBlockRecord*)(image + h->blockTableOffset);
+
+		for(u32 i = 0;i < h->layerCount;i++){
+			Layer * l = createLayer(lr[i].descriptor);
+			bool ok = l != 0;
+			std::vector<ParameterBlock> params;
+			if(ok){
+				params = l->parameters();
+				ok = params.size() == lr[i].blockCount;
+			}
+			for(u32 j = 0;ok && j < params.size();j++){
+				ok = br[lr[i].firstBlock + j].size == params[j].size;
+			}
+			if(!ok){
+				debug("Unable to load layer %i of the model (type %i)",i,lr[i].descriptor.type);
+				delete l;
+				for(Layer * r : result) delete r;
+				result.clear();
+				return false;
+			}
+
+			if(inPlace){
+				std::vector<float*> blocks;
+				for(u32 j = 0;j < params.size();j++){
+					blocks.push_back((float*)(image + br[lr[i].firstBlock + j].offset));
+				}
+				l->bindParameters(blocks);
+			}else{
+				for(u32 j = 0;j < params.size();j++){
+					memcpy(params[j].data,image + br[lr[i].firstBlock + j].offset,(size_t)params[j].size * sizeof(float));
+				}
+			}
+			result.push_back(l);
+		}
+		return true;
+	}
+
+	bool NeuralNetwork::load(const std::string& s){
+		const char * problem = validateModel(s.data(),s.size());
+		if(problem != 0){
+			debug("Unable to load model: %s",problem);
+			return false;
+		}
+		std::vector<Layer*> newLayers;
+		if(!buildLayers((char*)s.data(),false,newLayers)) return false;
+
+		releaseLoadedLayers();
+		ownedLayers = newLayers;
+		layers = newLayers;
+		setLossFunction(((const ModelHeader*)s.data())->lossFunction);
+		isReady = false;
+		return true;
+	}
+
+	bool NeuralNetwork::loadMapped(const std::string& path){
+		MappedFile * mf = new MappedFile(path);
+		const char * problem = mf->isLoaded() ? validateModel(mf->data(),mf->size()) : "unable to map the file";
+		if(problem != 0){
+			debug("Unable to load model %s: %s",path.c_str(),problem);
+			delete mf;
+			return false;
+		}
+		std::vector<Layer*> newLayers;
+		if(!buildLayers(mf->data(),true,newLayers)){
+			delete mf;
+			return false;
+		}
+
+		releaseLoadedLayers();
+		ownedLayers = newLayers;
+		layers = newLayers;
+		mapping = mf;
+		setLossFunction(((const ModelHeader*)mf->data())->lossFunction);
+		isReady = false;
+		return true;
+	}
+
+}
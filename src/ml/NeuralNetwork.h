@@ -1,82 +1,203 @@
-// Technicaly math.
-#pragma once
-
-#include <any>
-#include "math/Vector.h"
-#include "math/Matrix.h"
-#include <vector>
-#include <string>
-#include "Layer.h"
-
-namespace vio{
-
-	float crossEntropyErrorFn(const Vector& in,const Vector& expected);
-	Vector crossEntropyErrorDerivative(const Vector& in,const Vector& expected);
-
-	// Used to update a learnable layer with bias.
-	struct UpdatePair{
-		Matrix m;
-		Vector v;
-	};
-
-	/**
-	Represents a NeuralNetwork.
-	See DenseLayer for an example of how to use it.
-
-	Here is a description of the theoretical desscription of how this work.
-
-	A Network is list of Layers. A Layer describes an operation on a Vector.
-	By stacking various layers, you compose the operation together to create the network,
-	which you can see as a complicated function.
-
-	The layers also have function that "returns their derivative".
-	Because their derivative is a Matrix, (the jacobian of a function from Vectors to Vectors is a matrix),
-	the layers provide a function that multiplies a vector of your choice with their jacobian without
-	ever providing you their jacobian.
-
-	This is because their jacobian can be quite big and those matrices are often filled with zeroes and take a lot of space in memory.
-	By doing this, the layers can, internally, never store the jacobian directly.
-
-	 */
-	class NeuralNetwork{
-	private:
-		// Stuff to put inside memory:
-		// totalGradient = max(inputSize,outputSize) over layers
-		// intermediate = sum(inputSize) over layers + outputSize of last layer
-		// v2 = max(outputSize) over layers
-		// v3 = max(outputSize) over layers (temp space where v2 is copied for intermediate steps)
-		void *memory = 0;
-		bool isReady = false;
-	public:
-		NeuralNetwork();
-		~NeuralNetwork();
-
-		u32 computationCoreCount = 4; // number of operation the machine is able to do at the same time.
-
-		// an implementation of the computation, depending on the computing device used.
-		Matrix (*computationFunction)(NeuralNetwork& ref,u32 tstart,u32 tend,std::vector<Vector>& in,std::vector<Vector>& out,const std::vector<u32> permutationTable);
-
-		std::vector<Layer*> layers;
-
-		void train(std::vector<Vector>& in,std::vector<Vector>& out,float rate = 0.01);
-
-		// function applied to the last layer for gradient descent training.
-		// example (L2): norm(input - output)
-		// gradient of example: (input - output) / norm(input - output)
-		// If you cannot compute the gradient / error for the pair given (if the function used is not continuous at that point or something),
-		// return 0 and it will be ignored.
-		float (*errorFunction)(const Vector& input,const Vector& expected) = 0;
-		Vector (*errorFunctionGradient)(const Vector& input,const Vector& expected) = 0;
-
-		float loss(std::vector<Vector>& in,std::vector<Vector>& out);
-
-		void prepare(); // all this when ready, this will allocate the memory required by the network for fast trainign.
-		void ready(); // free the memory taken by prepare.
-
-		Vector apply(const Vector& in);
-
-		std::string serialize(); // TODO, used to save/load a trained network.
-		void load(std::string s);
-	};
-
-}
+// Technicaly math.
+#pragma once
+
+#include <any>
+#include "math/Vector.h"
+#include "math/Matrix.h"
+#include <vector>
+#include <string>
+#include "Layer.h"
+#include "MemoryPlan.h"
+
+namespace vio{
+
+	class MappedFile;
+	class Checkpointer;
+	class Profiler;
+	class ThreadPool;
+
+	float L2errorFn(const Vector& in,const Vector& expected);
+	Vector L2errorDerivativeFn(const Vector& in,const Vector& expected);
+	float crossEntropyErrorFn(const Vector& in,const Vector& expected);
+	Vector crossEntropyErrorDerivative(const Vector& in,const Vector& expected);
+
+	// Identifies the error function inside model files.
+	enum LossFunction : u32{
+		LOSS_CUSTOM = 0, // not saved, set errorFunction yourself after loading.
+		LOSS_L2 = 1,
+		LOSS_CROSS_ENTROPY = 2
+	};
+
+	// Returned by NeuralNetwork::train, computed from the outputs evaluated for the backpropagation (no extra forward pass).
+	// The weights change during the epoch, so this is the running average over the epoch,
+	// not exactly the loss of the network at the end of it (use NeuralNetwork::loss for that).
+	struct EpochStats{
+		float loss = 0; // average of errorFunction
+		float accuracy = -1; // fraction of samples where argmax(output) == argmax(expected), -1 when computeAccuracy is false.
+		u32 samples = 0;
+		bool ok = true; // false when a distributed trainer lost a peer: the epoch stopped and the weights must not be trusted.
+	};
+
+	// Computed by NeuralNetwork::prepare, in bytes. Use training to size a batch: a batch of n samples trained in parallel
+	// needs about n times as much.
+	struct MemoryFootprint{
+		size_t parameters = 0; // weights and biases of the layers
+		size_t inference = 0; // activations of one evaluation (apply, loss uses one per thread)
+		size_t training = 0; // activations and gradients alive at the peak of one sample of train
+		size_t trainingUnshared = 0; // the same if every buffer of the step had its own memory
+		size_t batch = 0; // trainParallel and batchGradient: gradient sums of the blocks and per thread activations and gradients
+	};
+
+	// Used to update a learnable layer with bias.
+	struct UpdatePair{
+		Matrix m;
+		Vector v;
+	};
+
+	/**
+	Represents a NeuralNetwork.
+	See DenseLayer for an example of how to use it.
+
+	Here is a description of the theoretical desscription of how this work.
+
+	A Network is list of Layers. A Layer describes an operation on a Vector.
+	By stacking various layers, you compose the operation together to create the network,
+	which you can see as a complicated function.
+
+	The layers also have function that "returns their derivative".
+	Because their derivative is a Matrix, (the jacobian of a function from Vectors to Vectors is a matrix),
+	the layers provide a function that multiplies a vector of your choice with their jacobian without
+	ever providing you their jacobian.
+
+	This is because their jacobian can be quite big and those matrices are often filled with zeroes and take a lot of space in memory.
+	By doing this, the layers can, internally, never store the jacobian directly.
+
+	 */
+	class NeuralNetwork{
+	private:
+		// The buffers of the forward and backward passes are placed by a liveness analysis (see MemoryPlan), done by prepare:
+		// two buffers share memory when they are never needed at the same time.
+		// memory holds one inference arena per thread (used by loss), then the training arena (used by train).
+		void *memory = 0;
+		bool isReady = false;
+		MemoryPlan inferencePlan; // one evaluation
+		MemoryPlan trainingPlan; // forward and backward pass of one sample in train
+		std::vector<u32> inferenceBuffer; // inferenceBuffer[j] = output of layer j
+		std::vector<u32> activationBuffer; // activationBuffer[i] = input of layer i during the forward pass of train (i > 0)
+		std::vector<u32> recomputeBuffer; // same when recomputed by the backward pass (gradient checkpointing), NO_BUFFER if it is kept
+		std::vector<u32> weightGradientBuffer; // gradient of the matrix of layer j, NO_BUFFER if it is not learnable
+		std::vector<u32> gradientBuffer; // gradient of the input of layer i (i < L), of the error function (i = L), NO_BUFFER if it is not propagated
+		u32 plannedInterval = 0; // activationCheckpointInterval used by trainingPlan
+		float * trainingArena = 0; // inside memory
+
+		ThreadPool * pool = 0; // computationCoreCount threads, created by prepare.
+		std::vector<float> lossValues; // error of every sample, reused between calls to loss.
+		// Used by batchGradient, allocated on first use and released by prepare.
+		std::vector<std::vector<UpdatePair>> gradientBlocks; // gradient sums of the blocks of a batch, the total ends up in gradientBlocks[0]
+		std::vector<std::vector<Vector>> workerActivations; // [w][j] = input of layer j for the sample of worker w, [w][L+1] = the input with noise
+		std::vector<std::vector<float>> workerGradients; // [w] = two buffers of the largest layer input, the propagated gradients of worker w
+
+		// Evaluates the network on in inside an inference arena. Returns a pointer to the output.
+		const float * forwardScratch(const Vector& in,float * arena);
+		// Computes the memory plans and allocates memory.
+		void planMemory();
+
+		// layers created by load / loadMapped, deleted with the network.
+		std::vector<Layer*> ownedLayers;
+		MappedFile * mapping = 0; // the weights of ownedLayers point inside when loaded with loadMapped.
+
+		void setLossFunction(u32 id);
+		void releaseLoadedLayers();
+	public:
+		NeuralNetwork();
+		~NeuralNetwork();
+
+		u32 computationCoreCount = 4; // number of operation the machine is able to do at the same time.
+
+		// an implementation of the computation, depending on the computing device used.
+		Matrix (*computationFunction)(NeuralNetwork& ref,u32 tstart,u32 tend,std::vector<Vector>& in,std::vector<Vector>& out,const std::vector<u32> permutationTable);
+
+		std::vector<Layer*> layers;
+
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float rate = 0.01);
+		bool computeAccuracy = false; // for classifiers, see EpochStats
+
+		// Mini batch gradient descent, the samples of a batch are spread over the computationCoreCount threads.
+		// The layers are updated once per batch with the average gradient. With batchSize = 1, this is the same as train.
+		// In deterministic mode, the batch is cut in deterministicBlocks blocks of consecutive samples, every block is summed in order
+		// and the blocks are added pairwise, always in the same order: the weights are bitwise identical for any number of threads.
+		// A block has at least 8 samples, so small batches use fewer threads.
+		// Without it, there is one block per thread: a bit faster, but the rounding errors depend on the number of threads.
+		// Gradient checkpointing is not used.
+		EpochStats trainParallel(std::vector<Vector>& in,std::vector<Vector>& out,float rate = 0.01,u32 batchSize = 32);
+		bool deterministic = true;
+		u32 deterministicBlocks = 8; // at most this many threads work on a batch in deterministic mode
+		// Deviation of a gaussian noise added to the inputs by trainParallel (0 = none).
+		// Every sample has its own random stream, so the noise does not depend on the thread that processes it.
+		float inputNoise = 0;
+
+		// The two halves of a step of trainParallel, for trainers that send the update somewhere else (see ParameterWorker).
+		// batchGradient sums the gradients of the samples indices[0..count) without changing the layers. The error of sample indices[i]
+		// is written in errors[i] and hits[i] is set to 1 if it is classified correctly (only with computeAccuracy).
+		// With noise, inputNoise is added to sample index with the stream noise->split(index).
+		// applyBatchGradient then updates the layers with the sums times scale (learningRate / count for the average).
+		void batchGradient(std::vector<Vector>& in,std::vector<Vector>& out,const u32 * indices,u32 count,float * errors,char * hits,const RandomStream * noise = 0);
+		void applyBatchGradient(float scale);
+
+		static u32 argmax(const Vector& v); // index of the largest value, the first one if there are several
+		static std::vector<u32> shuffledIndices(u32 n); // a random permutation of [0,n), drawn from the global generator (see seed)
+
+		// Gradient checkpointing: with k > 1, train only keeps one activation per segment of k layers during the forward pass
+		// and recomputes the others, one segment at a time, during the backward pass.
+		// Activation memory goes from ~L vectors to ~L/k + k (L = number of layers), for up to one extra forward pass.
+		// k = sqrt(L) is a good choice for deep networks. The trained weights do not depend on k.
+		u32 activationCheckpointInterval = 1;
+
+		// function applied to the last layer for gradient descent training.
+		// example (L2): norm(input - output)
+		// gradient of example: (input - output) / norm(input - output)
+		// If you cannot compute the gradient / error for the pair given (if the function used is not continuous at that point or something),
+		// return 0 and it will be ignored.
+		float (*errorFunction)(const Vector& input,const Vector& expected) = 0;
+		Vector (*errorFunctionGradient)(const Vector& input,const Vector& expected) = 0;
+
+		// Average of errorFunction over the dataset. Runs on computationCoreCount threads without allocating per sample.
+		// The result does not depend on the number of threads. Calls prepare() if needed.
+		float loss(std::vector<Vector>& in,std::vector<Vector>& out);
+
+		// When set, train() calls checkpointer->step after every sample, see Checkpointer.h
+		Checkpointer * checkpointer = 0;
+
+		// When set, apply, loss and train record the time spent in every layer, see Profiler.h
+		Profiler * profiler = 0;
+
+		// Peak memory of the buffers planned by prepare(). train allocates nothing else per sample, except the short lived
+		// vector returned by errorFunctionGradient (copied to its buffer).
+		MemoryFootprint memoryFootprint();
+
+		void prepare(); // all this when ready, this will allocate the memory required by the network for fast trainign. Call it again after changing layers or computationCoreCount.
+		void ready(); // free the memory taken by prepare.
+
+		Vector apply(const Vector& in);
+
+		/**
+		Save / load a trained network. The format is described in ModelFormat.h.
+		Every layer of the network has to implement Layer::describe.
+		Loading replaces the layers of the network by new ones owned by the network, call prepare() before training them.
+		The load functions return false (and leave the network untouched) if the model is invalid.
+		@code
+		nn.save("model.vlnn");
+
+		NeuralNetwork copy;
+		copy.loadMapped("model.vlnn"); // nothing is parsed or copied, the weights are read from the file when used.
+		Vector out = copy.apply(in);
+		@endcode
+		 */
+		std::string serialize(); // a binary image of the network.
+		bool load(const std::string& s); // copies the weights from the image.
+		bool save(const std::string& path);
+		bool loadMapped(const std::string& path); // the layers use the weights in place, inside the mapped file.
+		u32 lossFunctionId(); // LossFunction of errorFunction, LOSS_CUSTOM if it is not a builtin one.
+	};
+
+}
@@ -1,21 +1,94 @@
-/*
- * Optimizer.cpp
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#include "Optimizer.h"
-
-namespace vio {
-
-Optimizer::Optimizer() {
-	// TODO Auto-generated constructor stub
-
-}
-
-Optimizer::~Optimizer() {
-	// TODO Auto-generated destructor stub
-}
-
-} /* namespace vio */
+/*
+ * Optimizer.cpp
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#include "Optimizer.h"
+#include <cmath>
+
+namespace vio {
+
+Optimizer::Optimizer() {
+	// TODO Auto-generated constructor stub
+
+}
+
+Optimizer::~Optimizer() {
+	// TODO Auto-generated destructor stub
+}
+
+void Optimizer::prepare(std::vector<Layer*>& layers){}
+void Optimizer::adjustGradientMatrix(Matrix& gradm){}
+std::vector<ParameterBlock> Optimizer::state(){
+	return std::vector<ParameterBlock>();
+}
+
+ConstantOptimizer::ConstantOptimizer(){}
+ConstantOptimizer::~ConstantOptimizer(){}
+void ConstantOptimizer::prepare(std::vector<Layer*>& layers){}
+void ConstantOptimizer::adjustGradientMatrix(Matrix& gradm){
+	gradm *= learningRate;
+}
+
+AdamOptimizer::AdamOptimizer(float beta1,float beta2){
+	this->beta1 = beta1;
+	this->beta2 = beta2;
+	powers.data()[0] = 1;
+	powers.data()[1] = 1;
+}
+AdamOptimizer::~AdamOptimizer(){}
+
+void AdamOptimizer::prepare(std::vector<Layer*>& layers){
+	firstOrderMoment.clear();
+	secondOrderMoment.clear();
+	for(Layer * l : layers){
+		std::vector<ParameterBlock> p = l->parameters();
+		if(p.empty()) continue;
+		// the first block of a learnable layer is its matrix
+		firstOrderMoment.push_back(Matrix(p[0].size,1));
+		secondOrderMoment.push_back(Matrix(p[0].size,1));
+		firstOrderMoment.back().fill(0);
+		secondOrderMoment.back().fill(0);
+	}
+	powers.data()[0] = 1;
+	powers.data()[1] = 1;
+	nextLayer = 0;
+}
+
+void AdamOptimizer::adjustGradientMatrix(Matrix& gradm){
+	vassert(nextLayer < firstOrderMoment.size());
+	float * m = firstOrderMoment[nextLayer].data();
+	float * v = secondOrderMoment[nextLayer].data();
+	vassert(gradm.width() * gradm.height() == firstOrderMoment[nextLayer].width());
+	if(nextLayer == 0){ // new step
+		powers.data()[0] *= beta1;
+		powers.data()[1] *= beta2;
+	}
+	nextLayer = (nextLayer + 1) % firstOrderMoment.size();
+
+	const float c1 = 1 / (1 - powers.data()[0]);
+	const float c2 = 1 / (1 - powers.data()[1]);
+	float * g = gradm.data();
+	const u32 n = gradm.width() * gradm.height();
+	for(u32 i = 0;i < n;i++){
+		m[i] = beta1 * m[i] + (1 - beta1) * g[i];
+		v[i] = beta2 * v[i] + (1 - beta2) * g[i] * g[i];
+		g[i] = learningRate * m[i] * c1 / (std::sqrt(v[i] * c2) + 0.000001f);
+	}
+}
+
+std::vector<ParameterBlock> AdamOptimizer::state(){
+	std::vector<ParameterBlock> r;
+	for(Matrix& m : firstOrderMoment){
+		r.push_back({m.data(),m.width() * m.height()});
+	}
+	for(Matrix& m : secondOrderMoment){
+		r.push_back({m.data(),m.width() * m.height()});
+	}
+	r.push_back({powers.data(),2});
+	return r;
+}
+
+} /* namespace vio */
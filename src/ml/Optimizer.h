@@ -1,53 +1,60 @@
-/*
- * Optimizer.h
- *
- *  Created on: 30 avr. 2021
- *      Author: vanyle
- */
-
-#pragma once
-
-#include <vector>
-#include "math/Vector.h"
-#include "math/Matrix.h"
-#include "Layer.h"
-
-namespace vio {
-
-class Optimizer{
-public:
-	Optimizer();
-	virtual ~Optimizer();
-
-	virtual void prepare(std::vector<Layer*>& layers);
-	virtual void adjustGradientMatrix(Matrix& gradm);
-};
-
-class ConstantOptimizer : Optimizer{
-	float learningRate = 0.001;
-public:
-	ConstantOptimizer();
-	~ConstantOptimizer();
-
-	void prepare(std::vector<Layer*>& layers);
-	void adjustGradientMatrix(Matrix& gradm);
-};
-class AdamOptimizer : Optimizer{
-	float learningRate = 0.001;
-	// adam parameters taken from: https://arxiv.org/pdf/1412.6980.pdf
-	float beta1 = 0.9;
-	float beta2 = 0.999;
-	// Same size as the number of learnable layers (obtained with prepare)
-	std::vector<Matrix> firstOrderMoment; // m_t = beta1 * m_t-1 + (1 - beta1) * gradientMatrix
-	std::vector<Matrix> secondOrderMoment; // v_t = beta2 * v_t-1 + (1 - beta2) * gradientMatrix^2 (element wise multiplication)
-	// return learningRate * m_t / (1-beta1^t) / (sqrt(v_t / (1-beta2^t)) + 0.000001)
-public:
-	AdamOptimizer(float beta1 = 0.9,float beta2 = 0.999);
-	~AdamOptimizer();
-
-	void prepare(std::vector<Layer*>& layers);
-	void adjustGradientMatrix(Matrix& gradm);
-};
-
-} /* namespace vio */
-
+/*
+ * Optimizer.h
+ *
+ *  Created on: 30 avr. 2021
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include "math/Vector.h"
+#include "math/Matrix.h"
+#include "Layer.h"
+
+namespace vio {
+
+class Optimizer{
+public:
+	Optimizer();
+	virtual ~Optimizer();
+
+	virtual void prepare(std::vector<Layer*>& layers);
+	virtual void adjustGradientMatrix(Matrix& gradm);
+
+	// Internal state of the optimizer (moments, step counters, ...), saved inside checkpoints. Empty by default.
+	virtual std::vector<ParameterBlock> state();
+};
+
+class ConstantOptimizer : public Optimizer{
+	float learningRate = 0.001;
+public:
+	ConstantOptimizer();
+	~ConstantOptimizer();
+
+	void prepare(std::vector<Layer*>& layers);
+	void adjustGradientMatrix(Matrix& gradm);
+};
+// adjustGradientMatrix is called once per learnable layer and per step, in the order of the layers given to prepare.
+class AdamOptimizer : public Optimizer{
+	float learningRate = 0.001;
+	// adam parameters taken from: https://arxiv.org/pdf/1412.6980.pdf
+	float beta1 = 0.9;
+	float beta2 = 0.999;
+	// Same size as the number of learnable layers (obtained with prepare)
+	std::vector<Matrix> firstOrderMoment; // m_t = beta1 * m_t-1 + (1 - beta1) * gradientMatrix
+	std::vector<Matrix> secondOrderMoment; // v_t = beta2 * v_t-1 + (1 - beta2) * gradientMatrix^2 (element wise multiplication)
+	// return learningRate * m_t / (1-beta1^t) / (sqrt(v_t / (1-beta2^t)) + 0.000001)
+	Matrix powers = Matrix(2,1); // beta1^t and beta2^t, saved with the moments so that a restored optimizer continues at the same t
+	u32 nextLayer = 0; // index of the moments used by the next call to adjustGradientMatrix
+public:
+	AdamOptimizer(float beta1 = 0.9,float beta2 = 0.999);
+	~AdamOptimizer();
+
+	void prepare(std::vector<Layer*>& layers);
+	void adjustGradientMatrix(Matrix& gradm);
+	std::vector<ParameterBlock> state(); // the moments, then beta1^t and beta2^t
+};
+
+} /* namespace vio */
+
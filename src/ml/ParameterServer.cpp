@@ -0,0 +1,340 @@
+/*
+ * ParameterServer.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include <chrono>
+#include <cstring>
+#include "ParameterServer.h"
+#include "math/math.h"
+
+namespace vio {
+
+	void ParameterServer::shardRange(uint64_t parameterCount,u32 shard,u32 shardCount,uint64_t& begin,uint64_t& end){
+		begin = parameterCount * shard / shardCount;
+		end = parameterCount * (shard + 1) / shardCount;
+	}
+	uint64_t ParameterServer::parameterCount(NeuralNetwork& nn){
+		uint64_t total = 0;
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				total += p.size;
+			}
+		}
+		return total;
+	}
+
+	ParameterServer::ParameterServer(NeuralNetwork& nn,u32 shard,u32 shardCount,u32 workerCount,u32 port,u32 staleness){
+		vassert(shard < shardCount && workerCount > 0);
+		this->workerCount = workerCount;
+		this->port = port;
+		this->staleness = staleness;
+		clocks.assign(workerCount,0);
+		done.assign(workerCount,false);
+		failed.assign(workerCount,false);
+
+		uint64_t begin,end;
+		shardRange(parameterCount(nn),shard,shardCount,begin,end);
+		uint64_t position = 0;
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				for(u32 i = 0;i < p.size;i++,position++){
+					if(position >= begin && position < end) weights.push_back(p.data[i]);
+				}
+			}
+		}
+	}
+
+	ParameterServer::~ParameterServer(){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+			for(Socket * s : connections){
+				s->shutdown();
+			}
+		}
+		clockChanged.notify_all();
+		if(acceptThread.joinable()){
+			Socket wake; // accept only returns when somebody connects.
+			wake.connect("127.0.0.1",port);
+			acceptThread.join();
+		}
+		for(std::thread& t : connectionThreads){
+			t.join();
+		}
+		for(Socket * s : connections){
+			delete s;
+		}
+	}
+
+	bool ParameterServer::start(){
+		if(!listener.listen(port)) return false;
+		port = listener.localPort();
+		acceptThread = std::thread(&ParameterServer::acceptLoop,this);
+		return true;
+	}
+	u32 ParameterServer::getPort(){
+		return port;
+	}
+
+	void ParameterServer::acceptLoop(){
+		while(true){
+			Socket * s = new Socket();
+			bool ok = listener.accept(*s);
+			std::lock_guard<std::mutex> guard(lock);
+			if(!ok || stopping){
+				delete s;
+				return;
+			}
+			connections.push_back(s);
+			connectionThreads.push_back(std::thread(&ParameterServer::serve,this,s));
+		}
+	}
+
+	u32 ParameterServer::slowestClock(){
+		u32 m = 0xffffffff;
+		for(u32 i = 0;i < workerCount;i++){
+			if(!done[i] && clocks[i] < m) m = clocks[i];
+		}
+		return m;
+	}
+	u32 ParameterServer::minClock(){
+		std::lock_guard<std::mutex> guard(lock);
+		return slowestClock();
+	}
+
+	u32 ParameterServer::maxLead(){
+		std::lock_guard<std::mutex> guard(lock);
+		return largestLead;
+	}
+	bool ParameterServer::hasFailed(u32 worker){
+		std::lock_guard<std::mutex> guard(lock);
+		return worker < workerCount && failed[worker];
+	}
+
+	bool ParameterServer::wait(){
+		std::unique_lock<std::mutex> guard(lock);
+		clockChanged.wait(guard,[this]{
+			for(bool d : done) if(!d) return false;
+			return true;
+		});
+		for(bool f : failed) if(f) return false;
+		return true;
+	}
+
+	void ParameterServer::serve(Socket * s){
+		u32 worker = workerCount;
+		serveMessages(s,worker);
+		// whatever ended the connection, the others must not wait for this worker anymore.
+		std::lock_guard<std::mutex> guard(lock);
+		if(worker < workerCount && !done[worker]){
+			done[worker] = true;
+			failed[worker] = true;
+			clockChanged.notify_all();
+		}
+	}
+
+	void ParameterServer::serveMessages(Socket * s,u32& worker){
+		const u32 size = weights.size();
+		std::vector<float> update;
+		std::vector<u32> indices;
+		std::vector<float> values;
+		Message msg;
+		while(s->receive(&msg,sizeof(msg))){
+			if(msg.worker >= workerCount || (worker < workerCount && msg.worker != worker)) return;
+			worker = msg.worker;
+			if(msg.type == PULL){
+				std::vector<float> copy;
+				{
+					// a worker cannot get more than staleness steps ahead of the slowest one.
+					std::unique_lock<std::mutex> guard(lock);
+					clockChanged.wait(guard,[&]{ return stopping || msg.clock <= (uint64_t)slowestClock() + staleness; });
+					if(stopping) return;
+					const u32 slowest = slowestClock();
+					if(msg.clock > slowest && msg.clock - slowest > largestLead) largestLead = msg.clock - slowest;
+					copy = weights;
+				}
+				if(!s->send(copy.data(),size * sizeof(float))) return;
+			}else if(msg.type == PUSH_DENSE){
+				update.resize(size);
+				if(msg.count != size || !s->receive(update.data(),size * sizeof(float))) return;
+				std::lock_guard<std::mutex> guard(lock);
+				for(u32 i = 0;i < size;i++){
+					weights[i] -= update[i];
+				}
+				if(msg.clock > clocks[msg.worker]) clocks[msg.worker] = msg.clock;
+				clockChanged.notify_all();
+			}else if(msg.type == PUSH_SPARSE){
+				indices.resize(msg.count);
+				values.resize(msg.count);
+				if(!s->receive(indices.data(),msg.count * sizeof(u32)) || !s->receive(values.data(),msg.count * sizeof(float))) return;
+				std::lock_guard<std::mutex> guard(lock);
+				for(u32 i = 0;i < msg.count;i++){
+					if(indices[i] < size) weights[indices[i]] -= values[i];
+				}
+				if(msg.clock > clocks[msg.worker]) clocks[msg.worker] = msg.clock;
+				clockChanged.notify_all();
+			}else if(msg.type == DONE){
+				std::lock_guard<std::mutex> guard(lock);
+				done[msg.worker] = true;
+				clockChanged.notify_all();
+				return;
+			}
+		}
+	}
+
+	ParameterWorker::ParameterWorker(NeuralNetwork& nn,u32 worker,const std::vector<std::string>& servers) : nn(nn){
+		vassert(servers.size() > 0);
+		this->worker = worker;
+		this->servers = servers;
+	}
+	ParameterWorker::~ParameterWorker(){
+		finish();
+	}
+
+	bool ParameterWorker::connect(){
+		auto start = std::chrono::steady_clock::now();
+		for(const std::string& address : servers){
+			Socket * s = new Socket();
+			sockets.push_back(s);
+			while(!s->connect(hostOf(address),portOf(address))){
+				if(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(connectTimeout)) return false;
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			}
+		}
+		return true;
+	}
+
+	void ParameterWorker::finish(){
+		for(u32 i = 0;i < sockets.size();i++){
+			ParameterServer::Message msg = {ParameterServer::DONE,worker,clock,0};
+			sockets[i]->send(&msg,sizeof(msg));
+			delete sockets[i];
+		}
+		sockets.clear();
+	}
+
+	bool ParameterWorker::send(u32 server,const void * data,size_t size){
+		if(sockets[server]->send(data,size)) return true;
+		debug("Lost the connection to parameter server %i",server);
+		return false;
+	}
+	bool ParameterWorker::receive(u32 server,void * data,size_t size){
+		if(sockets[server]->receive(data,size)) return true;
+		debug("Lost the connection to parameter server %i",server);
+		return false;
+	}
+
+	void ParameterWorker::collectBlocks(){
+		blocks.clear();
+		for(Layer * l : nn.layers){
+			for(ParameterBlock& p : l->parameters()){
+				blocks.push_back(p);
+			}
+		}
+	}
+
+	// copies the weights of the network to / from a flat array.
+	void ParameterWorker::copyWeights(float * flat,bool fromNetwork){
+		for(ParameterBlock& p : blocks){
+			if(fromNetwork){
+				memcpy(flat,p.data,p.size * sizeof(float));
+			}else{
+				memcpy(p.data,flat,p.size * sizeof(float));
+			}
+			flat += p.size;
+		}
+	}
+
+	bool ParameterWorker::pull(){
+		if(sockets.size() != servers.size()) return false;
+		collectBlocks();
+		const uint64_t total = ParameterServer::parameterCount(nn);
+		pulled.resize(total);
+		// ask everybody first, the servers answer at the same time.
+		for(u32 s = 0;s < servers.size();s++){
+			ParameterServer::Message msg = {ParameterServer::PULL,worker,clock,0};
+			if(!send(s,&msg,sizeof(msg))) return false;
+		}
+		for(u32 s = 0;s < servers.size();s++){
+			uint64_t begin,end;
+			ParameterServer::shardRange(total,s,servers.size(),begin,end);
+			if(!receive(s,pulled.data() + begin,(end - begin) * sizeof(float))) return false;
+		}
+		copyWeights(pulled.data(),false);
+		return true;
+	}
+
+	EpochStats ParameterWorker::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		vassert(in.size() == out.size());
+		vassert(batchSize > 0);
+		EpochStats stats;
+		stats.samples = in.size();
+		if(in.size() == 0) return stats;
+
+		std::vector<u32> permutation;
+		if(shuffle){
+			permutation = NeuralNetwork::shuffledIndices(in.size());
+		}else{
+			for(u32 i = 0;i < in.size();i++) permutation.push_back(i);
+		}
+		std::vector<float> errors(in.size());
+		std::vector<char> hits(in.size());
+		std::vector<float> updated;
+
+		for(u32 start = 0;start < in.size();start += batchSize){
+			const u32 count = in.size() - start < batchSize ? in.size() - start : batchSize;
+			if(!pull()){
+				stats.ok = false;
+				return stats;
+			}
+
+			// the step of trainParallel, then the difference of the weights is what the servers need.
+			nn.batchGradient(in,out,permutation.data() + start,count,errors.data() + start,hits.data() + start);
+			nn.applyBatchGradient(learningRate / count);
+			updated.resize(pulled.size());
+			copyWeights(updated.data(),true);
+			clock++;
+
+			const uint64_t total = pulled.size();
+			for(u32 s = 0;s < servers.size();s++){
+				uint64_t begin,end;
+				ParameterServer::shardRange(total,s,servers.size(),begin,end);
+				sparseIndices.clear();
+				sparseValues.clear();
+				for(uint64_t i = begin;i < end;i++){
+					pulled[i] -= updated[i]; // pulled now holds the update
+					if(pulled[i] != 0){
+						sparseIndices.push_back(i - begin);
+						sparseValues.push_back(pulled[i]);
+					}
+				}
+				// a sparse value takes 2 floats, only worth it below half of the shard.
+				bool sent;
+				if(sparseIndices.size() * 2 < end - begin){
+					ParameterServer::Message msg = {ParameterServer::PUSH_SPARSE,worker,clock,(u32)sparseIndices.size()};
+					sent = send(s,&msg,sizeof(msg)) && send(s,sparseIndices.data(),sparseIndices.size() * sizeof(u32))
+						&& send(s,sparseValues.data(),sparseValues.size() * sizeof(float));
+				}else{
+					ParameterServer::Message msg = {ParameterServer::PUSH_DENSE,worker,clock,(u32)(end - begin)};
+					sent = send(s,&msg,sizeof(msg)) && send(s,pulled.data() + begin,(end - begin) * sizeof(float));
+				}
+				if(!sent){
+					stats.ok = false;
+					return stats;
+				}
+			}
+		}
+
+		stats.loss = pairwiseSum(errors.data(),in.size()) / in.size();
+		if(nn.computeAccuracy){
+			u32 correct = 0;
+			for(char h : hits) correct += h;
+			stats.accuracy = (float)correct / in.size();
+		}
+		return stats;
+	}
+
+} /* namespace vio */
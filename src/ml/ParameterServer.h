@@ -0,0 +1,146 @@
+/*
+ * ParameterServer.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "NeuralNetwork.h"
+#include "net/Socket.h"
+
+namespace vio {
+
+	/**
+	Asynchronous training with parameter servers, with bounded staleness (stale synchronous parallel).
+
+	The parameters of the network (the ParameterBlocks of every layer, one after the other) are cut in as many
+	contiguous shards as there are servers, every ParameterServer holds one shard.
+	Every ParameterWorker trains on its own part of the dataset, in steps of batchSize samples:
+	it pulls the weights from every server, does the mini batch step of NeuralNetwork::trainParallel (batchGradient)
+	and pushes the difference of the weights to the servers, which subtract it from theirs.
+	Updates with few non zero values are sent as (index,value) pairs.
+
+	The workers do not wait for each other, except that a worker can only be staleness steps ahead of the slowest one,
+	so a slow machine does not stop the others while the weights they use stay reasonably fresh.
+	With staleness = 0, every step waits for every worker.
+
+	A worker whose connection drops without DONE is marked as failed and no longer holds the others back.
+	A worker that loses a server stops its epoch, train then returns ok = false.
+
+	@code
+	// server processes, shard = 0 or 1:
+	ParameterServer ps(nn,shard,2,workerCount,5000 + shard);
+	ps.start();
+	if(!ps.wait()) debug("a worker was lost"); // until every worker is done.
+
+	// worker processes:
+	ParameterWorker pw(nn,workerId,{"10.0.0.1:5000","10.0.0.2:5001"});
+	if(!pw.connect()) vpanic("Unable to reach the servers");
+	for(u32 i = 0;i < 100;i++){
+		if(!pw.train(myInputs,myOutputs,0.01).ok) vpanic("Lost a server");
+	}
+	pw.finish();
+	@endcode
+	 */
+	class ParameterServer{
+	public:
+		// messages between the servers and the workers, sent as 4 u32.
+		enum MessageType : u32{
+			PULL, // answer: the weights of the shard
+			PUSH_DENSE, // followed by the update of the whole shard
+			PUSH_SPARSE, // followed by count (u32 index, float value) pairs
+			DONE // the worker stops, the server does not wait for it anymore
+		};
+		struct Message{
+			u32 type;
+			u32 worker;
+			u32 clock; // number of steps done by the worker
+			u32 count;
+		};
+
+		// range [begin,end) of the parameters held by the shard-th server.
+		static void shardRange(uint64_t parameterCount,u32 shard,u32 shardCount,uint64_t& begin,uint64_t& end);
+		static uint64_t parameterCount(NeuralNetwork& nn);
+	private:
+		std::vector<float> weights;
+		u32 workerCount;
+		u32 port;
+		u32 staleness;
+
+		Socket listener;
+		std::thread acceptThread;
+		std::vector<std::thread> connectionThreads;
+		std::vector<Socket*> connections;
+
+		std::mutex lock; // protects everything below and weights
+		std::condition_variable clockChanged;
+		std::vector<u32> clocks; // steps pushed by every worker
+		std::vector<bool> done; // sent DONE or failed
+		std::vector<bool> failed; // the connection dropped without DONE
+		u32 largestLead = 0; // see maxLead
+		bool stopping = false;
+
+		u32 slowestClock(); // lock must be held
+		void acceptLoop();
+		void serve(Socket * s);
+		void serveMessages(Socket * s,u32& worker); // returns when the connection ends, worker = the one it served
+	public:
+		// Copies the initial weights of the shard from nn. port = 0 picks a free port, see getPort.
+		ParameterServer(NeuralNetwork& nn,u32 shard,u32 shardCount,u32 workerCount,u32 port,u32 staleness = 2);
+		ParameterServer(ParameterServer& p) = delete;
+		ParameterServer& operator=(const ParameterServer& p) = delete;
+		~ParameterServer();
+
+		bool start(); // false if the port cannot be used
+		bool wait(); // until every worker sent DONE or failed, false if one of them failed
+		u32 getPort();
+		u32 minClock();
+		u32 maxLead(); // largest number of steps a served pull was ahead of the slowest worker, at most staleness
+		bool hasFailed(u32 worker);
+	};
+
+	class ParameterWorker{
+	private:
+		NeuralNetwork& nn;
+		u32 worker;
+		std::vector<std::string> servers;
+		std::vector<Socket*> sockets;
+		u32 clock = 0;
+
+		std::vector<ParameterBlock> blocks; // parameters of nn, in the order of the servers
+		std::vector<float> pulled; // weights received by the last pull
+		std::vector<u32> sparseIndices;
+		std::vector<float> sparseValues;
+
+		void collectBlocks();
+		void copyWeights(float * to,bool fromNetwork);
+		bool send(u32 server,const void * data,size_t size);
+		bool receive(u32 server,void * data,size_t size);
+	public:
+		// servers = "host:port" of every server, in shard order.
+		ParameterWorker(NeuralNetwork& nn,u32 worker,const std::vector<std::string>& servers);
+		ParameterWorker(ParameterWorker& p) = delete;
+		ParameterWorker& operator=(const ParameterWorker& p) = delete;
+		~ParameterWorker(); // calls finish
+
+		u32 batchSize = 16;
+		u32 connectTimeout = 30000; // in ms
+		bool shuffle = true; // the samples are shuffled with randomU32, like NeuralNetwork::train
+
+		bool connect();
+		// sets the weights of nn to the ones of the servers, waits if this worker is too far ahead. false if a server is lost.
+		bool pull();
+		// One pass over in / out, the part of the dataset of this worker. The stats are computed with the weights of every step, before the update.
+		// Stops with ok = false as soon as a server is lost.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate = 0.01);
+		void finish(); // tells the servers that this worker is done and disconnects.
+	};
+
+} /* namespace vio */
@@ -0,0 +1,279 @@
+/*
+ * PipelineTrainer.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "PipelineTrainer.h"
+#include "Checkpointer.h"
+#include "math/math.h"
+
+namespace vio {
+
+	PipelineTrainer::PipelineTrainer(NeuralNetwork& nn,u32 stageCount,Schedule schedule) : nn(nn){
+		this->schedule = schedule;
+		const u32 L = nn.layers.size();
+		vassert(L > 0);
+		if(stageCount > L) stageCount = L;
+		if(stageCount == 0) stageCount = 1;
+
+		// Cut the layers in stages of roughly the same cost. The cost of a layer is approximated by inputSize * outputSize.
+		std::vector<double> cost;
+		double total = 0;
+		for(Layer * l : nn.layers){
+			cost.push_back((double)l->inputSize() * l->outputSize() + 1);
+			total += cost.back();
+		}
+		stageBounds.push_back(0);
+		double acc = 0;
+		for(u32 j = 0;j < L;j++){
+			acc += cost[j];
+			const u32 stagesLeft = stageCount - stageBounds.size(); // stages still to close after this one
+			const u32 layersLeft = L - j - 1;
+			if(stageBounds.size() < stageCount && layersLeft >= stagesLeft &&
+				(acc >= total * stageBounds.size() / stageCount || layersLeft == stagesLeft)){
+				stageBounds.push_back(j+1);
+			}
+		}
+		if(stageBounds.back() != L) stageBounds.push_back(L);
+		vassert(stageBounds.size() == stageCount + 1);
+
+		firstLearnable = L;
+		for(u32 j = 0;j < L;j++){
+			Layer * l = nn.layers[j];
+			if(l->isLearnable()){
+				if(firstLearnable == L) firstLearnable = j;
+				gradients.push_back({Matrix(l->inputSize(),l->outputSize()),Vector(l->isBias() ? l->outputSize() : 0)});
+				gradients.back().m.fill(0);
+				gradients.back().v.fill(0);
+			}else{
+				gradients.push_back({Matrix(0,0),Vector(0)});
+			}
+		}
+
+		boundaryGradient.resize(stageCount);
+		for(u32 s = 0;s < stageCount;s++){
+			inbox.push_back(new BlockingQueue<Message>());
+		}
+		for(u32 s = 0;s < stageCount;s++){
+			threads.push_back(std::thread(&PipelineTrainer::stageLoop,this,s));
+		}
+	}
+
+	PipelineTrainer::~PipelineTrainer(){
+		for(BlockingQueue<Message>* q : inbox){
+			q->push({Message::STOP,0});
+		}
+		for(std::thread& t : threads){
+			t.join();
+		}
+		for(BlockingQueue<Message>* q : inbox){
+			delete q;
+		}
+	}
+
+	u32 PipelineTrainer::stageCount(){
+		return stageBounds.size() - 1;
+	}
+	u32 PipelineTrainer::stageStart(u32 stage){
+		return stageBounds[stage];
+	}
+	u32 PipelineTrainer::stageEnd(u32 stage){
+		return stageBounds[stage+1];
+	}
+
+	// The order in which a stage processes the micro batches of a step.
+	std::vector<PipelineTrainer::Operation> PipelineTrainer::operations(u32 stage){
+		std::vector<Operation> ops;
+		const u32 M = stepMicroBatches;
+		if(schedule == GPIPE){
+			for(u32 m = 0;m < M;m++) ops.push_back({true,m});
+			for(u32 m = 0;m < M;m++) ops.push_back({false,m});
+			return ops;
+		}
+		// 1F1B: fill the pipeline, then alternate, then drain.
+		u32 warmup = stageCount() - 1 - stage;
+		if(warmup > M) warmup = M;
+		for(u32 m = 0;m < warmup;m++) ops.push_back({true,m});
+		for(u32 i = 0;i + warmup < M;i++){
+			ops.push_back({true,warmup + i});
+			ops.push_back({false,i});
+		}
+		for(u32 m = M - warmup;m < M;m++) ops.push_back({false,m});
+		return ops;
+	}
+
+	void PipelineTrainer::stageLoop(u32 stage){
+		Message msg;
+		while(inbox[stage]->pop(msg)){
+			if(msg.type == Message::STOP) return;
+			if(msg.type == Message::STEP) runStep(stage);
+		}
+	}
+
+	void PipelineTrainer::runStep(u32 stage){
+		const bool first = stage == 0;
+		const bool last = stage == stageCount() - 1;
+		std::vector<bool> forwardArrived(stepMicroBatches,false);
+		std::vector<bool> backwardArrived(stepMicroBatches,false);
+
+		for(const Operation& op : operations(stage)){
+			// wait for the input of the operation. The messages can arrive in any order.
+			while(!(op.forward ? (first || forwardArrived[op.microBatch]) : (last || backwardArrived[op.microBatch]))){
+				Message msg = {Message::STOP,0}; // always replaced, the inboxes are never closed
+				inbox[stage]->pop(msg);
+				if(msg.type == Message::FORWARD) forwardArrived[msg.microBatch] = true;
+				if(msg.type == Message::BACKWARD) backwardArrived[msg.microBatch] = true;
+			}
+			if(op.forward){
+				forward(stage,op.microBatch);
+				if(!last) inbox[stage+1]->push({Message::FORWARD,op.microBatch});
+			}else{
+				backward(stage,op.microBatch);
+				if(!first) inbox[stage-1]->push({Message::BACKWARD,op.microBatch});
+			}
+		}
+		applyGradients(stage);
+
+		{
+			std::lock_guard<std::mutex> guard(doneLock);
+			stagesDone++;
+		}
+		doneCond.notify_all();
+	}
+
+	void PipelineTrainer::forward(u32 stage,u32 microBatch){
+		const u32 begin = microBatch * microBatchSize;
+		const u32 end = begin + microBatchSize < stepSampleCount ? begin + microBatchSize : stepSampleCount;
+		for(u32 i = begin;i < end;i++){
+			std::vector<Vector>& acts = activations[i];
+			if(stage == 0){
+				Vector& input = (*stepIn)[stepSamples[i]];
+				acts[0] = Vector(input.size(),input.raw()); // a view, no copy.
+			}
+			for(u32 j = stageStart(stage);j < stageEnd(stage);j++){
+				acts[j+1] = nn.layers[j]->apply(acts[j]);
+			}
+		}
+	}
+
+	void PipelineTrainer::backward(u32 stage,u32 microBatch){
+		const u32 begin = microBatch * microBatchSize;
+		const u32 end = begin + microBatchSize < stepSampleCount ? begin + microBatchSize : stepSampleCount;
+		const bool last = stage == stageCount() - 1;
+		const u32 L = nn.layers.size();
+
+		for(u32 i = begin;i < end;i++){
+			std::vector<Vector>& acts = activations[i];
+			Vector v2(0);
+			if(last){
+				Vector& expected = (*stepOut)[stepSamples[i]];
+				stepLoss[i] = nn.errorFunction(acts[L],expected);
+				if(nn.computeAccuracy && NeuralNetwork::argmax(acts[L]) == NeuralNetwork::argmax(expected)){
+					stepCorrect++;
+				}
+				v2 = nn.errorFunctionGradient(acts[L],expected);
+			}else{
+				v2 = std::move(boundaryGradient[stage+1][i]);
+			}
+
+			// a zero (or empty) gradient has nothing to teach, like in NeuralNetwork::train
+			if(v2.size() != 0 && v2.normSquared() != 0.00){
+				for(i32 j = stageEnd(stage) - 1;j >= (i32)stageStart(stage) && j >= (i32)firstLearnable;j--){
+					Vector next(0);
+					if(j > (i32)firstLearnable){
+						next = nn.layers[j]->applyGradient(v2,acts[j],acts[j-1]);
+					}
+					if(nn.layers[j]->isLearnable()){
+						Vector::addCrossNorm(gradients[j].m,v2,acts[j]); // J/dx * dx/dm = J/dm
+						if(nn.layers[j]->isBias()){
+							gradients[j].v += v2;
+						}
+					}
+					v2 = std::move(next);
+				}
+			}else{
+				v2 = Vector(0);
+			}
+			if(stage > 0){
+				boundaryGradient[stage][i] = std::move(v2);
+			}
+
+			// release the activations written by this stage, nobody needs them anymore.
+			for(u32 j = stageStart(stage) + 1;j <= stageEnd(stage);j++){
+				acts[j] = Vector(0);
+			}
+			if(stage == 0) acts[0] = Vector(0);
+		}
+	}
+
+	void PipelineTrainer::applyGradients(u32 stage){
+		const float scale = stepRate / stepSampleCount;
+		for(u32 j = stageStart(stage);j < stageEnd(stage);j++){
+			Layer * l = nn.layers[j];
+			if(!l->isLearnable()) continue;
+			gradients[j].m *= scale;
+			l->updateMatrix(gradients[j].m);
+			gradients[j].m.fill(0);
+			if(l->isBias()){
+				gradients[j].v *= scale;
+				l->updateBias(gradients[j].v);
+				gradients[j].v.fill(0);
+			}
+		}
+	}
+
+	EpochStats PipelineTrainer::train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate){
+		vassert(in.size() == out.size());
+		vassert(microBatchSize > 0 && microBatchesPerStep > 0);
+		EpochStats stats;
+		stats.samples = in.size();
+		if(in.size() == 0) return stats;
+
+		// shuffle in and out using a permutation.
+		std::vector<u32> permutation = NeuralNetwork::shuffledIndices(in.size());
+
+		const u32 L = nn.layers.size();
+		const u32 stepSize = microBatchSize * microBatchesPerStep;
+		std::vector<float> lossValues(in.size());
+		if(activations.size() < stepSize) activations.resize(stepSize);
+		for(std::vector<Vector>& acts : activations){
+			if(acts.size() != L + 1) acts = std::vector<Vector>(L + 1,Vector(0));
+		}
+		for(std::vector<Vector>& g : boundaryGradient){
+			if(g.size() < stepSize) g.resize(stepSize,Vector(0));
+		}
+
+		stepIn = &in;
+		stepOut = &out;
+		stepRate = learningRate;
+		stepCorrect = 0;
+		for(u32 start = 0;start < in.size();start += stepSize){
+			stepSamples = &permutation[start];
+			stepSampleCount = in.size() - start < stepSize ? in.size() - start : stepSize;
+			stepMicroBatches = (stepSampleCount + microBatchSize - 1) / microBatchSize;
+			stepLoss = &lossValues[start];
+
+			stagesDone = 0;
+			// Last stage first: a stage must get its STEP before the first FORWARD of the stage before it.
+			for(u32 s = stageCount();s-- > 0;){
+				inbox[s]->push({Message::STEP,0});
+			}
+			std::unique_lock<std::mutex> guard(doneLock);
+			doneCond.wait(guard,[this]{ return stagesDone == stageCount(); });
+			guard.unlock();
+
+			if(nn.checkpointer != 0){
+				nn.checkpointer->step(nn,stepSampleCount);
+			}
+		}
+
+		stats.loss = pairwiseSum(lossValues.data(),in.size()) / in.size();
+		if(nn.computeAccuracy){
+			stats.accuracy = (float)stepCorrect / in.size();
+		}
+		return stats;
+	}
+
+} /* namespace vio */
@@ -0,0 +1,113 @@
+/*
+ * PipelineTrainer.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "NeuralNetwork.h"
+#include "datas/BlockingQueue.h"
+
+namespace vio {
+
+	/**
+	Pipeline parallel training (see the GPipe paper: https://arxiv.org/abs/1811.06965).
+
+	The layers of the network are split in contiguous stages with roughly the same amount of work, every stage runs on its own thread.
+	A training step takes microBatchSize * microBatchesPerStep samples, cut into micro batches. A micro batch goes through the stages
+	for the forward pass, and back for the backward pass, the stages are linked by message queues.
+	While stage 1 does the forward pass of micro batch 2, stage 0 can start micro batch 3, so every core is busy even
+	if every layer is too small to be split on its own.
+
+	The gradients are averaged over the step and the layers are updated at the end of it, like mini batch gradient descent.
+	The result does not depend on the number of stages or on the schedule.
+
+	Two schedules are available:
+	- GPIPE: all the forward passes of the step, then all the backward passes.
+	- ONE_F_ONE_B: once the pipeline is full, every stage alternates between one forward and one backward pass.
+	  Same speed, but less micro batches are alive at the same time, so it needs less memory for the activations.
+
+	@code
+	PipelineTrainer pt(nn,4); // 4 stages
+	pt.microBatchSize = 16;
+	for(u32 i = 0;i < 100;i++){
+		EpochStats stats = pt.train(trainingInputs,trainingOutputs,0.01);
+	}
+	@endcode
+	 */
+	class PipelineTrainer{
+	public:
+		enum Schedule{
+			GPIPE,
+			ONE_F_ONE_B
+		};
+	private:
+		struct Message{
+			enum Type{ STEP, FORWARD, BACKWARD, STOP } type;
+			u32 microBatch;
+		};
+		struct Operation{
+			bool forward;
+			u32 microBatch;
+		};
+
+		NeuralNetwork& nn;
+		Schedule schedule;
+		std::vector<u32> stageBounds; // stage s has the layers [stageBounds[s],stageBounds[s+1])
+		std::vector<std::thread> threads;
+		std::vector<BlockingQueue<Message>*> inbox; // one per stage
+
+		// Gradient sums of the current step, one per layer (empty for non learnable layers).
+		std::vector<UpdatePair> gradients;
+		u32 firstLearnable; // nothing needs to be propagated below this layer.
+
+		// State of the current step, written by train before the STEP messages.
+		std::vector<Vector>* stepIn = 0;
+		std::vector<Vector>* stepOut = 0;
+		const u32 * stepSamples = 0; // indices of the samples of the step, in micro batch order.
+		u32 stepSampleCount = 0;
+		u32 stepMicroBatches = 0;
+		float stepRate = 0;
+		float * stepLoss = 0; // error of every sample of the step
+		u32 stepCorrect = 0;
+
+		// activations[i][j] = input of layer j for the i-th sample of the step. Every stage only touches its own layers.
+		std::vector<std::vector<Vector>> activations;
+		// boundaryGradient[s][i] = gradient at the input of stage s for the i-th sample, written by stage s and read by stage s-1.
+		std::vector<std::vector<Vector>> boundaryGradient;
+
+		std::mutex doneLock;
+		std::condition_variable doneCond;
+		u32 stagesDone = 0;
+
+		void stageLoop(u32 stage);
+		void runStep(u32 stage);
+		std::vector<Operation> operations(u32 stage);
+		void forward(u32 stage,u32 microBatch);
+		void backward(u32 stage,u32 microBatch);
+		void applyGradients(u32 stage);
+	public:
+		// The stages are computed from the layers present when the trainer is created. stageCount is at most the number of layers.
+		PipelineTrainer(NeuralNetwork& nn,u32 stageCount,Schedule schedule = ONE_F_ONE_B);
+		PipelineTrainer(PipelineTrainer& p) = delete;
+		PipelineTrainer& operator=(const PipelineTrainer& p) = delete;
+		~PipelineTrainer();
+
+		u32 microBatchSize = 8;
+		u32 microBatchesPerStep = 8; // should be at least the number of stages to fill the pipeline.
+
+		u32 stageCount();
+		u32 stageStart(u32 stage); // first layer of the stage
+		u32 stageEnd(u32 stage); // one past the last layer of the stage
+
+		// One pass over the dataset, shuffled like NeuralNetwork::train.
+		EpochStats train(std::vector<Vector>& in,std::vector<Vector>& out,float learningRate = 0.01);
+	};
+
+} /* namespace vio */
@@ -0,0 +1,185 @@
+/*
+ * Profiler.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "Profiler.h"
+
+#include <cstdio>
+
+namespace vio {
+
+	double Profiler::Stats::gflops() const{
+		if(nanoseconds == 0) return 0;
+		return flops / nanoseconds; // flop per ns = GFLOP per s
+	}
+
+	static const char * layerTypeName(u32 type){
+		switch(type){
+		case LAYER_DENSE: return "dense";
+		case LAYER_CONV: return "conv";
+		case LAYER_BATCHNORM: return "batchnorm";
+		case LAYER_SOFTMAX: return "softmax";
+		default: return "layer";
+		}
+	}
+
+	static std::atomic<uint64_t> nextProfilerId(1);
+
+	Profiler::Profiler() : id(nextProfilerId.fetch_add(1)){}
+
+	Profiler::Shard& Profiler::shard(){
+		// the shard used last by this thread, the profiler lock is only taken when it changes.
+		struct Cache{
+			uint64_t profiler = 0;
+			Shard * shard = 0;
+		};
+		static thread_local Cache cache;
+		if(cache.profiler == id) return *cache.shard;
+
+		std::lock_guard<std::mutex> guard(lock);
+		const std::thread::id self = std::this_thread::get_id();
+		Shard * found = 0;
+		for(std::unique_ptr<Shard>& s : shards){
+			if(s->thread == self) found = s.get();
+		}
+		if(found == 0){
+			shards.emplace_back(new Shard());
+			found = shards.back().get();
+			found->thread = self;
+		}
+		cache.profiler = id;
+		cache.shard = found;
+		return *found;
+	}
+
+	void Profiler::record(u32 index,Layer * layer,Phase phase,uint64_t nanoseconds,uint64_t bytes){
+		double flops = 0;
+		if(phase == FORWARD) flops = layer->applyFlops();
+		if(phase == BACKWARD) flops = layer->gradientFlops();
+		if(phase == UPDATE) flops = layer->updateFlops();
+
+		Shard& sh = shard();
+		std::lock_guard<std::mutex> guard(sh.lock);
+		if(index >= sh.layers.size()) sh.layers.resize(index + 1);
+		LayerStats& l = sh.layers[index];
+		if(l.name.empty()){
+			LayerDescriptor d = layer->describe();
+			l.name = std::string(layerTypeName(d.type)) + " " + std::to_string(layer->inputSize()) + "x" + std::to_string(layer->outputSize());
+		}
+		Stats& s = l.phases[phase];
+		s.calls++;
+		s.nanoseconds += nanoseconds;
+		s.flops += flops;
+		s.bytes += bytes;
+	}
+
+	std::vector<Profiler::LayerStats> Profiler::merged(){
+		std::lock_guard<std::mutex> guard(lock);
+		std::vector<LayerStats> layers;
+		for(std::unique_ptr<Shard>& sh : shards){
+			std::lock_guard<std::mutex> shardGuard(sh->lock);
+			if(sh->layers.size() > layers.size()) layers.resize(sh->layers.size());
+			for(u32 i = 0;i < sh->layers.size();i++){
+				const LayerStats& l = sh->layers[i];
+				if(layers[i].name.empty()) layers[i].name = l.name;
+				for(u32 p = 0;p < PHASE_COUNT;p++){
+					Stats& t = layers[i].phases[p];
+					t.calls += l.phases[p].calls;
+					t.nanoseconds += l.phases[p].nanoseconds;
+					t.flops += l.phases[p].flops;
+					t.bytes += l.phases[p].bytes;
+				}
+			}
+		}
+		return layers;
+	}
+
+	void Profiler::reset(){
+		std::lock_guard<std::mutex> guard(lock);
+		for(std::unique_ptr<Shard>& sh : shards){
+			std::lock_guard<std::mutex> shardGuard(sh->lock);
+			sh->layers.clear();
+		}
+	}
+
+	u32 Profiler::layerCount(){
+		return merged().size();
+	}
+	std::string Profiler::layerName(u32 index){
+		std::vector<LayerStats> layers = merged();
+		return index < layers.size() ? layers[index].name : "";
+	}
+	Profiler::Stats Profiler::get(u32 index,Phase phase){
+		std::vector<LayerStats> layers = merged();
+		return index < layers.size() ? layers[index].phases[phase] : Stats();
+	}
+	Profiler::Stats Profiler::total(Phase phase){
+		Stats t;
+		for(const LayerStats& l : merged()){
+			const Stats& s = l.phases[phase];
+			t.calls += s.calls;
+			t.nanoseconds += s.nanoseconds;
+			t.flops += s.flops;
+			t.bytes += s.bytes;
+		}
+		return t;
+	}
+
+	const char * Profiler::phaseName(Phase phase){
+		switch(phase){
+		case FORWARD: return "forward";
+		case BACKWARD: return "backward";
+		case UPDATE: return "update";
+		default: return "?";
+		}
+	}
+
+	std::string Profiler::table(){
+		std::vector<LayerStats> layers = merged();
+		uint64_t totalNs = 0;
+		for(const LayerStats& l : layers){
+			for(u32 p = 0;p < PHASE_COUNT;p++) totalNs += l.phases[p].nanoseconds;
+		}
+
+		std::string r;
+		char line[256];
+		snprintf(line,sizeof(line),"%-5s %-20s %-9s %10s %12s %10s %7s %10s %12s\n",
+			"layer","name","phase","calls","total ms","avg us","%","GFLOP/s","alloc KB");
+		r += line;
+		for(u32 i = 0;i < layers.size();i++){
+			for(u32 p = 0;p < PHASE_COUNT;p++){
+				const Stats& s = layers[i].phases[p];
+				if(s.calls == 0) continue;
+				snprintf(line,sizeof(line),"%-5u %-20s %-9s %10llu %12.3f %10.3f %7.2f %10.3f %12.1f\n",
+					i,layers[i].name.c_str(),phaseName((Phase)p),(unsigned long long)s.calls,
+					s.nanoseconds / 1e6,s.nanoseconds / 1e3 / s.calls,
+					totalNs == 0 ? 0 : 100.0 * s.nanoseconds / totalNs,s.gflops(),s.bytes / 1024.0);
+				r += line;
+			}
+		}
+		return r;
+	}
+
+	std::string Profiler::json(){
+		std::vector<LayerStats> layers = merged();
+		std::string r = "{\"layers\":[";
+		char buffer[256];
+		for(u32 i = 0;i < layers.size();i++){
+			if(i > 0) r += ",";
+			r += "{\"index\":" + std::to_string(i) + ",\"name\":\"" + layers[i].name + "\"";
+			for(u32 p = 0;p < PHASE_COUNT;p++){
+				const Stats& s = layers[i].phases[p];
+				snprintf(buffer,sizeof(buffer),",\"%s\":{\"calls\":%llu,\"ns\":%llu,\"flops\":%.0f,\"gflops\":%.6g,\"bytes\":%llu}",
+					phaseName((Phase)p),(unsigned long long)s.calls,(unsigned long long)s.nanoseconds,s.flops,s.gflops(),(unsigned long long)s.bytes);
+				r += buffer;
+			}
+			r += "}";
+		}
+		r += "]}";
+		return r;
+	}
+
+} /* namespace vio */
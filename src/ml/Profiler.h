@@ -0,0 +1,116 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include "Layer.h"
+
+namespace vio {
+
+	/**
+	Measures where the time of a NeuralNetwork goes, per layer and per phase:
+	- FORWARD: apply / applyInto (train, loss, apply)
+	- BACKWARD: applyGradient
+	- UPDATE: computing the weight gradient and updateMatrix / updateBias
+
+	For every layer and phase, it records the number of calls, the time spent, the floating point operations
+	(estimated by Layer::applyFlops and friends) and the bytes allocated by Vector and Matrix during the calls.
+	Calls from several threads (NeuralNetwork::loss) are added together, so the time is the sum over the threads.
+	Every thread records in its own shard, the shards are merged by the functions reading the results.
+
+	The profiler is off by default and costs a null pointer check per layer call when it is.
+	Vector and Matrix only count their allocations while a Scope is measuring (see countAllocation).
+	@code
+	Profiler profiler;
+	nn.profiler = &profiler;
+	nn.train(trainingInputs,trainingOutputs);
+	nn.profiler = 0;
+	printf("%s",profiler.table().c_str());
+	File("profile.json").write(profiler.json());
+	@endcode
+	 */
+	class Profiler{
+	public:
+		enum Phase{
+			FORWARD,
+			BACKWARD,
+			UPDATE
+		};
+		static constexpr u32 PHASE_COUNT = 3;
+
+		struct Stats{
+			uint64_t calls = 0;
+			uint64_t nanoseconds = 0;
+			double flops = 0;
+			uint64_t bytes = 0; // allocated by Vector and Matrix
+			double gflops() const; // achieved GFLOP/s
+		};
+
+		// Measures the code between its creation and the end of its scope. Does nothing if profiler is null.
+		class Scope{
+		private:
+			Profiler * profiler;
+			u32 index;
+			Layer * layer;
+			Phase phase;
+			std::chrono::steady_clock::time_point start;
+			uint64_t bytes;
+		public:
+			Scope(Profiler * profiler,u32 index,Layer * layer,Phase phase) : profiler(profiler),index(index),layer(layer),phase(phase){
+				if(profiler == 0) return;
+				allocationTracking.fetch_add(1,std::memory_order_relaxed);
+				bytes = threadAllocations.bytes;
+				start = std::chrono::steady_clock::now();
+			}
+			~Scope(){
+				if(profiler == 0) return;
+				auto end = std::chrono::steady_clock::now();
+				uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+				profiler->record(index,layer,phase,ns,threadAllocations.bytes - bytes);
+				allocationTracking.fetch_sub(1,std::memory_order_relaxed);
+			}
+		};
+	private:
+		struct LayerStats{
+			std::string name;
+			Stats phases[PHASE_COUNT];
+		};
+		// The stats recorded by one thread. Its lock is only contended while the results are read.
+		struct Shard{
+			std::thread::id thread;
+			std::mutex lock;
+			std::vector<LayerStats> layers; // by index in the network
+		};
+		const uint64_t id; // never reused, identifies the profiler in the cache of the threads
+		std::mutex lock; // protects shards
+		std::vector<std::unique_ptr<Shard>> shards; // never removed before the destruction, reset clears them
+
+		Shard& shard(); // the one of the calling thread
+		void record(u32 index,Layer * layer,Phase phase,uint64_t nanoseconds,uint64_t bytes);
+		std::vector<LayerStats> merged(); // sum of the shards
+	public:
+		Profiler();
+		void reset();
+
+		u32 layerCount();
+		std::string layerName(u32 index); // type and shape, like "dense 784x128"
+		Stats get(u32 index,Phase phase);
+		Stats total(Phase phase); // over all the layers
+
+		static const char * phaseName(Phase phase);
+
+		std::string table(); // human readable, one line per layer and phase
+		std::string json();
+	};
+
+} /* namespace vio */
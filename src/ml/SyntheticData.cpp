@@ -0,0 +1,175 @@
+/*
+ * SyntheticData.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "SyntheticData.h"
+#include <cstring>
+#include <cmath>
+#include "math/math.h"
+
+namespace vio {
+
+	PolynomialTask::PolynomialTask(u32 inputSize,u32 outputSize,u32 degree,uint64_t seed){
+		vassert(degree >= 1);
+		this->inS = inputSize;
+		this->outS = outputSize;
+		this->degree = degree;
+		RandomStream rng(seed);
+		coefficients.resize((size_t)outputSize * inputSize * degree);
+		bias.resize(outputSize);
+		rng.fillUniform(coefficients.data(),coefficients.size(),-1,1);
+		rng.fillUniform(bias.data(),bias.size(),-1,1);
+	}
+	void PolynomialTask::generate(RandomStream& rng,float * in,float * out){
+		rng.fillUniform(in,inS,-range,range);
+		const float * c = coefficients.data();
+		for(u32 j = 0;j < outS;j++){
+			float r = bias[j];
+			for(u32 i = 0;i < inS;i++){
+				float p = in[i];
+				for(u32 k = 0;k < degree;k++){
+					r += *c++ * p;
+					p *= in[i];
+				}
+			}
+			out[j] = r;
+		}
+	}
+
+	NoiseTextureTask::NoiseTextureTask(u32 side,u32 classes,u32 octaves,double baseStep){
+		vassert(classes >= 1);
+		this->side = side;
+		this->classes = classes;
+		this->octaves = octaves;
+		this->baseStep = baseStep;
+	}
+	void NoiseTextureTask::generate(RandomStream& rng,float * in,float * out){
+		const u32 label = rng.nextU32(classes - 1);
+		const double origin[3] = {rng.nextFloat() * 1000.0,rng.nextFloat() * 1000.0,rng.nextFloat() * 1000.0};
+		const double s = baseStep * (label + 1);
+		const double step[3] = {s,s,0};
+		const u32 dims[3] = {side,side,1};
+		perlinGrid(origin,step,dims,octaves,in);
+		for(u32 i = 0;i < classes;i++) out[i] = i == label ? 1 : 0;
+	}
+
+	ShapeTask::ShapeTask(u32 side){
+		this->side = side;
+	}
+	void ShapeTask::generate(RandomStream& rng,float * in,float * out){
+		const u32 label = rng.nextU32(2);
+		const float cx = (0.25f + 0.5f * rng.nextFloat()) * side;
+		const float cy = (0.25f + 0.5f * rng.nextFloat()) * side;
+		const float r = (0.15f + 0.2f * rng.nextFloat()) * side;
+		rng.fillGaussian(in,(size_t)side * side,0,noise);
+		for(u32 y = 0;y < side;y++){
+			const float dy = y + 0.5f - cy;
+			for(u32 x = 0;x < side;x++){
+				const float dx = x + 0.5f - cx;
+				bool inside;
+				if(label == 0){ // disk
+					inside = dx * dx + dy * dy <= r * r;
+				}else if(label == 1){ // square of about the same area
+					inside = std::abs(dx) <= 0.8f * r && std::abs(dy) <= 0.8f * r;
+				}else{ // triangle pointing up
+					inside = dy >= -r && dy <= r && std::abs(dx) <= (dy + r) / 2;
+				}
+				if(inside) in[y * side + x] += 1;
+			}
+		}
+		for(u32 i = 0;i < 3;i++) out[i] = i == label ? 1 : 0;
+	}
+
+	SyntheticBatch::SyntheticBatch(u32 count,u32 inputSize,u32 outputSize){
+		inputData.resize((size_t)count * inputSize);
+		outputData.resize((size_t)count * outputSize);
+		// reserved so that the views are built in place and never copied
+		inputs.reserve(count);
+		outputs.reserve(count);
+		for(u32 i = 0;i < count;i++){
+			inputs.emplace_back(inputSize,inputData.data() + (size_t)i * inputSize);
+			outputs.emplace_back(outputSize,outputData.data() + (size_t)i * outputSize);
+		}
+	}
+
+	SyntheticStream::SyntheticStream(SyntheticTask& task,u32 batchSize,uint64_t seed,u32 threads,u32 prefetch) : task(task){
+		vassert(batchSize > 0 && threads > 0);
+		this->batchSize = batchSize;
+		this->seed = seed;
+		// one more slot for the batch held by the reader
+		for(u32 i = 0;i < max(prefetch,1u) + 1;i++){
+			slots.emplace_back(new SyntheticBatch(batchSize,task.inputSize(),task.outputSize()));
+		}
+		done.resize(slots.size(),0);
+		for(u32 i = 0;i < threads;i++){
+			workers.emplace_back(&SyntheticStream::workerLoop,this);
+		}
+	}
+	SyntheticStream::~SyntheticStream(){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		cond.notify_all();
+		for(std::thread& t : workers) t.join();
+	}
+
+	void SyntheticStream::generate(uint64_t index,SyntheticBatch& b){
+		const u32 inS = task.inputSize(),outS = task.outputSize();
+		b.index = index;
+		for(u32 i = 0;i < b.size();i++){
+			// one stream per sample
+			RandomStream rng(seed,index * batchSize + i);
+			task.generate(rng,b.inputData.data() + (size_t)i * inS,b.outputData.data() + (size_t)i * outS);
+		}
+	}
+
+	void SyntheticStream::workerLoop(){
+		const uint64_t S = slots.size();
+		std::unique_lock<std::mutex> guard(lock);
+		while(true){
+			// the slot of batch n was used by batch n - S, which must have been released by the reader.
+			cond.wait(guard,[&]{
+				const uint64_t held = nextToRead > 0 ? nextToRead - 1 : 0;
+				return stopping || nextToGenerate < held + S;
+			});
+			if(stopping) return;
+			const uint64_t n = nextToGenerate++;
+			guard.unlock();
+			generate(n,*slots[n % S]);
+			guard.lock();
+			done[n % S] = n + 1;
+			cond.notify_all();
+		}
+	}
+
+	SyntheticBatch& SyntheticStream::next(){
+		std::unique_lock<std::mutex> guard(lock);
+		const uint64_t n = nextToRead++; // releases the slot of the previous batch
+		cond.notify_all();
+		const uint64_t slot = n % slots.size();
+		cond.wait(guard,[&]{ return done[slot] == n + 1; });
+		return *slots[slot];
+	}
+
+	EpochStats SyntheticStream::train(NeuralNetwork& nn,u32 batches,float rate){
+		EpochStats stats;
+		double loss = 0,accuracy = 0;
+		for(u32 i = 0;i < batches;i++){
+			SyntheticBatch& b = next();
+			EpochStats s = nn.train(b.inputs,b.outputs,rate);
+			loss += s.loss;
+			accuracy += s.accuracy;
+			stats.samples += s.samples;
+		}
+		if(batches > 0){
+			stats.loss = loss / batches;
+			if(nn.computeAccuracy) stats.accuracy = accuracy / batches;
+		}
+		return stats;
+	}
+
+} /* namespace vio */
@@ -0,0 +1,139 @@
+/*
+ * SyntheticData.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "math/Vector.h"
+#include "math/RandomStream.h"
+#include "NeuralNetwork.h"
+#include "utils/utils.h"
+
+namespace vio {
+
+	/**
+	Labelled datasets generated on the fly, for benchmarks and pretraining: no files, no std::vector<Vector> to build.
+
+	A SyntheticTask describes how one sample is made. A SyntheticStream runs it on background threads and writes
+	whole batches into contiguous buffers, a few batches ahead of the training. The stream is infinite
+	and reproducible: sample n only depends on the seed and n, whatever the number of threads.
+	@code
+	ShapeTask shapes(16);
+	SyntheticStream stream(shapes,64,42);
+	for(u32 i = 0;i < 1000;i++){
+		SyntheticBatch& b = stream.next();
+		nn.train(b.inputs,b.outputs,0.01);
+	}
+	@endcode
+	 */
+
+	class SyntheticTask{
+	public:
+		virtual ~SyntheticTask(){}
+		virtual u32 inputSize() = 0;
+		virtual u32 outputSize() = 0;
+		// Writes one sample. Called from several threads at once: only rng may be used as a source of randomness.
+		virtual void generate(RandomStream& rng,float * in,float * out) = 0;
+	};
+
+	// Inputs uniform in [-range,range], outputs polynomials of the inputs (without cross terms):
+	// out[j] = bias[j] + sum over i and k in [1,degree] of coefficients[(j * inputSize + i) * degree + k - 1] * in[i]^k.
+	// The coefficients and the bias are drawn in [-1,1] from the seed and can be replaced.
+	class PolynomialTask : public SyntheticTask{
+	private:
+		u32 inS,outS,degree;
+	public:
+		float range = 1;
+		std::vector<float> coefficients;
+		std::vector<float> bias;
+
+		PolynomialTask(u32 inputSize,u32 outputSize,u32 degree = 1,uint64_t seed = 0);
+		u32 inputSize(){ return inS; }
+		u32 outputSize(){ return outS; }
+		void generate(RandomStream& rng,float * in,float * out);
+	};
+
+	// side x side images of perlin noise (see perlinGrid) at a random place. The label is the frequency of the noise,
+	// one of classes frequencies from baseStep to classes * baseStep, one hot.
+	class NoiseTextureTask : public SyntheticTask{
+	private:
+		u32 side,classes;
+		u32 octaves;
+		double baseStep;
+	public:
+		NoiseTextureTask(u32 side,u32 classes = 4,u32 octaves = 2,double baseStep = 0.05);
+		u32 inputSize(){ return side * side; }
+		u32 outputSize(){ return classes; }
+		void generate(RandomStream& rng,float * in,float * out);
+	};
+
+	// side x side images of a filled disk, square or triangle of random size and position on a noisy background.
+	// The label is the shape, one hot (3 classes).
+	class ShapeTask : public SyntheticTask{
+	private:
+		u32 side;
+	public:
+		float noise = 0.1; // deviation of the gaussian noise added to every pixel
+		ShapeTask(u32 side);
+		u32 inputSize(){ return side * side; }
+		u32 outputSize(){ return 3; }
+		void generate(RandomStream& rng,float * in,float * out);
+	};
+
+	// count samples stored contiguously, sample after sample. inputs and outputs are views over the storage,
+	// they can be given to NeuralNetwork::train directly.
+	struct SyntheticBatch{
+		uint64_t index = 0; // number of the batch in the stream
+		std::vector<float> inputData; // count * inputSize
+		std::vector<float> outputData; // count * outputSize
+		std::vector<Vector> inputs;
+		std::vector<Vector> outputs;
+
+		SyntheticBatch(u32 count,u32 inputSize,u32 outputSize);
+		SyntheticBatch(const SyntheticBatch& b) = delete;
+		SyntheticBatch& operator=(const SyntheticBatch& b) = delete;
+		u32 size() const{ return inputs.size(); }
+	};
+
+	class SyntheticStream{
+	private:
+		SyntheticTask& task;
+		u32 batchSize;
+		uint64_t seed;
+
+		std::vector<std::unique_ptr<SyntheticBatch>> slots; // batch n is written in slots[n % slots.size()]
+		std::vector<uint64_t> done; // done[slot] = n + 1 once batch n is in slot
+		std::vector<std::thread> workers;
+		std::mutex lock;
+		std::condition_variable cond;
+		uint64_t nextToGenerate = 0;
+		uint64_t nextToRead = 0; // the batch returned by next() is nextToRead - 1, its slot is in use until the following call
+		bool stopping = false;
+
+		void workerLoop();
+	public:
+		// threads generate the batches, up to prefetch batches ahead of the reader.
+		SyntheticStream(SyntheticTask& task,u32 batchSize,uint64_t seed = 0,u32 threads = 2,u32 prefetch = 4);
+		SyntheticStream(const SyntheticStream& s) = delete;
+		SyntheticStream& operator=(const SyntheticStream& s) = delete;
+		~SyntheticStream(); // stops the threads
+
+		// Waits for the next batch. The batch stays valid until the next call.
+		SyntheticBatch& next();
+
+		// Writes batch index into b on the calling thread, the same as the index-th batch returned by next().
+		void generate(uint64_t index,SyntheticBatch& b);
+
+		// Trains nn on the next batches, one call to nn.train per batch. The loss is the average over the batches.
+		EpochStats train(NeuralNetwork& nn,u32 batches,float rate = 0.01);
+	};
+
+} /* namespace vio */
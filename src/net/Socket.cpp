@@ -0,0 +1,174 @@
+/*
+ * Socket.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+
+#include "net/Socket.h"
+#include <cstring>
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mutex>
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+namespace vio{
+
+#ifdef WIN32
+typedef SOCKET NativeSocket;
+static const NativeSocket INVALID = INVALID_SOCKET;
+static void closeNative(NativeSocket s){ closesocket(s); }
+static void startup(){
+	static std::once_flag started;
+	std::call_once(started,[](){
+		WSADATA data;
+		WSAStartup(MAKEWORD(2,2),&data);
+	});
+}
+#else
+typedef int NativeSocket;
+static const NativeSocket INVALID = -1;
+static void closeNative(NativeSocket s){ ::close(s); }
+static void startup(){}
+#endif
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // no SIGPIPE when the peer is gone.
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static void setNoDelay(NativeSocket s){
+	int one = 1;
+	setsockopt(s,IPPROTO_TCP,TCP_NODELAY,(const char*)&one,sizeof(one));
+}
+
+Socket::Socket(){
+	startup();
+}
+Socket::~Socket(){
+	close();
+}
+
+bool Socket::isOpen(){
+	return handle != (intptr_t)INVALID;
+}
+void Socket::shutdown(){
+	if(!isOpen()) return;
+#ifdef WIN32
+	::shutdown((NativeSocket)handle,SD_BOTH);
+#else
+	::shutdown((NativeSocket)handle,SHUT_RDWR);
+#endif
+}
+void Socket::close(){
+	if(isOpen()){
+		closeNative((NativeSocket)handle);
+		handle = (intptr_t)INVALID;
+	}
+}
+
+bool Socket::connect(const std::string& host,u32 port){
+	close();
+	addrinfo hints;
+	memset(&hints,0,sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo * result = 0;
+	if(getaddrinfo(host.c_str(),std::to_string(port).c_str(),&hints,&result) != 0) return false;
+
+	for(addrinfo * a = result;a != 0;a = a->ai_next){
+		NativeSocket s = socket(a->ai_family,a->ai_socktype,a->ai_protocol);
+		if(s == INVALID) continue;
+		if(::connect(s,a->ai_addr,a->ai_addrlen) == 0){
+			setNoDelay(s);
+			handle = (intptr_t)s;
+			break;
+		}
+		closeNative(s);
+	}
+	freeaddrinfo(result);
+	return isOpen();
+}
+
+bool Socket::listen(u32 port,u32 backlog){
+	close();
+	NativeSocket s = socket(AF_INET,SOCK_STREAM,IPPROTO_TCP);
+	if(s == INVALID) return false;
+	int one = 1;
+	setsockopt(s,SOL_SOCKET,SO_REUSEADDR,(const char*)&one,sizeof(one));
+
+	sockaddr_in addr;
+	memset(&addr,0,sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if(bind(s,(sockaddr*)&addr,sizeof(addr)) != 0 || ::listen(s,backlog) != 0){
+		closeNative(s);
+		return false;
+	}
+	handle = (intptr_t)s;
+	return true;
+}
+
+bool Socket::accept(Socket& client){
+	if(!isOpen()) return false;
+	client.close();
+	NativeSocket s = ::accept((NativeSocket)handle,0,0);
+	if(s == INVALID) return false;
+	setNoDelay(s);
+	client.handle = (intptr_t)s;
+	return true;
+}
+
+bool Socket::send(const void * data,size_t size){
+	const char * p = (const char*)data;
+	while(size > 0){
+		int chunk = size > (1 << 30) ? (1 << 30) : (int)size;
+		int sent = ::send((NativeSocket)handle,p,chunk,SEND_FLAGS);
+		if(sent <= 0) return false;
+		p += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+bool Socket::receive(void * data,size_t size){
+	char * p = (char*)data;
+	while(size > 0){
+		int chunk = size > (1 << 30) ? (1 << 30) : (int)size;
+		int received = ::recv((NativeSocket)handle,p,chunk,0);
+		if(received <= 0) return false;
+		p += received;
+		size -= received;
+	}
+	return true;
+}
+
+u32 Socket::localPort(){
+	sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	if(!isOpen() || getsockname((NativeSocket)handle,(sockaddr*)&addr,&len) != 0) return 0;
+	return ntohs(addr.sin_port);
+}
+
+std::string hostOf(const std::string& address){
+	size_t p = address.rfind(':');
+	return p == std::string::npos ? address : address.substr(0,p);
+}
+u32 portOf(const std::string& address){
+	size_t p = address.rfind(':');
+	return p == std::string::npos ? 0 : std::stoul(address.substr(p+1));
+}
+
+}
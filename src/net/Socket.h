@@ -0,0 +1,66 @@
+/*
+ * Socket.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "utils/utils.h"
+
+namespace vio{
+
+/**
+A blocking TCP socket, on Windows (winsock, link with -lws2_32) and on POSIX systems.
+
+The same class is used to listen and to connect. send and receive always transfer the whole buffer,
+they return false when the connection is closed or broken. Nagle's algorithm is disabled, messages are sent right away.
+
+@code
+Socket server;
+server.listen(4242);
+std::thread t([&](){
+	Socket client;
+	client.connect("127.0.0.1",4242);
+	u32 v = 42;
+	client.send(&v,sizeof(v));
+});
+Socket peer;
+server.accept(peer);
+u32 v;
+peer.receive(&v,sizeof(v));
+t.join();
+@endcode
+ */
+class Socket {
+	intptr_t handle = -1;
+public:
+	Socket();
+	Socket(Socket& s) = delete;
+	Socket& operator=(const Socket& s) = delete;
+	~Socket();
+
+	// host can be an ip or a name. Returns false if nobody listens on host:port.
+	bool connect(const std::string& host,u32 port);
+	// listens on every interface. Use port 0 to get a free port from the OS, see localPort.
+	bool listen(u32 port,u32 backlog = 16);
+	// waits for a connection on a listening socket. client must not be open.
+	bool accept(Socket& client);
+
+	bool send(const void * data,size_t size);
+	bool receive(void * data,size_t size);
+
+	// wakes up the threads blocked in accept, send or receive on this socket, they return false.
+	void shutdown();
+	void close();
+	bool isOpen();
+	u32 localPort();
+};
+
+// The two parts of a "host:port" address. portOf returns 0 if there is no port.
+std::string hostOf(const std::string& address);
+u32 portOf(const std::string& address);
+
+}
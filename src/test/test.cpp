@@ -1,254 +1,1620 @@
-#include <ml/NeuralNetwork.h>
-#include <ml/DenseLayer.h>
-#include <ml/ConvLayer.h>
-#include <ml/SoftMaxLayer.h>
-
-#include "file/File.h"
-#include "utils/utils.h"
-#include "utils/vcrash.h"
-#include "math/Matrix.h"
-#include "math/math.h"
-#include "file/ImageReader.h"
-
-#include <unistd.h>
-
-using namespace vio;
-
-// Mettre ici les fonctions qui testent la bibliothèque.
-void test_matrix(){
-	debug("test_matrix");
-	Matrix a(2,2);
-	Matrix b(2,2);
-	a.fill(0);
-	b.fill(0);
-
-	a.at(0,0) = 2;
-	a.at(1,1) = 1;
-
-	b.at(0,1) = -1;
-	b.at(1,0) = 1;
-
-	Matrix c = Matrix::mul(a,b);
-	vassert(c.get(0,0) == 0 && c.get(1,1) == 0 && c.get(0,1) == -2 && c.get(1,0) == 1);
-	
-	Vector v = Vector(2);
-	v.at(0) = 3;
-	v.at(1) = 1;
-	Vector v2 = c.apply(v);
-	vassert(v2.get(0) == -2 && v2.get(1) == 3)
-
-	Vector v3 = c.applyTranspose(v2);
-	vassert(v3.get(0) == 3 && v3.get(1) == 4)
-
-	debug("PASSED.");
-}
-
-void test_network(){
-	NeuralNetwork nn;
-	// add a few layers.
-	// Let's build a 3 -> 4 -> 1, aka 2 layers
-
-	DenseLayer l1(3,4);
-	DenseLayer l2(4,1);
-
-	// when initializing, put weights that are similar in scale to the average data.
-	l1.randomInit(5);
-	l2.randomInit(5);
-
-	nn.layers.push_back(&l1);
-	nn.layers.push_back(&l2);
-
-
-	Vector input(3);
-	input.at(0) = 3;
-	input.at(1) = 1;
-	input.at(2) = 2;
-
-	Vector output = nn.apply(input); // just make sure this does not crash.
-
-	// let's generate some data to train the network !
-	std::vector<Vector> trainingInputs;
-	std::vector<Vector> trainingOutputs;
-	for(u32 i = 0;i < 1000;i++){
-		Vector newIn(3);
-		Vector newOut(1);
-
-		newIn.at(0) = randomFloat()*20 - 10;
-		newIn.at(1) = randomFloat()*20 - 10;
-		newIn.at(2) = randomFloat()*20 - 10;
-
-		newOut.at(0) = newIn.get(0) * 3 + newIn.get(1) * 5 + newIn.get(2) * 0;
-
-		trainingInputs.push_back(std::move(newIn));
-		trainingOutputs.push_back(std::move(newOut));
-	}
-
-
-	auto begin_timer_clock = std::chrono::high_resolution_clock::now();
-
-	nn.prepare();
-
-	time_function("training the test network",[&nn,&trainingInputs,&trainingOutputs](){
-		float rate = 0.001;
-		float previousError = 99999;
-
-		for(u32 i = 0;i < 2000;i++){
-			nn.train(trainingInputs,trainingOutputs);
-			float e = nn.loss(trainingInputs,trainingOutputs);
-			if(e < 0.5) break;
-			if(e > previousError){
-				rate *= 0.99;
-			}
-			previousError = e;
-			//if(i%20 == 0){
-			//debug("Error %i = %f, r = %f",i,e,rate);
-			//}
-		}
-	});
-
-	float e = nn.loss(trainingInputs,trainingOutputs);
-	vassert(e < 0.5); // error minimized in less than 2000 training steps.
-
-	// Alright, now, let's test our network !
-
-	Vector vresult = nn.apply(trainingInputs[0]);
-	vresult -= trainingOutputs[0];
-
-	vassert(vresult.norm() < 5); // on a training example
-	output = nn.apply(input); // Let's compute 3*3 + 5*1 - 2*2 ( = 9 + 5 - 4 = 10)
-	output.print();
-	vassert(abs(output.get(0) - (3*input.get(0) + 5*input.get(1) - 2*input.get(2))) < 5); // on a non-training example.
-
-
-	debug("PASSED.");
-}
-
-void test_file(){
-	std::string p = getExecutableFolderPath();
-	ImageReader ir(getExecutableFolderPath() + "/example2.png");
-	for(u32 x = 0;x < ir.getWidth();x++){
-		for(u32 y = 0;y < min(30,ir.getHeight());y++){
-			ir.setPixelAtPos(x,y,0,255);
-		}
-	}
-	ir.save(p+"/edited.png");
-	debug("PASSED.");
-}
-
-u32 getBytesAsInt(File& f){
-	u32 r = f.nextChar()<<24;
-	r += f.nextChar()<<16;
-	r += f.nextChar()<<8;
-	r += f.nextChar();
-	return r;
-}
-
-void test_mnist(){
-	// a complete test of file reading and neural network: digit recognition
-
-	File file_images(getExecutableFolderPath() + "/training_data/train-images.idx3-ubyte");
-	File file_labels(getExecutableFolderPath() + "/training_data/train-labels.idx1-ubyte");
-
-	// the first 4 bytes of each file are:
-	// 0x00000801 (magic number)
-	// after that there are 4 bytes for the number of items
-
-	// inside images, after that, there is the size of width of the images
-	// than, there are the images, with 1 byte = 1 pixel (black+white, row-wise) and for the labels, 1 byte = 1 label
-
-	vassert(getBytesAsInt(file_images) == 0x803);
-	vassert(getBytesAsInt(file_labels) == 0x801);
-	const u32 item_count = getBytesAsInt(file_images);
-	vassert(item_count == getBytesAsInt(file_labels));
-	vassert(item_count > 0);
-
-	const u32 image_width = getBytesAsInt(file_images);
-	const u32 image_height = getBytesAsInt(file_images);
-
-	vassert(image_width == image_height && image_width > 0 && image_width < 300);
-
-	// alright, now we can access the training data !
-	std::vector<Vector> labels;
-	std::vector<Vector> images;
-
-	debug("Image file size: %i",file_images.size());
-
-	for(u32 i = 0;i < item_count;i++){
-		Vector label(10); // one for every digit
-		label.fill(0);
-
-		int c = file_labels.nextChar();
-		label.at(c) = 1;
-		labels.push_back(label);
-
-		Vector image(image_width * image_height);
-		for(u32 j = 0;j < image_width * image_height;j++){
-			int pixel = file_images.nextChar();
-			image.at(j) = (float)(pixel) / 255.;
-		}
-		images.push_back(image);
-
-	}
-	debug("Training data loaded: %i items, image size: %i x %i",item_count,image_width,image_width);
-
-	NeuralNetwork nn;
-	ConvLayer cl1(image_width*image_height,2,8,8); cl1.randomInit(2,1);
-	ConvLayer cl2(image_width*image_height / 4,2,8,8); cl2.randomInit(2,1);
-	DenseLayer l3(image_width*image_height / 16,30); l3.randomInit(3); // size reducted to "only" 49 parameters
-	DenseLayer l4(30,10); l4.randomInit(3);
-	SoftMaxLayer l5(10);
-
-	nn.layers.push_back(&cl1);
-	nn.layers.push_back(&cl2);
-	nn.layers.push_back(&l3);
-	nn.layers.push_back(&l4);
-	//
-	nn.prepare();
-
-	debug("Loss: %.6f",nn.loss(images,labels));
-
-	nn.train(images,labels,0.001); // train once, then add the softmax layer.
-	debug("Loss (presoft): %.6f",nn.loss(images,labels));
-
-	// You can train your network, edit it and retrain it afterwards !
-	nn.layers.push_back(&l5); // softmax and cross entropy MUST be used together. Training will fail if you just use cross entropy alone.
-	nn.errorFunction = crossEntropyErrorFn;
-	nn.errorFunctionGradient = crossEntropyErrorDerivative;
-	nn.prepare();
-
-	debug("Loss (postsoft): %.6f",nn.loss(images,labels)); // we loss a bit of loss as the goal changes a bit.
-
-	for(u32 i = 0;i < 3;i++){
-		nn.train(images,labels,0.001);
-		debug("Loss: %.6f",nn.loss(images,labels));
-	}
-
-
-	// kernels used:
-	debug("Kernels: ");
-	cl1.getKernel().print();
-	cl2.getKernel().print();
-
-	debug("PASSED.");
-
-}
-void test_http(){
-	constexpr u32 rounds = 1'000'000;
-
-
-}
-
-
-int main(int argc,char ** argv){
-	utf8_console();
-	setup_crash_handler();
-	debug("Starting tests ...");
-	test_matrix();
-	//test_network();
-	//test_file();
-	test_mnist();
-	//test_http();
-
-	debug("All tests passed.");
-
-}
+#include <random> // before math.h and its max macro
+#include <fstream>
+#include <ml/NeuralNetwork.h>
+#include <ml/DenseLayer.h>
+#include <ml/ConvLayer.h>
+#include <ml/SoftMaxLayer.h>
+#include <ml/BatchNormLayer.h>
+#include <ml/Checkpointer.h>
+#include <ml/ModelFormat.h>
+#include <ml/PipelineTrainer.h>
+#include <ml/DistributedTrainer.h>
+#include <ml/ParameterServer.h>
+#include <ml/GradientCompressor.h>
+#include <ml/LocalSGDTrainer.h>
+#include <ml/EvolutionStrategy.h>
+#include <ml/GraphNetwork.h>
+#include <ml/MemoryPlan.h>
+#include <ml/Profiler.h>
+#include <ml/SyntheticData.h>
+#include <math/RandomStream.h>
+#include <math/BigInt.h>
+#include <net/Socket.h>
+
+#include "file/File.h"
+#include "utils/utils.h"
+#include "utils/vcrash.h"
+#include "math/Matrix.h"
+#include "math/math.h"
+#include "file/ImageReader.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace vio;
+
+// Fixtures of the training tests.
+
+// count random samples of a small regression: 4 inputs in [-1,1], outputs x0 * x1 and x2 - x3.
+// The generator is seeded first, so a test gets the same samples, and the same weights after, whatever ran before it.
+struct TestSamples{
+	std::vector<Vector> inputs;
+	std::vector<Vector> outputs;
+
+	TestSamples(u32 count){
+		seed(count);
+		for(u32 i = 0;i < count;i++){
+			Vector newIn(4);
+			newIn.fillRandom(1);
+			Vector newOut(2);
+			newOut.at(0) = newIn.get(0) * newIn.get(1);
+			newOut.at(1) = newIn.get(2) - newIn.get(3);
+			inputs.push_back(std::move(newIn));
+			outputs.push_back(std::move(newOut));
+		}
+	}
+};
+
+// A layer without weights that passes its input through and counts the gradients asked to it.
+struct CountingLayer : public Layer{
+	std::atomic<u32> gradients;
+	CountingLayer(u32 size) : Layer(size,size),gradients(0){}
+	Vector apply(const Vector& in){ return in; }
+	Vector applyGradient(const Vector& in,const Vector& evaluationPosition,const Vector& previousEvaluationPosition){
+		gradients++;
+		return in;
+	}
+};
+
+// Replaces the layers of nn by dense layers owned by nn, sizes[i] inputs and sizes[i+1] outputs for layer i,
+// weights uniform in [-0.3,0.3]. Layer tanhLayer uses tanh.
+static void denseStack(NeuralNetwork& nn,const std::vector<u32>& sizes,i32 tanhLayer = -1){
+	NeuralNetwork builder;
+	for(u32 i = 0;i + 1 < sizes.size();i++){
+		DenseLayer * l = (i32)i == tanhLayer ? new DenseLayer(sizes[i],sizes[i+1],"tanh") : new DenseLayer(sizes[i],sizes[i+1]);
+		l->randomInit(0.3);
+		builder.layers.push_back(l);
+	}
+	vassert(nn.load(builder.serialize()));
+	for(Layer * l : builder.layers) delete l;
+}
+
+// One DistributedTrainer per network, listening on ports of localhost picked by the system.
+static std::vector<std::unique_ptr<DistributedTrainer>> localRing(NeuralNetwork * nets,u32 n){
+	std::vector<std::unique_ptr<DistributedTrainer>> trainers;
+	std::vector<std::string> addresses;
+	for(u32 r = 0;r < n;r++){
+		trainers.emplace_back(new DistributedTrainer(nets[r],r,std::vector<std::string>(n,"127.0.0.1:0")));
+		u32 port = trainers[r]->listen();
+		vassert(port != 0);
+		addresses.push_back("127.0.0.1:" + std::to_string(port));
+	}
+	for(u32 r = 0;r < n;r++) trainers[r]->setWorkers(addresses);
+	return trainers;
+}
+
+// Mettre ici les fonctions qui testent la bibliothèque.
+void test_matrix(){
+	debug("test_matrix");
+	Matrix a(2,2);
+	Matrix b(2,2);
+	a.fill(0);
+	b.fill(0);
+
+	a.at(0,0) = 2;
+	a.at(1,1) = 1;
+
+	b.at(0,1) = -1;
+	b.at(1,0) = 1;
+
+	Matrix c = Matrix::mul(a,b);
+	vassert(c.get(0,0) == 0 && c.get(1,1) == 0 && c.get(0,1) == -2 && c.get(1,0) == 1);
+	
+	Vector v = Vector(2);
+	v.at(0) = 3;
+	v.at(1) = 1;
+	Vector v2 = c.apply(v);
+	vassert(v2.get(0) == -2 && v2.get(1) == 3)
+
+	Vector v3 = c.applyTranspose(v2);
+	vassert(v3.get(0) == 3 && v3.get(1) == 4)
+
+	debug("PASSED.");
+}
+
+void test_network(){
+	NeuralNetwork nn;
+	// add a few layers.
+	// Let's build a 3 -> 4 -> 1, aka 2 layers
+
+	DenseLayer l1(3,4);
+	DenseLayer l2(4,1);
+
+	// when initializing, put weights that are similar in scale to the average data.
+	l1.randomInit(5);
+	l2.randomInit(5);
+
+	nn.layers.push_back(&l1);
+	nn.layers.push_back(&l2);
+
+
+	Vector input(3);
+	input.at(0) = 3;
+	input.at(1) = 1;
+	input.at(2) = 2;
+
+	Vector output = nn.apply(input); // just make sure this does not crash.
+
+	// let's generate some data to train the network !
+	std::vector<Vector> trainingInputs;
+	std::vector<Vector> trainingOutputs;
+	for(u32 i = 0;i < 1000;i++){
+		Vector newIn(3);
+		Vector newOut(1);
+
+		newIn.at(0) = randomFloat()*20 - 10;
+		newIn.at(1) = randomFloat()*20 - 10;
+		newIn.at(2) = randomFloat()*20 - 10;
+
+		newOut.at(0) = newIn.get(0) * 3 + newIn.get(1) * 5 + newIn.get(2) * 0;
+
+		trainingInputs.push_back(std::move(newIn));
+		trainingOutputs.push_back(std::move(newOut));
+	}
+
+
+	auto begin_timer_clock = std::chrono::high_resolution_clock::now();
+
+	nn.prepare();
+
+	time_function("training the test network",[&nn,&trainingInputs,&trainingOutputs](){
+		float rate = 0.001;
+		float previousError = 99999;
+
+		for(u32 i = 0;i < 2000;i++){
+			float e = nn.train(trainingInputs,trainingOutputs,rate).loss; // running loss of the epoch, no extra pass over the data
+			// the running loss lags behind the weights, only check the real loss when we are close.
+			if(e < 0.5 && nn.loss(trainingInputs,trainingOutputs) < 0.5) break;
+			if(e > previousError){
+				rate *= 0.99;
+			}
+			previousError = e;
+			//if(i%20 == 0){
+			//debug("Error %i = %f, r = %f",i,e,rate);
+			//}
+		}
+	});
+
+	float e = nn.loss(trainingInputs,trainingOutputs);
+	vassert(e < 0.5); // error minimized in less than 2000 training steps.
+
+	// Alright, now, let's test our network !
+
+	Vector vresult = nn.apply(trainingInputs[0]);
+	vresult -= trainingOutputs[0];
+
+	vassert(vresult.norm() < 5); // on a training example
+	output = nn.apply(input); // Let's compute 3*3 + 5*1 - 2*2 ( = 9 + 5 - 4 = 10)
+	output.print();
+	vassert(abs(output.get(0) - (3*input.get(0) + 5*input.get(1) - 2*input.get(2))) < 5); // on a non-training example.
+
+
+	debug("PASSED.");
+}
+
+void test_serialization(){
+	debug("test_serialization");
+	NeuralNetwork nn;
+	DenseLayer l1(3,4,"tanh");
+	DenseLayer l2(4,2);
+	SoftMaxLayer l3(2);
+	l1.randomInit(2);
+	l2.randomInit(2);
+	nn.layers.push_back(&l1);
+	nn.layers.push_back(&l2);
+	nn.layers.push_back(&l3);
+	nn.errorFunction = crossEntropyErrorFn;
+	nn.errorFunctionGradient = crossEntropyErrorDerivative;
+
+	Vector input(3);
+	input.at(0) = 1;
+	input.at(1) = -2;
+	input.at(2) = 0.5;
+	Vector expected = nn.apply(input);
+
+	std::string image = nn.serialize();
+	vassert(image.size() % 64 == 0);
+
+	NeuralNetwork copy;
+	vassert(copy.load(image));
+	vassert(copy.layers.size() == 3);
+	vassert(copy.errorFunction == crossEntropyErrorFn);
+	Vector r = copy.apply(input);
+	r -= expected;
+	vassert(r.normSquared() == 0);
+
+	std::string path = getExecutableFolderPath() + "/test_model.vlnn";
+	vassert(nn.save(path));
+	NeuralNetwork mapped;
+	vassert(mapped.loadMapped(path));
+	r = mapped.apply(input);
+	r -= expected;
+	vassert(r.normSquared() == 0);
+
+	// Offsets near 2^64 that would wrap around in offset + size.
+	std::string crafted = image;
+	ModelHeader * h = (ModelHeader*)&crafted[0];
+	ModelBlockRecord * br = (ModelBlockRecord*)&crafted[h->blockTableOffset];
+	br[0].offset = ~(uint64_t)0 - 63;
+	vassert(validateModel(crafted.data(),crafted.size()) != 0);
+	crafted = image;
+	h = (ModelHeader*)&crafted[0];
+	h->layerTableOffset = ~(uint64_t)0 - 7;
+	vassert(validateModel(crafted.data(),crafted.size()) != 0);
+	vassert(validateModel(image.data(),image.size()) == 0);
+
+	image[0] = 'X';
+	vassert(!copy.load(image)); // bad magic
+
+	debug("PASSED.");
+}
+
+void test_epoch_stats(){
+	debug("test_epoch_stats");
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	NeuralNetwork nn;
+	denseStack(nn,{4,8,2},0);
+	nn.prepare();
+
+	// without accuracy
+	vassert(nn.train(trainingInputs,trainingOutputs,0).accuracy == -1);
+
+	// With a learning rate of 0, the weights do not move: the running stats are the ones of the dataset.
+	nn.computeAccuracy = true;
+	EpochStats stats = nn.train(trainingInputs,trainingOutputs,0);
+	u32 hits = 0;
+	for(u32 i = 0;i < trainingInputs.size();i++){
+		if(NeuralNetwork::argmax(nn.apply(trainingInputs[i])) == NeuralNetwork::argmax(trainingOutputs[i])) hits++;
+	}
+	vassert(stats.ok && stats.samples == 100);
+	vassert(std::abs(stats.loss - nn.loss(trainingInputs,trainingOutputs)) < 1e-5);
+	vassert(stats.accuracy == hits / 100.0f);
+
+	// While learning, the stats are averages over the samples seen.
+	for(u32 i = 0;i < 5;i++){
+		stats = nn.train(trainingInputs,trainingOutputs,0.05);
+		vassert(stats.loss >= 0 && stats.accuracy >= 0 && stats.accuracy <= 1);
+		vassert(std::abs(stats.accuracy * 100 - std::round(stats.accuracy * 100)) < 1e-4);
+	}
+
+	debug("PASSED.");
+}
+
+void test_checkpoint(){
+	debug("test_checkpoint");
+	NeuralNetwork nn;
+	DenseLayer l1(3,4);
+	DenseLayer l2(4,1);
+	l1.randomInit(1);
+	l2.randomInit(1);
+	nn.layers.push_back(&l1);
+	nn.layers.push_back(&l2);
+	nn.prepare();
+
+	std::vector<Vector> trainingInputs;
+	std::vector<Vector> trainingOutputs;
+	for(u32 i = 0;i < 200;i++){
+		Vector newIn(3);
+		newIn.fillRandom(1);
+		Vector newOut(1);
+		newOut.at(0) = newIn.get(0) - newIn.get(2);
+		trainingInputs.push_back(newIn);
+		trainingOutputs.push_back(newOut);
+	}
+
+	std::string path = getExecutableFolderPath() + "/test_checkpoint.vlnn";
+	{
+		Checkpointer cp(path,50);
+		nn.checkpointer = &cp;
+		for(u32 i = 0;i < 5;i++){
+			nn.train(trainingInputs,trainingOutputs,0.001);
+		}
+		cp.flush();
+		vassert(cp.checkpointsWritten() > 0);
+		nn.checkpointer = 0;
+	}
+
+	// 200 is a multiple of 50: the last checkpoint has the final weights.
+	NeuralNetwork restored;
+	vassert(restored.loadMapped(path));
+	Vector r = restored.apply(trainingInputs[0]);
+	r -= nn.apply(trainingInputs[0]);
+	vassert(r.normSquared() == 0);
+
+	// The same state gives the same bytes, even in a buffer that held a larger network: the padding is zeroed.
+	NeuralNetwork wide;
+	denseStack(wide,{8,8,8});
+	{
+		Checkpointer cp(path,0);
+		cp.snapshot(wide);
+		cp.flush();
+		cp.snapshot(nn);
+		cp.flush();
+	}
+	std::ifstream in(path,std::ios::binary);
+	std::string image((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+	vassert(image == nn.serialize());
+
+	debug("PASSED.");
+}
+
+void test_optimizer_checkpoint(){
+	debug("test_optimizer_checkpoint");
+	NeuralNetwork nn;
+	DenseLayer l1(3,4);
+	DenseLayer l2(4,1);
+	l1.randomInit(1);
+	l2.randomInit(1);
+	nn.layers.push_back(&l1);
+	nn.layers.push_back(&l2);
+	nn.prepare();
+
+	AdamOptimizer adam;
+	adam.prepare(nn.layers);
+	Matrix g1(3,4);
+	Matrix g2(4,1);
+	for(u32 step = 0;step < 3;step++){
+		g1.fillRandom(1);
+		g2.fillRandom(1);
+		adam.adjustGradientMatrix(g1);
+		adam.adjustGradientMatrix(g2);
+	}
+
+	std::string path = getExecutableFolderPath() + "/test_optimizer_checkpoint.vlnn";
+	{
+		Checkpointer cp(path,1,&adam,1);
+		cp.snapshot(nn);
+		cp.flush();
+		vassert(cp.checkpointsWritten() == 1);
+	}
+	std::ifstream in(path,std::ios::binary);
+	std::string image((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+
+	AdamOptimizer restored;
+	restored.prepare(nn.layers);
+	vassert(Checkpointer::restoreOptimizer(image,restored));
+	std::vector<ParameterBlock> a = adam.state();
+	std::vector<ParameterBlock> b = restored.state();
+	vassert(a.size() == b.size() && a.size() == 5); // 2 first moments, 2 second moments, the powers of beta
+	for(u32 i = 0;i < a.size();i++){
+		vassert(a[i].size == b[i].size);
+		vassert(memcmp(a[i].data,b[i].data,a[i].size * sizeof(float)) == 0);
+	}
+
+	// the restored optimizer continues exactly where the saved one stopped.
+	g1.fillRandom(1);
+	Matrix g1copy = g1;
+	adam.adjustGradientMatrix(g1);
+	restored.adjustGradientMatrix(g1copy);
+	vassert(memcmp(g1.data(),g1copy.data(),12 * sizeof(float)) == 0);
+
+	// a checkpoint of another network does not match the optimizer.
+	AdamOptimizer other;
+	DenseLayer l3(5,2);
+	std::vector<Layer*> otherLayers = {&l3};
+	other.prepare(otherLayers);
+	vassert(!Checkpointer::restoreOptimizer(image,other));
+
+	debug("PASSED.");
+}
+
+void test_gradient_checkpointing(){
+	debug("test_gradient_checkpointing");
+	// The same network trained with and without checkpointing must end up with the same weights.
+	NeuralNetwork nn;
+	DenseLayer l1(4,8);
+	DenseLayer l2(8,8,"tanh");
+	BatchNormLayer l3(8);
+	DenseLayer l4(8,8);
+	DenseLayer l5(8,6);
+	DenseLayer l6(6,2);
+	l1.randomInit(1); l2.randomInit(1); l4.randomInit(1); l5.randomInit(1); l6.randomInit(1);
+	nn.layers = {&l1,&l2,&l3,&l4,&l5,&l6};
+
+	NeuralNetwork copy;
+	copy.load(nn.serialize());
+	copy.activationCheckpointInterval = 3;
+	nn.prepare();
+	copy.prepare();
+
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	for(u32 i = 0;i < 3;i++){
+		seed(i); // same shuffling for both.
+		float e1 = nn.train(trainingInputs,trainingOutputs,0.01).loss;
+		seed(i);
+		float e2 = copy.train(trainingInputs,trainingOutputs,0.01).loss;
+		vassert(e1 == e2);
+	}
+	Vector r = nn.apply(trainingInputs[0]);
+	r -= copy.apply(trainingInputs[0]);
+	vassert(r.normSquared() == 0);
+
+	debug("PASSED.");
+}
+
+void test_pipeline(){
+	debug("test_pipeline");
+	// The pipeline trainer must give the same weights for any number of stages and any schedule.
+	NeuralNetwork nets[3];
+	denseStack(nets[0],{4,16,16,8,8,2},2);
+	nets[1].load(nets[0].serialize());
+	nets[2].load(nets[0].serialize());
+
+	PipelineTrainer p0(nets[0],1);
+	PipelineTrainer p1(nets[1],3,PipelineTrainer::GPIPE);
+	PipelineTrainer p2(nets[2],3,PipelineTrainer::ONE_F_ONE_B);
+	PipelineTrainer * trainers[3] = {&p0,&p1,&p2};
+	vassert(p1.stageCount() == 3 && p1.stageStart(0) == 0 && p1.stageEnd(2) == 5);
+
+	TestSamples samples(100); // not a multiple of the step size on purpose.
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	float first = 0,e = 0;
+	for(u32 i = 0;i < 20;i++){
+		float errors[3];
+		for(u32 j = 0;j < 3;j++){
+			trainers[j]->microBatchSize = 4;
+			seed(i); // same shuffling for all.
+			errors[j] = trainers[j]->train(trainingInputs,trainingOutputs,0.05).loss;
+		}
+		vassert(errors[0] == errors[1] && errors[0] == errors[2]);
+		if(i == 0) first = errors[0];
+		e = errors[0];
+	}
+	vassert(e < first);
+	for(u32 j = 1;j < 3;j++){
+		Vector r = nets[0].apply(trainingInputs[0]);
+		r -= nets[j].apply(trainingInputs[0]);
+		vassert(r.normSquared() == 0);
+	}
+
+	// Nothing is propagated below the first learnable layer, like in NeuralNetwork::train.
+	NeuralNetwork frozen;
+	CountingLayer c0(4),c1(4);
+	DenseLayer top(4,2);
+	top.randomInit(0.3);
+	frozen.layers = {&c0,&c1,&top};
+	PipelineTrainer pf(frozen,2);
+	pf.train(trainingInputs,trainingOutputs,0.05);
+	vassert(c0.gradients == 0 && c1.gradients == 0);
+
+	debug("PASSED.");
+}
+
+void test_thread_pool(){
+	debug("test_thread_pool");
+	ThreadPool pool(4);
+	// a nested loop keeps the worker index of its chunk.
+	std::atomic<u32> total(0);
+	pool.parallelFor(64,1,[&](u32 begin,u32 end,u32 worker){
+		vassert(worker < pool.size());
+		pool.parallelFor(16,4,[&](u32 b,u32 e,u32 inner){
+			vassert(inner == worker);
+			total += e - b;
+		});
+	});
+	vassert(total == 64 * 16);
+
+	// forEachWorker runs index i on the thread of worker i, every time.
+	std::vector<std::thread::id> owners(pool.size());
+	for(u32 round = 0;round < 20;round++){
+		std::vector<u32> calls(pool.size(),0);
+		pool.forEachWorker([&](u32 i){
+			calls[i]++;
+			if(round == 0) owners[i] = std::this_thread::get_id();
+			vassert(owners[i] == std::this_thread::get_id());
+		});
+		vassert(calls == std::vector<u32>(pool.size(),1));
+	}
+	vassert(owners[0] == std::this_thread::get_id());
+
+	// called from the chunks of another pool, two threads never get the same worker at the same time.
+	ThreadPool outer(3);
+	std::vector<std::atomic<u32>> users(pool.size());
+	outer.parallelFor(12,1,[&](u32 begin,u32 end,u32 o){
+		pool.parallelFor(8,8,[&](u32 b,u32 e,u32 worker){
+			vassert(users[worker].fetch_add(1) == 0);
+			usleep(1000);
+			users[worker]--;
+		});
+	});
+
+	debug("PASSED.");
+}
+
+void test_sharding(){
+	debug("test_sharding");
+	// A sharded layer must compute the same thing as an unsharded one.
+	ThreadPool pool(4);
+	DenseLayer ref(300,500,"tanh");
+	ref.randomInit(0.1);
+	DenseLayer rows(300,500,"tanh");
+	DenseLayer columns(300,500,"tanh");
+	std::vector<float*> weights;
+	for(ParameterBlock& p : ref.parameters()) weights.push_back(p.data);
+	rows.bindParameters(weights); // share the weights.
+	columns.bindParameters(weights);
+	rows.shard(&pool,DenseLayer::SHARD_ROWS);
+	columns.shard(&pool,DenseLayer::SHARD_COLUMNS);
+
+	Vector x(300);
+	x.fillRandom(1);
+	Vector y = ref.apply(x);
+	Vector d = rows.apply(x);
+	d -= y;
+	vassert(d.normSquared() == 0); // no communication, same order of operations.
+	d = columns.apply(x);
+	d -= y;
+	vassert(d.normSquared() < 1e-8);
+
+	Vector g(500);
+	g.fillRandom(1);
+	Vector r = ref.applyGradient(g,x,x);
+	d = columns.applyGradient(g,x,x);
+	d -= r;
+	vassert(d.normSquared() == 0);
+	d = rows.applyGradient(g,x,x);
+	d -= r;
+	vassert(d.normSquared() < 1e-8);
+
+	debug("PASSED.");
+}
+
+void test_distributed(){
+	debug("test_distributed");
+	// 3 workers on localhost must end up with the same weights, close to a single worker doing the same steps.
+	const u32 n = 3;
+	NeuralNetwork reference;
+	denseStack(reference,{4,12,8,2},1);
+
+	NeuralNetwork nets[n];
+	nets[0].load(reference.serialize());
+	for(u32 i = 1;i < n;i++){
+		nets[i].load(reference.serialize());
+		for(ParameterBlock& p : nets[i].layers[0]->parameters()){
+			for(u32 j = 0;j < p.size;j++) p.data[j] = 0; // connect must replace them by the weights of rank 0.
+		}
+	}
+
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+
+	const u32 epochs = 5;
+	float errors[epochs];
+	std::vector<std::unique_ptr<DistributedTrainer>> trainers = localRing(nets,n);
+	std::vector<std::thread> threads;
+	for(u32 r = 0;r < n;r++){
+		threads.push_back(std::thread([&,r](){
+			DistributedTrainer& dt = *trainers[r];
+			dt.batchSize = 4;
+			dt.bucketSize = 16; // several buckets
+			vassert(dt.connect());
+			for(u32 i = 0;i < epochs;i++){
+				if(r == 0) seed(i); // only rank 0 shuffles.
+				float e = dt.train(trainingInputs,trainingOutputs,0.05).loss;
+				if(r == 0) errors[i] = e;
+			}
+		}));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+
+	DistributedTrainer single(reference,0,{"127.0.0.1:0"});
+	single.batchSize = 4 * n;
+	vassert(single.connect());
+	for(u32 i = 0;i < epochs;i++){
+		seed(i);
+		float e = single.train(trainingInputs,trainingOutputs,0.05).loss;
+		vassert(std::abs(e - errors[i]) < 1e-4);
+	}
+	vassert(errors[epochs - 1] < errors[0]);
+
+	Vector expected = reference.apply(trainingInputs[0]);
+	for(u32 i = 0;i < n;i++){
+		Vector r = nets[i].apply(trainingInputs[0]);
+		r -= nets[0].apply(trainingInputs[0]);
+		vassert(r.normSquared() == 0); // the replicas are identical
+		r = nets[i].apply(trainingInputs[0]);
+		r -= expected;
+		vassert(r.normSquared() < 1e-8);
+	}
+
+	// rank 2 leaves after one epoch: the others must stop without applying a partial step.
+	trainers = localRing(nets,n);
+	std::string before[n];
+	bool lost[n];
+	threads.clear();
+	for(u32 r = 0;r < n;r++){
+		threads.push_back(std::thread([&,r](){
+			DistributedTrainer& dt = *trainers[r];
+			dt.batchSize = 4;
+			vassert(dt.connect());
+			vassert(dt.train(trainingInputs,trainingOutputs,0.05).ok);
+			if(r == 2){
+				trainers[r].reset();
+				return;
+			}
+			before[r] = nets[r].serialize();
+			lost[r] = !dt.train(trainingInputs,trainingOutputs,0.05).ok && !dt.train(trainingInputs,trainingOutputs,0.05).ok;
+		}));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+	for(u32 r = 0;r < 2;r++){
+		vassert(lost[r]);
+		vassert(nets[r].serialize() == before[r]);
+	}
+
+	debug("PASSED.");
+}
+
+void test_parameter_server(){
+	debug("test_parameter_server");
+	// 2 servers and 2 workers with bounded staleness, every worker trains on its half of the dataset.
+	NeuralNetwork nets[2];
+	denseStack(nets[0],{4,12,8,2},1);
+	nets[1].load(nets[0].serialize());
+
+	ParameterServer s0(nets[0],0,2,2,0,1);
+	ParameterServer s1(nets[0],1,2,2,0,1);
+	vassert(s0.start() && s1.start());
+	std::vector<std::string> servers = {"127.0.0.1:" + std::to_string(s0.getPort()),"127.0.0.1:" + std::to_string(s1.getPort())};
+
+	TestSamples samples(100);
+	std::vector<Vector> inputs[2];
+	std::vector<Vector> outputs[2];
+	for(u32 i = 0;i < 100;i++){
+		inputs[i % 2].push_back(samples.inputs[i]);
+		outputs[i % 2].push_back(samples.outputs[i]);
+	}
+	const float before = nets[0].loss(inputs[0],outputs[0]);
+
+	ParameterWorker w0(nets[0],0,servers);
+	ParameterWorker w1(nets[1],1,servers);
+	ParameterWorker * workers[2] = {&w0,&w1};
+	std::vector<std::thread> threads;
+	for(u32 w = 0;w < 2;w++){
+		threads.push_back(std::thread([&,w](){
+			workers[w]->shuffle = false; // randomU32 is not thread safe.
+			workers[w]->batchSize = 5;
+			vassert(workers[w]->connect());
+			for(u32 i = 0;i < 20;i++){
+				vassert(workers[w]->train(inputs[w],outputs[w],0.02).ok);
+			}
+		}));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+	vassert(s0.minClock() == 20 * 10);
+	vassert(s0.maxLead() <= 1 && s1.maxLead() <= 1); // no pull was served more than staleness steps ahead
+	vassert(w0.pull()); // everybody is done, these are the final weights.
+	w0.finish();
+	w1.finish();
+	vassert(s0.wait() && s1.wait());
+	vassert(nets[0].loss(inputs[0],outputs[0]) < before);
+
+	// A worker lost without DONE no longer holds the others back, even with staleness = 0.
+	ParameterServer strict(nets[0],0,1,2,0,0);
+	vassert(strict.start());
+	{
+		Socket lost;
+		vassert(lost.connect("127.0.0.1",strict.getPort()));
+		ParameterServer::Message msg = {ParameterServer::PULL,0,0,0};
+		std::vector<float> weights(ParameterServer::parameterCount(nets[0]));
+		vassert(lost.send(&msg,sizeof(msg)) && lost.receive(weights.data(),weights.size() * sizeof(float)));
+	}
+	ParameterWorker survivor(nets[1],1,{"127.0.0.1:" + std::to_string(strict.getPort())});
+	survivor.shuffle = false;
+	vassert(survivor.connect());
+	vassert(survivor.train(inputs[1],outputs[1],0.02).ok);
+	survivor.finish();
+	vassert(!strict.wait() && strict.hasFailed(0) && !strict.hasFailed(1));
+
+	// A worker that loses its server stops the epoch.
+	std::unique_ptr<ParameterServer> gone(new ParameterServer(nets[0],0,1,1,0,0));
+	vassert(gone->start());
+	ParameterWorker orphan(nets[1],0,{"127.0.0.1:" + std::to_string(gone->getPort())});
+	orphan.shuffle = false;
+	vassert(orphan.connect() && orphan.train(inputs[1],outputs[1],0.02).ok);
+	gone.reset();
+	vassert(!orphan.train(inputs[1],outputs[1],0.02).ok);
+
+	debug("PASSED.");
+}
+
+void test_compression(){
+	debug("test_compression");
+	const u32 count = 1000;
+	std::vector<float> x(count);
+	for(u32 i = 0;i < count;i++) x[i] = randomFloat() * 2 - 1;
+
+	// 8 bits: the error is at most half a step.
+	Int8Compressor i8;
+	i8.errorFeedback = false;
+	std::vector<char> packed;
+	std::vector<float> data = x;
+	i8.compress(0,data.data(),count,packed);
+	std::vector<float> decoded(count,0);
+	vassert(i8.decompressAdd(packed.data(),count,decoded.data()) == packed.size());
+	vassert(packed.size() == i8.compressedSize(count));
+	float largest = 0;
+	for(float f : x) largest = max(largest,std::abs(f));
+	for(u32 i = 0;i < count;i++){
+		vassert(std::abs(decoded[i] - x[i]) <= largest / 127 / 2 + 1e-6);
+	}
+
+	// 1 bit: the sign is kept.
+	SignCompressor sign;
+	sign.errorFeedback = false;
+	packed.clear();
+	data = x;
+	sign.compress(0,data.data(),count,packed);
+	vassert(packed.size() == sizeof(float) + count / 8 && packed.size() == sign.compressedSize(count));
+	std::fill(decoded.begin(),decoded.end(),0);
+	sign.decompressAdd(packed.data(),count,decoded.data());
+	for(u32 i = 0;i < count;i++){
+		vassert((decoded[i] < 0) == (x[i] < 0) && std::abs(decoded[i]) == std::abs(decoded[0]));
+	}
+
+	// top-k with error feedback: what is not sent the first time is sent the next time.
+	TopKCompressor topk(0.1);
+	std::vector<float> sent(count,0);
+	for(u32 step = 0;step < 2;step++){
+		packed.clear();
+		data = x;
+		if(step == 1) std::fill(data.begin(),data.end(),0);
+		topk.compress(0,data.data(),count,packed);
+		std::fill(decoded.begin(),decoded.end(),0);
+		topk.decompressAdd(packed.data(),count,decoded.data());
+		u32 nonZero = 0;
+		for(u32 i = 0;i < count;i++){
+			if(decoded[i] != 0){
+				nonZero++;
+				vassert(sent[i] == 0 && decoded[i] == x[i]);
+				sent[i] = decoded[i];
+			}
+		}
+		vassert(nonZero == count / 10 && packed.size() == topk.compressedSize(count));
+	}
+	// against the all-reduce of 4 bytes per value: 8 bits stop paying at 8 workers, 1 bit much later.
+	vassert(i8.compresses(count,4) && !i8.compresses(count,8));
+	vassert(sign.compresses(count,30) && !sign.compresses(count,70));
+	vassert(topk.compresses(count,9) && !topk.compresses(count,10));
+	// the 200 values sent are the 200 largest.
+	float smallestSent = 1,largestKept = 0;
+	for(u32 i = 0;i < count;i++){
+		if(sent[i] != 0) smallestSent = min(smallestSent,std::abs(x[i]));
+		else largestKept = max(largestKept,std::abs(x[i]));
+	}
+	vassert(smallestSent >= largestKept);
+
+	// distributed training with compressed gradients: the workers stay identical.
+	NeuralNetwork nets[2];
+	denseStack(nets[0],{4,12,2});
+	nets[1].load(nets[0].serialize());
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	const float before = nets[0].loss(trainingInputs,trainingOutputs);
+	Int8Compressor compressors[2];
+	std::vector<std::unique_ptr<DistributedTrainer>> trainers = localRing(nets,2);
+	std::vector<std::thread> threads;
+	for(u32 r = 0;r < 2;r++){
+		threads.push_back(std::thread([&,r](){
+			DistributedTrainer& dt = *trainers[r];
+			dt.batchSize = 4;
+			dt.bucketSize = 16;
+			dt.compressor = &compressors[r];
+			vassert(dt.connect());
+			for(u32 i = 0;i < 10;i++){
+				if(r == 0) seed(i);
+				dt.train(trainingInputs,trainingOutputs,0.05);
+			}
+		}));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+	Vector d = nets[0].apply(trainingInputs[0]);
+	d -= nets[1].apply(trainingInputs[0]);
+	vassert(d.normSquared() == 0);
+	vassert(nets[0].loss(trainingInputs,trainingOutputs) < before);
+
+	debug("PASSED.");
+}
+
+void test_local_sgd(){
+	debug("test_local_sgd");
+	const std::string name = "vlearn_test_" + std::to_string(getpid());
+	// The averages of 3 trainers (threads here, processes usually) sharing the same memory.
+	const u32 n = 3;
+	NeuralNetwork nets[n];
+	denseStack(nets[0],{4,12,2});
+	for(u32 i = 1;i < n;i++){
+		nets[i].load(nets[0].serialize());
+		for(ParameterBlock& p : nets[i].layers[1]->parameters()){
+			for(u32 j = 0;j < p.size;j++) p.data[j] = 0; // open must replace them by the weights of rank 0.
+		}
+	}
+	const float first = nets[0].layers[1]->parameters()[0].data[0];
+
+	std::vector<std::thread> threads;
+	for(u32 r = 0;r < n;r++){
+		threads.push_back(std::thread([&,r](){
+			LocalSGDTrainer lt(nets[r],name,r,n);
+			vassert(lt.open());
+			float * w = nets[r].layers[1]->parameters()[0].data;
+			vassert(w[0] == first);
+			for(u32 round = 0;round < 200;round++){
+				w[0] = round * n + r; // the average is round * n + 1
+				lt.average();
+				vassert(w[0] == round * n + 1);
+			}
+		}));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+
+	// training with a single process is NeuralNetwork::train with averages that change nothing.
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	NeuralNetwork single;
+	single.load(nets[0].serialize());
+	single.prepare();
+	const float before = single.loss(trainingInputs,trainingOutputs);
+	LocalSGDTrainer lt(single,name,0,1);
+	lt.averagingInterval = 16;
+	vassert(lt.open());
+	for(u32 i = 0;i < 10;i++){
+		lt.train(trainingInputs,trainingOutputs,0.01);
+	}
+	vassert(single.loss(trainingInputs,trainingOutputs) < before);
+
+	// The memory of a run that crashed (its trainers are still there, but nobody uses them) must not be used by the next run,
+	// even by a rank that opens it before rank 0 replaced it.
+	const std::string stale = name + "_stale";
+	NeuralNetwork crashed[2];
+	std::unique_ptr<LocalSGDTrainer> crashedTrainers[2];
+	threads.clear();
+	for(u32 r = 0;r < 2;r++){
+		crashed[r].load(nets[0].serialize());
+		crashedTrainers[r].reset(new LocalSGDTrainer(crashed[r],stale,r,2));
+		threads.push_back(std::thread([&,r](){ vassert(crashedTrainers[r]->open()); }));
+	}
+	for(std::thread& t : threads){
+		t.join();
+	}
+	NeuralNetwork next[2];
+	next[0].load(nets[0].serialize());
+	next[1].load(nets[0].serialize());
+	next[0].layers[0]->parameters()[0].data[0] = 42;
+	std::thread late([&](){
+		LocalSGDTrainer lt1(next[1],stale,1,2);
+		vassert(lt1.open());
+		vassert(next[1].layers[0]->parameters()[0].data[0] == 42);
+		lt1.average();
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	LocalSGDTrainer lt0(next[0],stale,0,2);
+	vassert(lt0.open());
+	lt0.average();
+	late.join();
+
+	debug("PASSED.");
+}
+
+void test_graph(){
+	debug("test_graph");
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+
+	// A chain of layers trains exactly like a NeuralNetwork.
+	NeuralNetwork chain[2];
+	denseStack(chain[0],{4,16,8,2},1);
+	chain[1].load(chain[0].serialize());
+	chain[0].prepare();
+	GraphNetwork linear;
+	u32 node = linear.input(4);
+	for(Layer * l : chain[1].layers){
+		node = linear.layer(l,node);
+	}
+	linear.prepare();
+	vassert(linear.depth() == 4);
+	for(u32 i = 0;i < 5;i++){
+		seed(i);
+		float e0 = chain[0].train(trainingInputs,trainingOutputs,0.01).loss;
+		seed(i);
+		float e1 = linear.train(trainingInputs,trainingOutputs,0.01).loss;
+		vassert(e0 == e1);
+	}
+	Vector r = chain[0].apply(trainingInputs[0]);
+	r -= linear.apply(trainingInputs[0]);
+	vassert(r.normSquared() == 0);
+
+	// Two towers joined by add and concat. The weights must not depend on the number of threads.
+	NeuralNetwork towers[3];
+	DenseLayer a(2,8);
+	DenseLayer b(2,8);
+	DenseLayer c(16,8,"tanh");
+	DenseLayer d(8,2);
+	a.randomInit(0.3); b.randomInit(0.3); c.randomInit(0.3); d.randomInit(0.3);
+	towers[0].layers = {&a,&b,&c,&d};
+	towers[1].load(towers[0].serialize());
+	towers[2].load(towers[0].serialize());
+	GraphNetwork graphs[2];
+	for(u32 j = 0;j < 2;j++){
+		GraphNetwork& g = graphs[j];
+		std::vector<Layer*>& ls = towers[j+1].layers;
+		u32 in = g.input(4);
+		u32 left = g.layer(ls[0],g.split(in,0,2));
+		u32 right = g.layer(ls[1],g.split(in,2,2));
+		u32 sum = g.add({left,right});
+		g.layer(ls[3],g.layer(ls[2],g.concat({left,sum})));
+		g.computationCoreCount = j == 0 ? 1 : 4;
+		g.prepare();
+		vassert(g.nodeSize(g.nodeCount() - 1) == 2 && g.depth() == 7);
+	}
+	// small steps: with 0.01, some draws of the samples diverge.
+	float first = graphs[0].loss(trainingInputs,trainingOutputs);
+	float e = 0;
+	for(u32 i = 0;i < 20;i++){
+		seed(i);
+		e = graphs[0].train(trainingInputs,trainingOutputs,0.003).loss;
+		seed(i);
+		vassert(graphs[1].train(trainingInputs,trainingOutputs,0.003).loss == e);
+	}
+	vassert(graphs[0].loss(trainingInputs,trainingOutputs) < first);
+	vassert(graphs[0].loss(trainingInputs,trainingOutputs) == graphs[1].loss(trainingInputs,trainingOutputs));
+
+	debug("PASSED.");
+}
+
+void test_memory_plan(){
+	debug("test_memory_plan");
+	MemoryPlan plan;
+	u32 a = plan.add(1000,0);
+	u32 b = plan.add(500,1);
+	plan.extend(a,1);
+	u32 c = plan.add(1000,2);
+	plan.solve();
+	vassert(plan.offset(a) == plan.offset(c) && plan.offset(b) == 1000);
+	vassert(plan.peak() == 1500 && plan.lowerBound() == 1500 && plan.unshared() == 2500);
+
+	// Buffers alive at the same step never overlap.
+	plan.clear();
+	std::vector<u32> first,last;
+	for(u32 i = 0;i < 200;i++){
+		u32 t1 = randomU32(50),t2 = randomU32(50);
+		first.push_back(min(t1,t2));
+		last.push_back(max(t1,t2));
+		plan.extend(plan.add(1 + randomU32(100),t1),t2);
+	}
+	plan.solve();
+	for(u32 i = 0;i < plan.count();i++){
+		for(u32 j = i + 1;j < plan.count();j++){
+			if(first[i] > last[j] || first[j] > last[i]) continue;
+			vassert(plan.offset(i) + plan.size(i) <= plan.offset(j) || plan.offset(j) + plan.size(j) <= plan.offset(i));
+		}
+	}
+	vassert(plan.peak() >= plan.lowerBound() && plan.peak() <= plan.unshared());
+
+	NeuralNetwork nn;
+	DenseLayer l1(4,64);
+	DenseLayer l2(64,64,"tanh");
+	DenseLayer l3(64,32);
+	DenseLayer l4(32,2);
+	nn.layers = {&l1,&l2,&l3,&l4};
+	nn.prepare();
+	MemoryFootprint f = nn.memoryFootprint();
+	vassert(f.inference == (64 + 64) * sizeof(float)); // two layers alive at a time instead of one buffer per layer
+	vassert(f.parameters == (4*64 + 64 + 64*64 + 64 + 64*32 + 32 + 32*2 + 2) * sizeof(float));
+	vassert(f.training > f.inference && f.training < f.trainingUnshared);
+	// trainParallel: 8 gradient blocks (deterministic mode), then the activations and the two gradients of each of the 4 threads.
+	vassert(f.batch == 8 * f.parameters + 4 * (64 + 64 + 32 + 2 + 4 + 2 * 64) * sizeof(float));
+
+	debug("PASSED.");
+}
+
+void test_profiler(){
+	debug("test_profiler");
+	NeuralNetwork nn;
+	denseStack(nn,{4,16,2});
+	nn.prepare();
+	TestSamples samples(50);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+
+	Profiler profiler;
+	nn.profiler = &profiler;
+	nn.train(trainingInputs,trainingOutputs,0.01);
+	nn.apply(trainingInputs[0]);
+	nn.profiler = 0;
+	nn.train(trainingInputs,trainingOutputs,0.01); // not recorded
+
+	vassert(profiler.layerCount() == 2 && profiler.layerName(0) == "dense 4x16");
+	vassert(profiler.get(0,Profiler::FORWARD).calls == 51 && profiler.get(1,Profiler::FORWARD).calls == 51);
+	vassert(profiler.get(0,Profiler::BACKWARD).calls == 0); // nothing to propagate below the first layer
+	vassert(profiler.get(1,Profiler::BACKWARD).calls == 50 && profiler.get(0,Profiler::UPDATE).calls == 50);
+	vassert(profiler.get(1,Profiler::FORWARD).flops == 51 * ((DenseLayer*)nn.layers[1])->applyFlops());
+	vassert(profiler.get(1,Profiler::BACKWARD).bytes == 0 && profiler.get(0,Profiler::UPDATE).bytes == 0); // the gradients are in the arena
+	vassert(profiler.total(Profiler::FORWARD).nanoseconds > 0);
+
+	std::string json = profiler.json();
+	vassert(json.find("\"name\":\"dense 16x2\"") != std::string::npos && json.find("\"backward\":{\"calls\":50") != std::string::npos);
+	vassert(profiler.table().find("update") != std::string::npos);
+	profiler.reset();
+	vassert(profiler.layerCount() == 0);
+
+	// every thread of loss records in its own shard, they are merged when read.
+	TestSamples many(300);
+	nn.computationCoreCount = 4;
+	nn.prepare();
+	nn.profiler = &profiler;
+	nn.loss(many.inputs,many.outputs);
+	nn.profiler = 0;
+	vassert(profiler.get(0,Profiler::FORWARD).calls == 300 && profiler.get(1,Profiler::FORWARD).calls == 300);
+	vassert(profiler.get(0,Profiler::FORWARD).bytes == 0); // loss evaluates in its scratch memory
+	vassert(allocationTracking == 0);
+
+	debug("PASSED.");
+}
+
+void test_deterministic(){
+	debug("test_deterministic");
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+
+	NeuralNetwork nns[4];
+	denseStack(nns[0],{4,16,8,2},1);
+	for(u32 j = 1;j < 4;j++) nns[j].load(nns[0].serialize());
+
+	// The same weights for 1, 3 and 4 threads, with and without noise, even when the batch is not a multiple of the blocks.
+	const u32 threads[3] = {1,3,4};
+	for(u32 j = 0;j < 3;j++){
+		nns[j].computationCoreCount = threads[j];
+		nns[j].inputNoise = 0.1;
+		nns[j].prepare();
+	}
+	float first = nns[0].loss(trainingInputs,trainingOutputs);
+	for(u32 i = 0;i < 10;i++){
+		if(i == 5){
+			for(u32 j = 0;j < 3;j++) nns[j].inputNoise = 0;
+		}
+		float e = 0;
+		for(u32 j = 0;j < 3;j++){
+			seed(i);
+			float ej = nns[j].trainParallel(trainingInputs,trainingOutputs,0.05,50).loss;
+			if(j == 0) e = ej;
+			vassert(ej == e);
+		}
+	}
+	vassert(nns[0].loss(trainingInputs,trainingOutputs) < first);
+	vassert(nns[0].serialize() == nns[1].serialize() && nns[0].serialize() == nns[2].serialize());
+
+	// With batches of one sample, this is train.
+	NeuralNetwork reference;
+	reference.load(nns[3].serialize());
+	reference.prepare();
+	nns[3].computationCoreCount = 4;
+	nns[3].prepare();
+	for(u32 i = 0;i < 3;i++){
+		seed(i);
+		float e = reference.train(trainingInputs,trainingOutputs,0.01).loss;
+		seed(i);
+		vassert(nns[3].trainParallel(trainingInputs,trainingOutputs,0.01,1).loss == e);
+	}
+	vassert(reference.serialize() == nns[3].serialize());
+
+	debug("PASSED.");
+}
+
+void test_random_stream(){
+	debug("test_random_stream");
+	// Known answers of Philox4x32-10 (Random123).
+	u32 b[4];
+	RandomStream::block(0,0,0,b);
+	vassert(b[0] == 0x6627e8d5 && b[1] == 0xe169c58d && b[2] == 0xbc57ac4c && b[3] == 0x9b00dbd8);
+	RandomStream::block(0xffffffffffffffffULL,0xffffffffffffffffULL,0xffffffffffffffffULL,b);
+	vassert(b[0] == 0x408f276d && b[1] == 0x41c83b0e && b[2] == 0xa20bc7c6 && b[3] == 0x6d5451fd);
+	RandomStream::block(0x299f31d0a4093822ULL,0x85a308d3243f6a88ULL,0x0370734413198a2eULL,b);
+	vassert(b[0] == 0xd16cfe09 && b[1] == 0x94fdcceb && b[2] == 0x5001e420 && b[3] == 0x24126ea1);
+
+	// Bulk fills give the numbers of the one at a time calls, from any position, for any number of threads.
+	const u32 n = 200001;
+	std::vector<u32> bulk(n);
+	std::vector<float> gaussians(n),parallelGaussians(n),uniforms(n);
+	ThreadPool pool(4);
+	for(u32 start : {0,1,3,6}){
+		RandomStream rng(1234,5);
+		rng.seek(start);
+		rng.fillU32(bulk.data(),n);
+		vassert(rng.tell() == start + n);
+		rng.seek(start);
+		rng.fillGaussian(gaussians.data(),n,1,2);
+		rng.seek(start);
+		rng.fillGaussian(parallelGaussians.data(),n,1,2,&pool);
+		rng.seek(start);
+		rng.fillUniform(uniforms.data(),n,-1,1,&pool);
+		RandomStream one(1234,5);
+		for(u32 i = 0;i < 1000;i++){
+			one.seek(start + i * 197);
+			vassert(one.nextU32() == bulk[i * 197]);
+			one.seek(start + i * 197);
+			vassert(one.nextGaussian() * 2 + 1 == gaussians[i * 197]);
+		}
+		vassert(std::memcmp(gaussians.data(),parallelGaussians.data(),n * sizeof(float)) == 0);
+	}
+	double sum = 0,squares = 0,uniformSum = 0;
+	for(u32 i = 0;i < n;i++){
+		sum += gaussians[i];
+		squares += (gaussians[i] - 1) * (gaussians[i] - 1);
+		uniformSum += uniforms[i];
+		vassert(uniforms[i] >= -1 && uniforms[i] < 1);
+	}
+	vassert(std::abs(sum / n - 1) < 0.02 && std::abs(squares / n - 4) < 0.05 && std::abs(uniformSum / n) < 0.01);
+
+	// Streams and keys are independent, splits are reproducible.
+	RandomStream a(1),c(2);
+	RandomStream s1 = a.split(0),s2 = a.split(1);
+	u32 same = 0;
+	for(u32 i = 0;i < 1000;i++){
+		u32 x = s1.nextU32(),y = s2.nextU32(),z = c.nextU32();
+		same += (x == y) + (x == z);
+	}
+	vassert(same == 0 && a.split(1).nextU32() == RandomStream(1).split(1).nextU32());
+
+	std::vector<u32> order(100);
+	for(u32 i = 0;i < 100;i++) order[i] = i;
+	RandomStream(7).shuffle(order.data(),100);
+	std::vector<u32> sorted = order;
+	std::sort(sorted.begin(),sorted.end());
+	for(u32 i = 0;i < 100;i++) vassert(sorted[i] == i);
+
+	// Reproducible initialization of a layer.
+	DenseLayer l1(64,64),l2(64,64);
+	RandomStream init1(99),init2(99);
+	l1.randomInit(init1,0.1);
+	l2.shard(&pool,DenseLayer::SHARD_ROWS);
+	l2.randomInit(init2,0.1);
+	l2.shard(0,DenseLayer::SHARD_NONE);
+	ParameterBlock w1 = l1.parameters()[0],w2 = l2.parameters()[0];
+	vassert(w1.size == 64 * 64 && w1.data[0] != 0 && std::memcmp(w1.data,w2.data,w1.size * sizeof(float)) == 0);
+
+	debug("PASSED.");
+}
+
+void test_global_random(){
+	debug("test_global_random");
+	// seed(value) is the standard initialization of MT19937.
+	std::mt19937 reference(1234);
+	seed(1234);
+	for(u32 i = 0;i < 2000;i++){
+		vassert(randomU32(0xFFFFFFFF) == reference());
+	}
+	// The bulk functions continue the same sequence, across refills and from any index.
+	std::vector<u32> bulk(5000);
+	randomU32s(bulk.data(),1);
+	randomU32s(bulk.data() + 1,bulk.size() - 1);
+	for(u32 x : bulk) vassert(x == reference());
+
+	seed(77);
+	std::vector<float> one(3001),many(3001);
+	for(float& f : one) f = randomFloat();
+	seed(77);
+	randomFloats(many.data(),many.size());
+	vassert(std::memcmp(one.data(),many.data(),one.size() * sizeof(float)) == 0);
+
+	debug("PASSED.");
+}
+
+void test_perlin_grid(){
+	debug("test_perlin_grid");
+	ThreadPool pool(3);
+	// Steps smaller and larger than a cell, negative ones, and a 2D field.
+	const double origins[3][3] = {{-3.7,1.2,0.3},{10.5,-2.25,7},{0.1,0.2,0.5}};
+	const double steps[3][3] = {{0.13,0.21,0.4},{1.7,-0.6,0.05},{-0.07,0.5,0}};
+	const u32 dims[3][3] = {{37,5,4},{9,6,3},{64,16,1}};
+	for(u32 t = 0;t < 3;t++){
+		for(u32 octaves = 1;octaves <= 3;octaves++){
+			const u32 n = dims[t][0] * dims[t][1] * dims[t][2];
+			std::vector<double> grid(n);
+			std::vector<float> floats(n);
+			perlinGrid(origins[t],steps[t],dims[t],octaves,grid.data(),t == 1 ? 0 : &pool);
+			perlinGrid(origins[t],steps[t],dims[t],octaves,floats.data(),t == 1 ? &pool : 0);
+			for(u32 k = 0;k < dims[t][2];k++){
+				for(u32 j = 0;j < dims[t][1];j++){
+					for(u32 i = 0;i < dims[t][0];i++){
+						double expected = 0;
+						for(u32 o = 0;o < octaves;o++){
+							const double f = 1 << o;
+							expected += perlin((origins[t][0] + i * steps[t][0]) * f,(origins[t][1] + j * steps[t][1]) * f,
+								(origins[t][2] + k * steps[t][2]) * f) / f;
+						}
+						const u32 index = (k * dims[t][1] + j) * dims[t][0] + i;
+						vassert(std::abs(grid[index] - expected) < 1e-12);
+						vassert(floats[index] == (float)grid[index]);
+					}
+				}
+			}
+		}
+	}
+	debug("PASSED.");
+}
+
+void test_synthetic_data(){
+	debug("test_synthetic_data");
+	// The batches do not depend on the number of threads, and can be recomputed from their index.
+	ShapeTask shapes(12);
+	SyntheticStream one(shapes,16,5,1,1);
+	SyntheticStream four(shapes,16,5,4,3);
+	SyntheticBatch copy(16,shapes.inputSize(),shapes.outputSize());
+	u32 counts[3] = {0,0,0};
+	for(u32 i = 0;i < 20;i++){
+		SyntheticBatch& a = one.next();
+		SyntheticBatch& b = four.next();
+		vassert(a.index == i && b.index == i);
+		vassert(a.inputData == b.inputData && a.outputData == b.outputData);
+		if(i == 7){
+			one.generate(7,copy);
+			vassert(copy.inputData == a.inputData);
+		}
+		for(u32 s = 0;s < a.size();s++){
+			vassert(a.inputs[s].raw() == a.inputData.data() + s * 144);
+			for(u32 c = 0;c < 3;c++) counts[c] += a.outputs[s].get(c) == 1;
+		}
+	}
+	vassert(counts[0] + counts[1] + counts[2] == 20 * 16 && counts[0] > 50 && counts[1] > 50 && counts[2] > 50);
+
+	NoiseTextureTask textures(8,3);
+	SyntheticStream noise(textures,4,1);
+	SyntheticBatch& t = noise.next();
+	vassert(t.inputData.size() == 4 * 64 && t.outputs[0].normSquared() == 1);
+
+	// Learn a linear target from the stream, like test_network but without building a dataset.
+	PolynomialTask linear(3,1,1,9);
+	linear.coefficients = {3,5,0};
+	linear.bias = {0};
+	SyntheticStream stream(linear,50,2);
+	NeuralNetwork nn;
+	DenseLayer l1(3,4);
+	DenseLayer l2(4,1);
+	l1.randomInit(0.3); l2.randomInit(0.3);
+	nn.layers = {&l1,&l2};
+	nn.prepare();
+	float first = stream.train(nn,10,0.01).loss;
+	float last = 0;
+	for(u32 i = 0;i < 20;i++){
+		last = stream.train(nn,10,0.01).loss;
+	}
+	vassert(last < first / 10);
+
+	debug("PASSED.");
+}
+
+static std::string int128String(__int128 v){
+	if(v == 0) return "0";
+	bool negative = v < 0;
+	unsigned __int128 m = negative ? -(unsigned __int128)v : v;
+	std::string s;
+	for(;m > 0;m /= 10) s += char('0' + (int)(m % 10));
+	if(negative) s += '-';
+	std::reverse(s.begin(),s.end());
+	return s;
+}
+
+void test_bigint(){
+	debug("test_bigint");
+	// Against 128 bit arithmetic, with carries across the limbs and every sign.
+	RandomStream rng(11);
+	for(u32 i = 0;i < 1000;i++){
+		long long a = (long long)(((uint64_t)rng.nextU32() << 32) | rng.nextU32()) >> (i % 40);
+		long long b = (long long)(((uint64_t)rng.nextU32() << 32) | rng.nextU32()) >> (i % 23);
+		Bigint x(a),y(b);
+		vassert(to_string(x + y) == int128String((__int128)a + b));
+		vassert(to_string(x - y) == int128String((__int128)a - b));
+		vassert(to_string(x * y) == int128String((__int128)a * b));
+		vassert(to_string(x * b) == int128String((__int128)a * b));
+		vassert((x < y) == (a < b) && (x == y) == (a == b) && (x >= y) == (a >= b));
+		Bigint z = x;
+		z += (long long)(b & 0xffffff);
+		vassert(to_string(z) == int128String((__int128)a + (b & 0xffffff)));
+	}
+
+	// Decimal input and output, across several limbs.
+	std::string digits = "-";
+	for(u32 i = 0;i < 200;i++) digits += char('1' + rng.nextU32(8));
+	Bigint big(digits);
+	vassert(to_string(big) == digits && big.digits() == 200 && big.limbCount() == 11);
+	vassert(to_string(Bigint("-0")) == "0" && to_string(Bigint("1000000000000000000000")) == "1000000000000000000000");
+	vassert(Bigint("10000000000000000000000").trailing_zeros() == 22);
+	vassert(to_string(factorial(30)) == "265252859812191058636308480000000");
+	vassert(factorial(100).trailing_zeros() == 24 && factorial(100).digits() == 158);
+	// digits and trailing_zeros around every power of ten, and on a number much longer than its zeros.
+	Bigint power = 1;
+	for(int k = 0;k < 400;k++){
+		Bigint below = power + -1;
+		vassert(power.digits() == k + 1 && (power * -3).digits() == k + 1 && (k == 0 || below.digits() == k));
+		vassert(power.trailing_zeros() == k && (power * 70).trailing_zeros() == k + 1 && (k == 0 || below.trailing_zeros() == 0));
+		power *= 10;
+	}
+	Bigint twos = 2,fives = 5;
+	twos.pow(280);
+	fives.pow(300);
+	vassert(twos.trailing_zeros() == 0 && fives.trailing_zeros() == 0 && (twos * fives).trailing_zeros() == 280);
+	vassert((twos * fives * 4).trailing_zeros() == 282 && (twos * fives * 125).trailing_zeros() == 280);
+	Bigint f = factorial(3000);
+	vassert(f.digits() == (int)to_string(f).size() && f.trailing_zeros() == 748);
+	vassert(Bigint::rangeProduct(5,4) == 1 && Bigint::rangeProduct(1000,3) == 1); // empty ranges
+	vassert(Bigint::rangeProduct(0,0) == 0 && Bigint::rangeProduct(0,200) == 0);
+	vassert(Bigint::rangeProduct(~0ull,~0ull) == Bigint("18446744073709551615") && Bigint::rangeProduct(3,5) == 60);
+
+	// Identities on large values.
+	Bigint c = factorial(120);
+	vassert((big + c) - c == big && (big - c) + c == big);
+	vassert(big * c == c * big && (big * c) * -1 == abs(big) * c);
+	Bigint sum = 0;
+	for(u32 i = 0;i < 100;i++) sum += c;
+	vassert(sum == c * 100 && sum > c && Bigint(0) - sum < Bigint(0) - c);
+	// The fast multiplications against the schoolbook one, balanced and not, with thresholds low enough
+	// to recurse several times.
+	const size_t karatsuba = Bigint::karatsubaThreshold,toom = Bigint::toomThreshold;
+	for(u32 i = 0;i < 40;i++){
+		std::string x = "1",y = "1";
+		u32 xd = 1 + rng.nextU32(3000),yd = i % 2 ? xd : 1 + rng.nextU32(3000);
+		for(u32 j = 0;j < xd;j++) x += char('0' + rng.nextU32(9));
+		for(u32 j = 0;j < yd;j++) y += char(i % 5 ? '0' + rng.nextU32(9) : '9'); // all nines, for the carries
+		Bigint bx(x),by(y);
+		Bigint::karatsubaThreshold = Bigint::toomThreshold = 1000000;
+		Bigint expected = bx * by;
+		Bigint::karatsubaThreshold = 2;
+		Bigint::toomThreshold = i % 3 ? 1000000 : 5;
+		vassert(bx * by == expected);
+		Bigint::karatsubaThreshold = 4 + i;
+		Bigint::toomThreshold = 10 + i;
+		vassert(bx * by == expected && (bx * by).limbCount() == expected.limbCount());
+	}
+	Bigint::karatsubaThreshold = karatsuba;
+	Bigint::toomThreshold = toom;
+
+	// The transforms against Toom-3, squares included, on one thread and on a pool.
+	const size_t ntt = Bigint::nttThreshold;
+	ThreadPool pool(3);
+	for(u32 i = 0;i < 12;i++){
+		std::string x = "1",y = "1";
+		u32 xd = 1 + rng.nextU32(40000),yd = 1 + rng.nextU32(i % 2 ? 40000 : 400);
+		for(u32 j = 0;j < xd;j++) x += char(i % 3 ? '0' + rng.nextU32(9) : '9');
+		for(u32 j = 0;j < yd;j++) y += char('0' + rng.nextU32(9));
+		Bigint bx(x),by(y);
+		Bigint::nttThreshold = 1000000;
+		Bigint expected = bx * by,square = bx * bx;
+		Bigint::nttThreshold = 2;
+		Bigint::pool = i % 2 ? &pool : 0;
+		vassert(bx * by == expected && bx * bx == square);
+	}
+	Bigint::nttThreshold = ntt;
+	Bigint::pool = 0;
+
+	vassert(to_string(binomial(100,50)) == "100891344545564193334812497256" && binomial(10,11) == 0 && binomial(7,0) == 1);
+	vassert(binomial(3000,1234) * factorial(1234) * factorial(1766) == factorial(3000));
+
+	// Long numbers are read by halves, not one chunk at a time.
+	std::string longDigits = "-";
+	for(u32 i = 0;i < 30000;i++) longDigits += i == 0 ? '1' : i % 7 == 0 ? '9' : '0';
+	vassert(to_string(Bigint(longDigits)) == longDigits && Bigint(longDigits.substr(0,20000)) < Bigint(longDigits.substr(0,19999)));
+	vassert(Bigint("000" + longDigits.substr(1)) == abs(Bigint(longDigits)));
+	Bigint slow = 1;
+	for(int i = 2;i <= 3000;i++) slow *= i;
+	vassert(factorial(3000) == slow);
+
+	Bigint two = 2;
+	vassert(two.pow(200) == Bigint(1LL << 50).pow(4) && to_string(Bigint(3).pow(40)) == "12157665459056928801");
+
+	debug("PASSED.");
+}
+
+void test_evolution(){
+	debug("test_evolution");
+	NeuralNetwork nn;
+	denseStack(nn,{4,8,2});
+	NeuralNetwork replay;
+	replay.load(nn.serialize());
+
+	TestSamples samples(100);
+	std::vector<Vector>& trainingInputs = samples.inputs;
+	std::vector<Vector>& trainingOutputs = samples.outputs;
+	const float before = nn.loss(trainingInputs,trainingOutputs);
+
+	EvolutionStrategy es(nn);
+	es.population = 32;
+	es.sigma = 0.05;
+	es.learningRate = 0.05;
+	EvolutionStrategy other(replay,1);
+	other.sigma = es.sigma;
+	other.learningRate = es.learningRate;
+	for(u32 i = 0;i < 30;i++){
+		es.train(trainingInputs,trainingOutputs);
+		other.update(es.lastSamples); // only the seeds and the fitnesses are needed.
+	}
+	vassert(nn.loss(trainingInputs,trainingOutputs) < before);
+	Vector d = nn.apply(trainingInputs[0]);
+	d -= replay.apply(trainingInputs[0]);
+	vassert(d.normSquared() == 0);
+
+	debug("PASSED.");
+}
+
+void test_file(){
+	std::string p = getExecutableFolderPath();
+	ImageReader ir(getExecutableFolderPath() + "/example2.png");
+	for(u32 x = 0;x < ir.getWidth();x++){
+		for(u32 y = 0;y < min(30,ir.getHeight());y++){
+			ir.setPixelAtPos(x,y,0,255);
+		}
+	}
+	ir.save(p+"/edited.png");
+	debug("PASSED.");
+}
+
+u32 getBytesAsInt(File& f){
+	u32 r = f.nextChar()<<24;
+	r += f.nextChar()<<16;
+	r += f.nextChar()<<8;
+	r += f.nextChar();
+	return r;
+}
+
+void test_mnist(){
+	// a complete test of file reading and neural network: digit recognition
+
+	File file_images(getExecutableFolderPath() + "/training_data/train-images.idx3-ubyte");
+	File file_labels(getExecutableFolderPath() + "/training_data/train-labels.idx1-ubyte");
+
+	// the first 4 bytes of each file are:
+	// 0x00000801 (magic number)
+	// after that there are 4 bytes for the number of items
+
+	// inside images, after that, there is the size of width of the images
+	// than, there are the images, with 1 byte = 1 pixel (black+white, row-wise) and for the labels, 1 byte = 1 label
+
+	vassert(getBytesAsInt(file_images) == 0x803);
+	vassert(getBytesAsInt(file_labels) == 0x801);
+	const u32 item_count = getBytesAsInt(file_images);
+	vassert(item_count == getBytesAsInt(file_labels));
+	vassert(item_count > 0);
+
+	const u32 image_width = getBytesAsInt(file_images);
+	const u32 image_height = getBytesAsInt(file_images);
+
+	vassert(image_width == image_height && image_width > 0 && image_width < 300);
+
+	// alright, now we can access the training data !
+	std::vector<Vector> labels;
+	std::vector<Vector> images;
+
+	debug("Image file size: %i",file_images.size());
+
+	for(u32 i = 0;i < item_count;i++){
+		Vector label(10); // one for every digit
+		label.fill(0);
+
+		int c = file_labels.nextChar();
+		label.at(c) = 1;
+		labels.push_back(label);
+
+		Vector image(image_width * image_height);
+		for(u32 j = 0;j < image_width * image_height;j++){
+			int pixel = file_images.nextChar();
+			image.at(j) = (float)(pixel) / 255.;
+		}
+		images.push_back(image);
+
+	}
+	debug("Training data loaded: %i items, image size: %i x %i",item_count,image_width,image_width);
+
+	NeuralNetwork nn;
+	ConvLayer cl1(image_width*image_height,2,8,8); cl1.randomInit(2,1);
+	ConvLayer cl2(image_width*image_height / 4,2,8,8); cl2.randomInit(2,1);
+	DenseLayer l3(image_width*image_height / 16,30); l3.randomInit(3); // size reducted to "only" 49 parameters
+	DenseLayer l4(30,10); l4.randomInit(3);
+	SoftMaxLayer l5(10);
+
+	nn.layers.push_back(&cl1);
+	nn.layers.push_back(&cl2);
+	nn.layers.push_back(&l3);
+	nn.layers.push_back(&l4);
+	//
+	nn.prepare();
+
+	debug("Loss: %.6f",nn.loss(images,labels));
+
+	EpochStats stats = nn.train(images,labels,0.001); // train once, then add the softmax layer.
+	debug("Loss (presoft, during training): %.6f",stats.loss);
+
+	// You can train your network, edit it and retrain it afterwards !
+	nn.layers.push_back(&l5); // softmax and cross entropy MUST be used together. Training will fail if you just use cross entropy alone.
+	nn.errorFunction = crossEntropyErrorFn;
+	nn.errorFunctionGradient = crossEntropyErrorDerivative;
+	nn.computeAccuracy = true;
+	nn.prepare();
+
+	debug("Loss (postsoft): %.6f",nn.loss(images,labels)); // we loss a bit of loss as the goal changes a bit.
+
+	for(u32 i = 0;i < 3;i++){
+		stats = nn.train(images,labels,0.001);
+		debug("Loss: %.6f, accuracy: %.3f",stats.loss,stats.accuracy);
+	}
+
+
+	// kernels used:
+	debug("Kernels: ");
+	cl1.getKernel().print();
+	cl2.getKernel().print();
+
+	debug("PASSED.");
+
+}
+void test_http(){
+	constexpr u32 rounds = 1'000'000;
+
+
+}
+
+
+int main(int argc,char ** argv){
+	utf8_console();
+	setup_crash_handler();
+	debug("Starting tests ...");
+	test_matrix();
+	test_serialization();
+	test_epoch_stats();
+	test_checkpoint();
+	test_optimizer_checkpoint();
+	test_gradient_checkpointing();
+	test_pipeline();
+	test_thread_pool();
+	test_sharding();
+	test_distributed();
+	test_parameter_server();
+	test_compression();
+	test_local_sgd();
+	test_evolution();
+	test_graph();
+	test_memory_plan();
+	test_profiler();
+	test_deterministic();
+	test_random_stream();
+	test_global_random();
+	test_perlin_grid();
+	test_synthetic_data();
+	test_bigint();
+	//test_network();
+	//test_file();
+	test_mnist();
+	//test_http();
+
+	debug("All tests passed.");
+
+}
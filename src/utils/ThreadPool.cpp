@@ -0,0 +1,143 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+#include "ThreadPool.h"
+
+namespace vio{
+
+// Chunks running on this thread, innermost first: a nested call on a pool already in the list reuses its worker index.
+struct ActiveChunk{
+	const ThreadPool * pool;
+	u32 worker;
+	ActiveChunk * outer;
+};
+static thread_local ActiveChunk * activeChunks = 0;
+
+// Marks the scope of a chunk of pool running as worker on this thread.
+struct ChunkScope{
+	ActiveChunk entry;
+	ChunkScope(const ThreadPool * pool,u32 worker){
+		entry = {pool,worker,activeChunks};
+		activeChunks = &entry;
+	}
+	~ChunkScope(){
+		activeChunks = entry.outer;
+	}
+};
+
+static ActiveChunk * findChunk(const ThreadPool * pool){
+	for(ActiveChunk * c = activeChunks;c != 0;c = c->outer){
+		if(c->pool == pool) return c;
+	}
+	return 0;
+}
+
+ThreadPool::ThreadPool(u32 threadCount) : nextChunk(0){
+	if(threadCount == 0) threadCount = 1;
+	for(u32 i = 1;i < threadCount;i++){
+		threads.push_back(std::thread(&ThreadPool::workerLoop,this,i));
+	}
+}
+ThreadPool::~ThreadPool(){
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(std::thread& t : threads){
+		t.join();
+	}
+}
+u32 ThreadPool::size(){
+	return threads.size() + 1;
+}
+bool ThreadPool::insideParallelFor(){
+	return activeChunks != 0;
+}
+
+void ThreadPool::runChunks(u32 worker){
+	const u32 chunks = (jobCount + jobGrain - 1) / jobGrain;
+	ChunkScope scope(this,worker);
+	if(jobPinned){
+		if(worker < jobCount) (*job)(worker,worker + 1,worker);
+		return;
+	}
+	while(true){
+		u32 c = nextChunk.fetch_add(1);
+		if(c >= chunks) break;
+		u32 begin = c * jobGrain;
+		u32 end = begin + jobGrain < jobCount ? begin + jobGrain : jobCount;
+		(*job)(begin,end,worker);
+	}
+}
+
+void ThreadPool::workerLoop(u32 worker){
+	u32 seen = 0;
+	std::unique_lock<std::mutex> guard(lock);
+	while(true){
+		wake.wait(guard,[&]{ return stopping || generation != seen; });
+		if(stopping) return;
+		seen = generation;
+		guard.unlock();
+		runChunks(worker);
+		guard.lock();
+		busy--;
+		if(busy == 0) done.notify_all();
+	}
+}
+
+void ThreadPool::runInline(u32 count,u32 grain,const std::function<void(u32,u32,u32)>& fn,u32 worker){
+	for(u32 begin = 0;begin < count;begin += grain){
+		fn(begin,begin + grain < count ? begin + grain : count,worker);
+	}
+}
+
+void ThreadPool::parallelFor(u32 count,u32 grain,const std::function<void(u32,u32,u32)>& fn){
+	run(count,grain,fn,false);
+}
+
+void ThreadPool::forEachWorker(const std::function<void(u32)>& fn){
+	run(size(),1,[&](u32 begin,u32 end,u32 worker){ fn(begin); },true);
+}
+
+void ThreadPool::run(u32 count,u32 grain,const std::function<void(u32,u32,u32)>& fn,bool pinned){
+	if(count == 0) return;
+	if(grain == 0) grain = 1;
+	if(ActiveChunk * outer = findChunk(this)){
+		// nested inside a chunk of this pool: run inline, as the worker of that chunk.
+		ChunkScope scope(this,outer->worker);
+		runInline(count,grain,fn,outer->worker);
+		return;
+	}
+	if(threads.size() == 0 || insideParallelFor() || count <= grain){
+		// nothing to split (or already inside a parallel loop of another pool): run inline as worker 0.
+		// Worker 0 is the calling thread of a parallelFor, so this must wait for the current call to finish.
+		std::lock_guard<std::mutex> call(callLock);
+		ChunkScope scope(this,0);
+		runInline(count,grain,fn,0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> call(callLock);
+	std::unique_lock<std::mutex> guard(lock);
+	job = &fn;
+	jobCount = count;
+	jobGrain = grain;
+	jobPinned = pinned;
+	nextChunk.store(0);
+	busy = threads.size();
+	generation++;
+	guard.unlock();
+	wake.notify_all();
+
+	runChunks(0);
+
+	guard.lock();
+	done.wait(guard,[this]{ return busy == 0; });
+	job = 0;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: vanyle
+ */
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "utils/utils.h"
+
+namespace vio{
+
+/**
+A fixed set of threads used to split loops across cores.
+The thread calling parallelFor also does some of the work, so a pool of size 1 has no extra thread and runs everything inline.
+
+parallelFor called from inside a parallelFor (on the same pool or another one) runs serially on the calling thread,
+so layers can use the pool without caring about who calls them.
+Nested inside a chunk of the same pool, it keeps the worker index of that chunk.
+Otherwise it runs as worker 0 once the pool is free, so two pools must not call each other from their chunks.
+
+@code
+ThreadPool pool(4);
+std::vector<float> v(1000000);
+pool.parallelFor(v.size(),4096,[&](u32 begin,u32 end,u32 worker){
+	for(u32 i = begin;i < end;i++) v[i] = i;
+});
+@endcode
+*/
+class ThreadPool{
+private:
+	std::vector<std::thread> threads;
+	std::mutex callLock; // one parallelFor at a time
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	// current job
+	const std::function<void(u32,u32,u32)> * job = 0;
+	u32 jobCount = 0;
+	u32 jobGrain = 1;
+	bool jobPinned = false; // chunk i runs on worker i (forEachWorker)
+	std::atomic<u32> nextChunk;
+	u32 generation = 0;
+	u32 busy = 0; // helper threads still working on the current job
+	bool stopping = false;
+
+	void workerLoop(u32 worker);
+	void runChunks(u32 worker);
+	void runInline(u32 count,u32 grain,const std::function<void(u32,u32,u32)>& fn,u32 worker);
+	void run(u32 count,u32 grain,const std::function<void(u32,u32,u32)>& fn,bool pinned);
+public:
+	ThreadPool(u32 threadCount); // threadCount includes the calling thread.
+	ThreadPool(ThreadPool& p) = delete;
+	ThreadPool& operator=(const ThreadPool& p) = delete;
+	~ThreadPool();
+
+	u32 size();
+
+	// Calls fn(begin,end,worker) on chunks of at most grain indices covering [0,count) and waits for all of them.
+	// worker is in [0,size()), two chunks with the same worker never run at the same time on different threads.
+	// Calls from different threads are serialized.
+	void parallelFor(u32 count,u32 grain,const std::function<void(u32 begin,u32 end,u32 worker)>& fn);
+	// Calls fn(i) once for every i in [0,size()) and waits. fn(i) always runs on the thread of worker i, so that
+	// the data of i stays in the cache of the same core from one call to the next. Inside a parallelFor, runs inline.
+	void forEachWorker(const std::function<void(u32 index)>& fn);
+
+	static bool insideParallelFor(); // true on a thread currently running a chunk.
+};
+
+}
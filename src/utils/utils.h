@@ -1,59 +1,77 @@
-#pragma once
-// everybody imports this. More or less.
-
-#include <cstdint>
-#include <cstdio>
-#include <chrono>
-
-typedef unsigned int u32;
-typedef int i32;
-
-// 32 bit friendly code if possible. 
-//typedef u64 uint64_t;
-//typedef i64 int64_t;
-
-#ifndef NDEBUG
-#include "vcrash.h"
-
-#define debug(str,args...) { printf(str,## args); printf("\n");fflush(stdout); }
-#define vassert(cond){ \
-    if(!(cond)){ \
-        fprintf(stderr,"ASSERTION FAILED in %s at line: %d\n",__FILE__,__LINE__); \
-        fprintf(stderr,"%s",#cond); \
-        fprintf(stderr,"\n"); \
-        fflush(stderr); \
-        stack_trace(false,false); \
-        exit(3); \
-    } \
-}
-#define vpanic(str,args...) { \
-    fprintf(stderr,"PANIC in %s at line: %d\n",__FILE__,__LINE__); \
-    fprintf(stderr,str,## args); \
-    fprintf(stderr,"\n"); \
-    fflush(stderr); \
-    stack_trace(false,false); \
-    exit(2); \
-}
-
-#else
-
-#define debug(str,args...){}
-#define vassert(cond){}
-#define vpanic(str,args...){}
-
-#endif
-
-#include <utility> // std::forward
-
-namespace vio{
-
-	template <typename F, typename ... Ts>
-	void time_function(const char * name,F&& f, Ts&&...args){
-		std::clock_t start = std::clock();
-		std::forward<F>(f)(std::forward<Ts>(args)...);
-		debug("Time taken by %s: %.3f ms",name,static_cast<double>(std::clock() - start));
-	}
-
-	void utf8_console();
-
-}
+#pragma once
+// everybody imports this. More or less.
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <atomic>
+
+typedef unsigned int u32;
+typedef int i32;
+
+// 32 bit friendly code if possible. 
+//typedef u64 uint64_t;
+//typedef i64 int64_t;
+
+#ifndef NDEBUG
+#include "vcrash.h"
+
+#define debug(str,args...) { printf(str,## args); printf("\n");fflush(stdout); }
+#define vassert(cond){ \
+    if(!(cond)){ \
+        fprintf(stderr,"ASSERTION FAILED in %s at line: %d\n",__FILE__,__LINE__); \
+        fprintf(stderr,"%s",#cond); \
+        fprintf(stderr,"\n"); \
+        fflush(stderr); \
+        stack_trace(false,false); \
+        exit(3); \
+    } \
+}
+#define vpanic(str,args...) { \
+    fprintf(stderr,"PANIC in %s at line: %d\n",__FILE__,__LINE__); \
+    fprintf(stderr,str,## args); \
+    fprintf(stderr,"\n"); \
+    fflush(stderr); \
+    stack_trace(false,false); \
+    exit(2); \
+}
+
+#else
+
+#define debug(str,args...){}
+#define vassert(cond){}
+#define vpanic(str,args...){}
+
+#endif
+
+#include <utility> // std::forward
+
+namespace vio{
+
+	template <typename F, typename ... Ts>
+	void time_function(const char * name,F&& f, Ts&&...args){
+		auto start = std::chrono::steady_clock::now();
+		std::forward<F>(f)(std::forward<Ts>(args)...);
+		std::chrono::duration<double,std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		debug("Time taken by %s: %.3f ms",name,elapsed.count());
+	}
+
+	// Buffers allocated by Vector and Matrix on the calling thread while allocationTracking > 0.
+	// Read it before and after some code to know how much it allocated (see ml/Profiler.h).
+	struct AllocationCounter{
+		uint64_t count = 0;
+		uint64_t bytes = 0;
+	};
+	extern thread_local AllocationCounter threadAllocations;
+	// Number of measures in progress (Profiler::Scope). When 0, allocations cost a relaxed load and the thread_local is not touched.
+	extern std::atomic<u32> allocationTracking;
+
+	inline void countAllocation(uint64_t bytes){
+		if(allocationTracking.load(std::memory_order_relaxed) == 0) return;
+		threadAllocations.count++;
+		threadAllocations.bytes += bytes;
+	}
+
+	void utf8_console();
+
+}